@@ -0,0 +1,356 @@
+///////////////////////////////////////////////////////////////////////////////
+// batchrenderer.cpp
+// ============
+// render a list of camera poses offscreen and save each view as a PNG
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BatchRenderer.h"
+#include "PngWriter.h"
+#include "StateCache.h"
+#include "Trace.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// views that can be in flight between rendering and readback
+	const int READBACK_RING_SIZE = 3;
+	// encoding threads used when the core count is unknown
+	const int DEFAULT_ENCODER_THREADS = 2;
+}
+
+/***********************************************************
+ *  BatchRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BatchRenderer::BatchRenderer(ViewManager* pViewManager, SceneManager* pSceneManager)
+{
+	m_pViewManager = pViewManager;
+	m_pSceneManager = pSceneManager;
+	m_pSoftwareRasterizer = NULL;
+	m_width = 0;
+	m_height = 0;
+	m_maxQueuedJobs = 0;
+	m_bStopEncoders = false;
+	m_failedWrites = 0;
+}
+
+/***********************************************************
+ *  ~BatchRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+BatchRenderer::~BatchRenderer()
+{
+	StopEncoders();
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for rendering every passed in pose
+ *  and saving the views as numbered PNG files. The ring of
+ *  pixel buffers lets view N be copied while the next
+ *  views render, and the encoder threads let the PNG work
+ *  overlap both.
+ ***********************************************************/
+bool BatchRenderer::Run(const std::vector<CAMERA_KEYFRAME>& poses, const std::string& outputPrefix)
+{
+	OffscreenTarget* pTarget = m_pViewManager->GetOffscreenTarget();
+	if (pTarget == NULL)
+	{
+		std::cout << "Batch rendering needs an offscreen render target" << std::endl;
+		return false;
+	}
+
+	m_width = pTarget->GetWidth();
+	m_height = pTarget->GetHeight();
+	if (m_pSoftwareRasterizer != NULL)
+	{
+		m_width = m_pSoftwareRasterizer->GetWidth();
+		m_height = m_pSoftwareRasterizer->GetHeight();
+	}
+	m_outputPrefix = outputPrefix;
+	m_failedWrites = 0;
+
+	// one pixel buffer per view in flight, the software path needs none
+	m_readbackSlots.resize((m_pSoftwareRasterizer == NULL) ? READBACK_RING_SIZE : 0);
+	for (READBACK_SLOT& slot : m_readbackSlots)
+	{
+		glGenBuffers(1, &slot.pixelBuffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixelBuffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(m_width) * m_height * 4, NULL, GL_STREAM_READ);
+		slot.fence = 0;
+		slot.viewIndex = -1;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	int encoderThreads = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+	if (encoderThreads < 1)
+	{
+		encoderThreads = DEFAULT_ENCODER_THREADS;
+	}
+	StartEncoders(encoderThreads);
+
+	m_pViewManager->EnableUserInput(false);
+	double startTime = glfwGetTime();
+
+	for (int viewIndex = 0; viewIndex < static_cast<int>(poses.size()); viewIndex++)
+	{
+		TRACE_ZONE("BatchView");
+
+		// the slot still holds the view from a full ring ago, which
+		// has had the time of the views since then to finish copying
+		READBACK_SLOT* pSlot = NULL;
+		if (m_pSoftwareRasterizer == NULL)
+		{
+			pSlot = &m_readbackSlots[viewIndex % READBACK_RING_SIZE];
+			if (pSlot->viewIndex >= 0)
+			{
+				FinishReadback(*pSlot);
+			}
+		}
+
+		const CAMERA_KEYFRAME& pose = poses[viewIndex];
+		m_pViewManager->SetCameraPose(pose.position, pose.front, pose.zoom);
+		if (pose.bOrthographic != m_pViewManager->IsOrthographic())
+		{
+			if (pose.bOrthographic == true)
+			{
+				m_pViewManager->SetOrthographic();
+			}
+			else
+			{
+				m_pViewManager->SetPerspective();
+			}
+		}
+
+		{
+			TRACE_ZONE("RenderScene");
+			if (m_pSoftwareRasterizer == NULL)
+			{
+				StateCache::Enable(GL_DEPTH_TEST);
+				StateCache::ClearColor(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			}
+			m_pViewManager->PrepareSceneView();
+			m_pSceneManager->RenderScene();
+		}
+
+		if (pSlot != NULL)
+		{
+			StartReadback(*pSlot, viewIndex);
+		}
+		else
+		{
+			// the software image is complete once Render returns
+			m_pSoftwareRasterizer->Render();
+
+			ENCODE_JOB job;
+			const unsigned char* pPixels = m_pSoftwareRasterizer->GetPixels();
+			job.pixels.assign(pPixels, pPixels + static_cast<size_t>(m_width) * m_height * 4);
+			QueueEncodeJob(job, viewIndex);
+		}
+	}
+
+	// collect the views still in the ring, oldest first
+	for (size_t i = 0; i < m_readbackSlots.size(); i++)
+	{
+		READBACK_SLOT& slot = m_readbackSlots[(poses.size() + i) % m_readbackSlots.size()];
+		if (slot.viewIndex >= 0)
+		{
+			FinishReadback(slot);
+		}
+	}
+	StopEncoders();
+
+	for (READBACK_SLOT& slot : m_readbackSlots)
+	{
+		glDeleteBuffers(1, &slot.pixelBuffer);
+	}
+	m_readbackSlots.clear();
+
+	double elapsedTime = glfwGetTime() - startTime;
+	std::cout << "INFO: Batch rendered " << poses.size() << " views in " << elapsedTime * 1000.0
+		<< " ms (" << poses.size() / std::max(elapsedTime, 0.001) << " views/s)" << std::endl;
+
+	if (m_failedWrites > 0)
+	{
+		std::cout << "Could not write " << m_failedWrites << " batch images to " << outputPrefix << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  StartReadback()
+ *
+ *  This method is used for queueing the copy of the
+ *  rendered view into the slot pixel buffer. The copy runs
+ *  on the GPU, the fence marks when it has finished.
+ ***********************************************************/
+void BatchRenderer::StartReadback(READBACK_SLOT& slot, int viewIndex)
+{
+	TRACE_ZONE("StartReadback");
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixelBuffer);
+	glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.viewIndex = viewIndex;
+
+	// make sure the fence reaches the GPU before anyone waits on it
+	glFlush();
+}
+
+/***********************************************************
+ *  FinishReadback()
+ *
+ *  This method is used for waiting until the slot copy has
+ *  finished and queueing its pixels for PNG encoding.
+ ***********************************************************/
+void BatchRenderer::FinishReadback(READBACK_SLOT& slot)
+{
+	TRACE_ZONE("FinishReadback");
+
+	ENCODE_JOB job;
+	int viewIndex = slot.viewIndex;
+	job.pixels.resize(static_cast<size_t>(m_width) * m_height * 4);
+
+	glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+	glDeleteSync(slot.fence);
+	slot.fence = 0;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixelBuffer);
+	const void* pMapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+		static_cast<GLsizeiptr>(job.pixels.size()), GL_MAP_READ_BIT);
+	if (pMapped != NULL)
+	{
+		memcpy(job.pixels.data(), pMapped, job.pixels.size());
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	else
+	{
+		m_failedWrites++;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot.viewIndex = -1;
+
+	if (pMapped != NULL)
+	{
+		QueueEncodeJob(job, viewIndex);
+	}
+}
+
+/***********************************************************
+ *  QueueEncodeJob()
+ *
+ *  This method is used for naming the image of a view and
+ *  queueing its pixels for PNG encoding. The queue is
+ *  bounded, so rendering waits when the encoders fall
+ *  behind instead of using up memory.
+ ***********************************************************/
+void BatchRenderer::QueueEncodeJob(ENCODE_JOB& job, int viewIndex)
+{
+	char number[16];
+	snprintf(number, sizeof(number), "%05d", viewIndex);
+	job.filename = m_outputPrefix + number + ".png";
+
+	std::unique_lock<std::mutex> lock(m_jobsMutex);
+	m_jobsChanged.wait(lock, [this]() { return m_jobs.size() < m_maxQueuedJobs; });
+	m_jobs.push_back(std::move(job));
+	m_jobsChanged.notify_all();
+}
+
+/***********************************************************
+ *  StartEncoders()
+ *
+ *  This method is used for starting the PNG encoding
+ *  threads.
+ ***********************************************************/
+void BatchRenderer::StartEncoders(int threadCount)
+{
+	m_bStopEncoders = false;
+	m_maxQueuedJobs = static_cast<size_t>(threadCount) * 2;
+	for (int i = 0; i < threadCount; i++)
+	{
+		m_encoders.emplace_back(&BatchRenderer::EncodeJobs, this);
+	}
+}
+
+/***********************************************************
+ *  StopEncoders()
+ *
+ *  This method is used for letting the encoding threads
+ *  finish the queued jobs and waiting for them to exit.
+ ***********************************************************/
+void BatchRenderer::StopEncoders()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_jobsMutex);
+		m_bStopEncoders = true;
+	}
+	m_jobsChanged.notify_all();
+
+	for (std::thread& encoder : m_encoders)
+	{
+		encoder.join();
+	}
+	m_encoders.clear();
+}
+
+/***********************************************************
+ *  EncodeJobs()
+ *
+ *  This method is used by each encoding thread for turning
+ *  the queued pixels into PNG files until it is stopped.
+ ***********************************************************/
+void BatchRenderer::EncodeJobs()
+{
+	std::vector<unsigned char> image(static_cast<size_t>(m_width) * m_height * 3);
+
+	while (true)
+	{
+		ENCODE_JOB job;
+		{
+			std::unique_lock<std::mutex> lock(m_jobsMutex);
+			m_jobsChanged.wait(lock, [this]() { return (m_jobs.empty() == false) || m_bStopEncoders; });
+			if (m_jobs.empty() == true)
+			{
+				return;
+			}
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+		m_jobsChanged.notify_all();
+
+		TRACE_ZONE("EncodePNG");
+
+		// flip to top row first and drop the alpha channel
+		for (int y = 0; y < m_height; y++)
+		{
+			const unsigned char* source = &job.pixels[static_cast<size_t>(m_height - 1 - y) * m_width * 4];
+			unsigned char* destination = &image[static_cast<size_t>(y) * m_width * 3];
+			for (int x = 0; x < m_width; x++)
+			{
+				destination[x * 3 + 0] = source[x * 4 + 0];
+				destination[x * 3 + 1] = source[x * 4 + 1];
+				destination[x * 3 + 2] = source[x * 4 + 2];
+			}
+		}
+
+		if (PngWriter::Write(job.filename.c_str(), m_width, m_height, 3, image.data()) == false)
+		{
+			m_failedWrites++;
+		}
+	}
+}
@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////////
+// batchrenderer.h
+// ============
+// render a list of camera poses offscreen and save each view as a PNG
+//
+//  Pixels are read back through a ring of pixel buffer objects. Each read
+//  is fenced and only mapped when the ring comes around again, so the copy
+//  of view N overlaps the rendering of the next views. PNG encoding runs on
+//  worker threads. With a software rasterizer attached the views are drawn
+//  on the CPU and go to the encoders without any readback.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "CameraScript.h"
+#include "SceneManager.h"
+#include "SoftwareRasterizer.h"
+#include "ViewManager.h"
+
+#include <GL/glew.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class BatchRenderer
+{
+public:
+	// constructor
+	BatchRenderer(ViewManager* pViewManager, SceneManager* pSceneManager);
+	// destructor
+	~BatchRenderer();
+
+	// render every pose into the offscreen target and save it as
+	// <outputPrefix>00000.png, <outputPrefix>00001.png, ...
+	bool Run(const std::vector<CAMERA_KEYFRAME>& poses, const std::string& outputPrefix);
+
+	// render the views with the software rasterizer, NULL renders with OpenGL
+	void SetSoftwareRasterizer(SoftwareRasterizer* pRasterizer) { m_pSoftwareRasterizer = pRasterizer; }
+
+private:
+	struct READBACK_SLOT
+	{
+		GLuint pixelBuffer;
+		GLsync fence;
+		// view waiting in the buffer, -1 when the slot is free
+		int viewIndex;
+	};
+
+	struct ENCODE_JOB
+	{
+		std::string filename;
+		// RGBA rows as read from OpenGL, bottom row first
+		std::vector<unsigned char> pixels;
+	};
+
+	// start copying the rendered view into the slot buffer
+	void StartReadback(READBACK_SLOT& slot, int viewIndex);
+	// wait for the slot copy and hand the pixels to the encoders
+	void FinishReadback(READBACK_SLOT& slot);
+	// name the view image and wait for room in the encoding queue
+	void QueueEncodeJob(ENCODE_JOB& job, int viewIndex);
+
+	// start and stop the PNG encoding threads
+	void StartEncoders(int threadCount);
+	void StopEncoders();
+	// loop run by every encoding thread
+	void EncodeJobs();
+
+	ViewManager* m_pViewManager;
+	SceneManager* m_pSceneManager;
+	SoftwareRasterizer* m_pSoftwareRasterizer;
+
+	// size of the offscreen target and the readback ring
+	int m_width;
+	int m_height;
+	std::vector<READBACK_SLOT> m_readbackSlots;
+	std::string m_outputPrefix;
+
+	// encoding jobs waiting for a thread, guarded by the mutex
+	std::mutex m_jobsMutex;
+	std::condition_variable m_jobsChanged;
+	std::deque<ENCODE_JOB> m_jobs;
+	size_t m_maxQueuedJobs;
+	bool m_bStopEncoders;
+	std::vector<std::thread> m_encoders;
+	std::atomic<int> m_failedWrites;
+};
@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerascript.cpp
+// ============
+// scripted camera keyframes for repeatable, input-free scene playback
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CameraScript.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+/***********************************************************
+ *  CameraScript()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CameraScript::CameraScript()
+{
+	LoadDefault();
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for reading the camera keyframes
+ *  from the passed in script file.
+ ***********************************************************/
+bool CameraScript::Load(const char* filename)
+{
+	std::ifstream file(filename);
+	if (!file)
+	{
+		std::cout << "Could not open camera script:" << filename << std::endl;
+		return false;
+	}
+
+	std::vector<CAMERA_KEYFRAME> keyframes;
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+
+		// skip comments and blank lines
+		line = line.substr(0, line.find('#'));
+		if (line.find_first_not_of(" \t\r") == std::string::npos)
+		{
+			continue;
+		}
+
+		CAMERA_KEYFRAME keyframe;
+		std::string projection;
+		std::istringstream fields(line);
+		fields >> keyframe.time
+			>> keyframe.position.x >> keyframe.position.y >> keyframe.position.z
+			>> keyframe.front.x >> keyframe.front.y >> keyframe.front.z
+			>> keyframe.zoom >> projection;
+
+		if (fields.fail() || ((projection != "perspective") && (projection != "orthographic")))
+		{
+			std::cout << "Bad camera keyframe at " << filename << ":" << lineNumber << std::endl;
+			return false;
+		}
+		keyframe.bOrthographic = (projection == "orthographic");
+		keyframes.push_back(keyframe);
+	}
+
+	if (keyframes.empty())
+	{
+		std::cout << "Camera script has no keyframes:" << filename << std::endl;
+		return false;
+	}
+
+	std::stable_sort(keyframes.begin(), keyframes.end(),
+		[](const CAMERA_KEYFRAME& a, const CAMERA_KEYFRAME& b) { return a.time < b.time; });
+	m_keyframes = keyframes;
+
+	return true;
+}
+
+/***********************************************************
+ *  LoadDefault()
+ *
+ *  This method is used for setting up the built-in path,
+ *  which starts at the default ViewManager view, sweeps
+ *  across the table, looks down orthographically and
+ *  returns to the start.
+ ***********************************************************/
+void CameraScript::LoadDefault()
+{
+	const CAMERA_KEYFRAME defaultPath[] = {
+		{ 0.0f, glm::vec3(3.0f, 12.0f, 15.0f), glm::vec3(0.0f, -0.5f, -2.0f), 80.0f, false },
+		{ 2.0f, glm::vec3(-6.0f, 8.0f, 6.0f), glm::vec3(0.5f, -0.4f, -1.0f), 80.0f, false },
+		{ 4.0f, glm::vec3(3.0f, 4.0f, -2.0f), glm::vec3(0.0f, -0.3f, -1.0f), 60.0f, false },
+		{ 6.0f, glm::vec3(12.0f, 8.0f, 6.0f), glm::vec3(-0.5f, -0.4f, -1.0f), 80.0f, false },
+		{ 6.0f, glm::vec3(3.0f, 12.0f, 15.0f), glm::vec3(0.0f, -0.5f, -2.0f), 80.0f, true },
+		{ 8.0f, glm::vec3(3.0f, 12.0f, 15.0f), glm::vec3(0.0f, -0.5f, -2.0f), 80.0f, true },
+		{ 8.0f, glm::vec3(3.0f, 12.0f, 15.0f), glm::vec3(0.0f, -0.5f, -2.0f), 80.0f, false },
+		{ 10.0f, glm::vec3(3.0f, 12.0f, 15.0f), glm::vec3(0.0f, -0.5f, -2.0f), 80.0f, false },
+	};
+
+	m_keyframes.assign(std::begin(defaultPath), std::end(defaultPath));
+}
+
+/***********************************************************
+ *  Sample()
+ *
+ *  This method is used for getting the camera pose at the
+ *  passed in time. Position, front and zoom are blended
+ *  linearly between keyframes, the projection switches at
+ *  the keyframe time.
+ ***********************************************************/
+CAMERA_KEYFRAME CameraScript::Sample(float time) const
+{
+	if (time <= m_keyframes.front().time)
+	{
+		return m_keyframes.front();
+	}
+
+	for (size_t i = 1; i < m_keyframes.size(); i++)
+	{
+		const CAMERA_KEYFRAME& from = m_keyframes[i - 1];
+		const CAMERA_KEYFRAME& to = m_keyframes[i];
+		if (time < to.time)
+		{
+			float blend = (time - from.time) / (to.time - from.time);
+
+			CAMERA_KEYFRAME pose = from;
+			pose.time = time;
+			pose.position = glm::mix(from.position, to.position, blend);
+			pose.front = glm::mix(from.front, to.front, blend);
+			pose.zoom = glm::mix(from.zoom, to.zoom, blend);
+			return pose;
+		}
+	}
+
+	return m_keyframes.back();
+}
+
+/***********************************************************
+ *  GetDuration()
+ *
+ *  This method is used for getting the script length in
+ *  seconds.
+ ***********************************************************/
+float CameraScript::GetDuration() const
+{
+	return m_keyframes.back().time;
+}
@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////////////
+// goldentest.h
+// ============
+// check renderer changes against a reference image and performance baseline
+//
+//  The scene is rendered offscreen from the default ViewManager camera. The
+//  picture has to match the reference image within a perceptual tolerance
+//  and the frame time, draw calls and uniform uploads must not regress past
+//  the baseline stored next to it. Run with the update flag once to seed
+//  the reference and the baseline from the current renderer. With a
+//  software rasterizer attached the same checks run on its images.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+#include "SoftwareRasterizer.h"
+#include "ViewManager.h"
+
+#include <string>
+#include <vector>
+
+struct GOLDEN_TOLERANCE
+{
+	// highest allowed mean CIE76 color difference over all pixels
+	float maxMeanDeltaE;
+	// color difference above which a pixel counts as changed
+	float pixelDeltaE;
+	// highest allowed share of changed pixels
+	float maxChangedPixels;
+	// highest allowed frame time relative to the baseline
+	float maxSlowdown;
+};
+
+class GoldenTest
+{
+public:
+	// constructor
+	GoldenTest(ViewManager* pViewManager, SceneManager* pSceneManager);
+
+	// set the limits the render has to stay within
+	void SetTolerance(const GOLDEN_TOLERANCE& tolerance) { m_tolerance = tolerance; }
+	// render with the software rasterizer, NULL renders with OpenGL
+	void SetSoftwareRasterizer(SoftwareRasterizer* pRasterizer) { m_pSoftwareRasterizer = pRasterizer; }
+
+	// render and compare against the reference, or replace the reference
+	// and baseline with the render when bUpdate is set
+	bool Run(const std::string& referenceFile, bool bUpdate);
+
+private:
+	struct GOLDEN_PERFORMANCE
+	{
+		double frameMilliseconds;
+		int drawCalls;
+		int uniformUploads;
+	};
+
+	// render the timed frames and keep the last image, top row first
+	void RenderFrames();
+	// compare the render with the reference image
+	bool CompareImage(const std::string& referenceFile);
+	// compare the measurements with the stored baseline
+	bool ComparePerformance(const std::string& baselineFile);
+	// read and write the baseline file
+	bool LoadBaseline(const std::string& baselineFile, GOLDEN_PERFORMANCE& baseline);
+	bool SaveBaseline(const std::string& baselineFile);
+
+	ViewManager* m_pViewManager;
+	SceneManager* m_pSceneManager;
+	SoftwareRasterizer* m_pSoftwareRasterizer;
+	GOLDEN_TOLERANCE m_tolerance;
+
+	// render size, RGB pixels of the last frame and its measurements
+	int m_width;
+	int m_height;
+	std::vector<unsigned char> m_image;
+	GOLDEN_PERFORMANCE m_performance;
+};
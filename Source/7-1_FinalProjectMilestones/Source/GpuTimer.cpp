@@ -0,0 +1,216 @@
+///////////////////////////////////////////////////////////////////////////////
+// gputimer.cpp
+// ============
+// measure GPU frame time with timestamp queries that never stall the CPU
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GpuTimer.h"
+
+/***********************************************************
+ *  GpuTimer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GpuTimer::GpuTimer()
+{
+	m_sectionCount = 0;
+	m_nextSlot = 0;
+	m_activeSlot = -1;
+	m_writtenQueries = 0;
+	m_droppedFrames = 0;
+}
+
+/***********************************************************
+ *  ~GpuTimer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GpuTimer::~GpuTimer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the timestamp queries
+ *  of each frame that can be in flight, one for the start
+ *  of every section and one for the end of the frame.
+ ***********************************************************/
+bool GpuTimer::Create(int ringSize, int sectionCount)
+{
+	Destroy();
+
+	m_sectionCount = sectionCount;
+	m_slots.resize(ringSize);
+	for (QUERY_SLOT& slot : m_slots)
+	{
+		slot.queries.resize(sectionCount + 1);
+		glGenQueries(sectionCount + 1, slot.queries.data());
+		slot.frameIndex = 0;
+		slot.bPending = false;
+	}
+
+	return (glGetError() == GL_NO_ERROR);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the query objects.
+ ***********************************************************/
+void GpuTimer::Destroy()
+{
+	for (QUERY_SLOT& slot : m_slots)
+	{
+		glDeleteQueries(static_cast<GLsizei>(slot.queries.size()), slot.queries.data());
+	}
+	m_slots.clear();
+	m_sectionCount = 0;
+	m_nextSlot = 0;
+	m_activeSlot = -1;
+}
+
+/***********************************************************
+ *  Begin()
+ *
+ *  This method is used for marking the start of the GPU
+ *  work of a frame. When the oldest slot has not been read
+ *  back yet the frame is not timed rather than waiting.
+ ***********************************************************/
+void GpuTimer::Begin(int frameIndex)
+{
+	m_activeSlot = -1;
+	if (m_slots.empty())
+	{
+		return;
+	}
+
+	QUERY_SLOT& slot = m_slots[m_nextSlot];
+	if (slot.bPending == true)
+	{
+		m_droppedFrames++;
+		return;
+	}
+
+	glQueryCounter(slot.queries[0], GL_TIMESTAMP);
+	slot.frameIndex = frameIndex;
+	m_activeSlot = m_nextSlot;
+	m_writtenQueries = 1;
+	m_nextSlot = (m_nextSlot + 1) % static_cast<int>(m_slots.size());
+}
+
+/***********************************************************
+ *  NextSection()
+ *
+ *  This method is used for ending the current section and
+ *  starting the passed in one. Sections in between that
+ *  were skipped get the same timestamp, so they time 0.
+ ***********************************************************/
+void GpuTimer::NextSection(int section)
+{
+	if ((m_activeSlot < 0) || (section < m_writtenQueries) || (section > m_sectionCount))
+	{
+		return;
+	}
+
+	QUERY_SLOT& slot = m_slots[m_activeSlot];
+	while (m_writtenQueries <= section)
+	{
+		glQueryCounter(slot.queries[m_writtenQueries], GL_TIMESTAMP);
+		m_writtenQueries++;
+	}
+}
+
+/***********************************************************
+ *  End()
+ *
+ *  This method is used for marking the end of the GPU work
+ *  of a frame.
+ ***********************************************************/
+void GpuTimer::End()
+{
+	if (m_activeSlot < 0)
+	{
+		return;
+	}
+
+	NextSection(m_sectionCount);
+	m_slots[m_activeSlot].bPending = true;
+	m_activeSlot = -1;
+}
+
+/***********************************************************
+ *  Collect()
+ *
+ *  This method is used for reading back the frames whose
+ *  end query has finished. Slots are checked oldest first
+ *  and the check stops at the first unfinished one.
+ ***********************************************************/
+void GpuTimer::Collect(std::vector<GPU_TIMING>& timings)
+{
+	int slotCount = static_cast<int>(m_slots.size());
+	for (int i = 0; i < slotCount; i++)
+	{
+		QUERY_SLOT& slot = m_slots[(m_nextSlot + i) % slotCount];
+		if (slot.bPending == false)
+		{
+			continue;
+		}
+
+		GLint available = 0;
+		glGetQueryObjectiv(slot.queries.back(), GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == 0)
+		{
+			break;
+		}
+		ReadSlot(slot, timings);
+	}
+}
+
+/***********************************************************
+ *  Drain()
+ *
+ *  This method is used for reading back every frame still
+ *  in flight. It waits on the GPU, so it is only called
+ *  once the frame loop has finished.
+ ***********************************************************/
+void GpuTimer::Drain(std::vector<GPU_TIMING>& timings)
+{
+	int slotCount = static_cast<int>(m_slots.size());
+	for (int i = 0; i < slotCount; i++)
+	{
+		QUERY_SLOT& slot = m_slots[(m_nextSlot + i) % slotCount];
+		if (slot.bPending == true)
+		{
+			ReadSlot(slot, timings);
+		}
+	}
+}
+
+/***********************************************************
+ *  ReadSlot()
+ *
+ *  This method is used for converting the timestamps of a
+ *  slot into the frame and section times in milliseconds.
+ ***********************************************************/
+void GpuTimer::ReadSlot(QUERY_SLOT& slot, std::vector<GPU_TIMING>& timings)
+{
+	std::vector<GLuint64> timestamps(slot.queries.size());
+	for (int i = 0; i <= m_sectionCount; i++)
+	{
+		glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+	}
+
+	GPU_TIMING timing;
+	timing.frameIndex = slot.frameIndex;
+	timing.milliseconds = static_cast<double>(timestamps.back() - timestamps.front()) / 1000000.0;
+	for (int i = 0; i < m_sectionCount; i++)
+	{
+		timing.sectionMilliseconds.push_back(
+			static_cast<double>(timestamps[i + 1] - timestamps[i]) / 1000000.0);
+	}
+	timings.push_back(timing);
+
+	slot.bPending = false;
+}
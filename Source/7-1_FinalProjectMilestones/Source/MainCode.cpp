@@ -1,177 +1,891 @@
-#include <iostream>         // error handling and output
-#include <cstdlib>          // EXIT_FAILURE
-
-#include <GL/glew.h>        // GLEW library
-#include "GLFW/glfw3.h"     // GLFW library
-
-// GLM Math Header inclusions
-#include <glm/glm.hpp>
-#include <glm/gtx/transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
-
-#include "SceneManager.h"
-#include "ViewManager.h"
-#include "ShapeMeshes.h"
-#include "ShaderManager.h"
-
-// Namespace for declaring global variables
-namespace
-{
-	// Macro for window title
-	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones"; 
-
-	// Main GLFW window
-	GLFWwindow* g_Window = nullptr;
-
-	// scene manager object for managing the 3D scene prepare and render
-	SceneManager* g_SceneManager = nullptr;
-	// shader manager object for dynamic interaction with the shader code
-	ShaderManager* g_ShaderManager = nullptr;
-	// view manager object for managing the 3D view setup and projection to 2D
-	ViewManager* g_ViewManager = nullptr;
-}
-
-// Function declarations - all functions that are called manually
-// need to be pre-declared at the beginning of the source code.
-bool InitializeGLFW();
-bool InitializeGLEW();
-
-
-/***********************************************************
- *  main(int, char*)
- *
- *  This function gets called after the application has been
- *  launched.
- ***********************************************************/
-int main(int argc, char* argv[])
-{
-	// if GLFW fails initialization, then terminate the application
-	if (InitializeGLFW() == false)
-	{
-		return(EXIT_FAILURE);
-	}
-
-	// try to create a new shader manager object
-	g_ShaderManager = new ShaderManager();
-	// try to create a new view manager object
-	g_ViewManager = new ViewManager(
-		g_ShaderManager);
-
-	// try to create the main display window
-	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
-
-	// if GLEW fails initialization, then terminate the application
-	if (InitializeGLEW() == false)
-	{
-		return(EXIT_FAILURE);
-	}
-
-	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
-		"../../Utilities/shaders/vertexShader.glsl",
-		"../../Utilities/shaders/fragmentShader.glsl");
-	g_ShaderManager->use();
-
-	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
-	g_SceneManager->PrepareScene();
-
-	// loop will keep running until the application is closed 
-	// or until an error has occurred
-	while (!glfwWindowShouldClose(g_Window))
-	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
-
-		// Clear the frame and z buffers
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
-
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
-
-
-		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
-
-		// query the latest GLFW events
-		glfwPollEvents();
-	}
-
-	// clear the allocated manager objects from memory
-	if (NULL != g_SceneManager)
-	{
-		delete g_SceneManager;
-		g_SceneManager = NULL;
-	}
-	if (NULL != g_ViewManager)
-	{
-		delete g_ViewManager;
-		g_ViewManager = NULL;
-	}
-	if (NULL != g_ShaderManager)
-	{
-		delete g_ShaderManager;
-		g_ShaderManager = NULL;
-	}
-
-	// Terminates the program successfully
-	exit(EXIT_SUCCESS); 
-}
-
-/***********************************************************
- *	InitializeGLFW()
- * 
- *  This function is used to initialize the GLFW library.   
- ***********************************************************/
-bool InitializeGLFW()
-{
-	// GLFW: initialize and configure library
-	// --------------------------------------
-	glfwInit();
-
-#ifdef __APPLE__
-	// set the version of OpenGL and profile to use
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#else
-	// set the version of OpenGL and profile to use
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#endif
-	// GLFW: end -------------------------------
-
-	return(true);
-}
-
-/***********************************************************
- *	InitializeGLEW()
- *
- *  This function is used to initialize the GLEW library.
- ***********************************************************/
-bool InitializeGLEW()
-{
-	// GLEW: initialize
-	// -----------------------------------------
-	GLenum GLEWInitResult = GLEW_OK;
-
-	// try to initialize the GLEW library
-	GLEWInitResult = glewInit();
-	if (GLEW_OK != GLEWInitResult)
-	{
-		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
-		return false;
-	}
-	// GLEW: end -------------------------------
-
-	// Displays a successful OpenGL initialization message
-	std::cout << "INFO: OpenGL Successfully Initialized\n";
-	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
-
-	return(true);
+#include <iostream>         // error handling and output
+#include <cstdlib>          // EXIT_FAILURE
+#include <climits>          // INT_MAX
+#include <cmath>            // std::isfinite
+#include <string>           // command line options
+
+#include <GL/glew.h>        // GLEW library
+#include "GLFW/glfw3.h"     // GLFW library
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "SceneManager.h"
+#include "ViewManager.h"
+#include "Benchmark.h"
+#include "BatchRenderer.h"
+#include "GoldenTest.h"
+#include "RenderStats.h"
+#include "SoftwareRasterizer.h"
+#include "StateCache.h"
+#include "Trace.h"
+#include "TrackedShapeMeshes.h"
+#include "TrackedShaderManager.h"
+
+// Namespace for declaring global variables
+namespace
+{
+	// Macro for window title
+	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones"; 
+
+	// Main GLFW window
+	GLFWwindow* g_Window = nullptr;
+
+	// scene manager object for managing the 3D scene prepare and render
+	SceneManager* g_SceneManager = nullptr;
+	// shader manager object for dynamic interaction with the shader code
+	TrackedShaderManager* g_ShaderManager = nullptr;
+	// view manager object for managing the 3D view setup and projection to 2D
+	ViewManager* g_ViewManager = nullptr;
+
+	// true when rendering into an offscreen framebuffer with no display
+	bool g_bHeadless = false;
+	// context creation API used for headless rendering (EGL or OSMesa)
+	int g_HeadlessContextAPI = 0;
+	// number of frames to render before exiting, 0 renders until closed
+	// and -1 when the option was not a positive whole number
+	int g_FrameLimit = 0;
+
+	// true when the camera follows a script and the frames are timed
+	bool g_bBenchmark = false;
+	// camera script and JSON report files, NULL for the defaults
+	const char* g_CameraScriptFile = NULL;
+	const char* g_BenchmarkOutputFile = NULL;
+	// simulated time between benchmark frames in seconds
+	float g_TimeStep = 1.0f / 60.0f;
+	// true to also time the object groups, which regroups the submission
+	bool g_bBenchmarkGroups = false;
+
+	// file the CPU trace zones are written to, NULL when not tracing
+	const char* g_TraceFile = NULL;
+
+	// true to print the render statistics of the last frame on exit
+	bool g_bPrintStats = false;
+
+	// true to only render when the view changed, sleeping otherwise
+	bool g_bRenderOnDemand = false;
+	// longest sleep between event checks while nothing changes
+	const double ON_DEMAND_WAIT_SECONDS = 0.5;
+
+	// camera pose file of the batch renderer, NULL when not batch rendering
+	const char* g_BatchFile = NULL;
+	// start of the batch image file names, the view number is appended
+	std::string g_BatchOutputPrefix = "batch_";
+
+	// reference image of the golden test, NULL when not testing
+	const char* g_GoldenFile = NULL;
+	// true to replace the reference image and baseline with this render
+	bool g_bGoldenUpdate = false;
+	// limits of the golden test, negative keeps the GoldenTest default
+	// and 0 marks an option that was not a positive number
+	float g_GoldenMaxDeltaE = -1.0f;
+	float g_GoldenMaxSlowdown = -1.0f;
+
+	// number of prop copies of the stress scene, 0 draws the normal scene
+	// and -1 marks an option that was not a positive whole number
+	int g_StressCopies = 0;
+	// true to place the stress scene copies at random instead of on a grid
+	bool g_bStressRandom = false;
+
+	// false to submit the draws in authoring order instead of sorted by state
+	bool g_bSortDraws = true;
+	// how the scene sends its draw list to OpenGL
+	SceneManager::SUBMIT_MODE g_SubmitMode = SceneManager::SUBMIT_DRAWS;
+
+	// false to upload the textures uncompressed instead of block compressed
+	bool g_bCompressTextures = true;
+	// false to sample texture arrays instead of bindless handles
+	bool g_bBindlessTextures = true;
+	// megabytes of texture memory the scene textures may take, 0 for no
+	// limit and -1 when the option was not a positive whole number
+	int g_TextureBudgetMegabytes = 0;
+
+	// true to draw the scene with the CPU rasterizer instead of OpenGL
+	bool g_bSoftware = false;
+	// number of rasterizer threads, 0 uses every core and -1 marks an
+	// option that was not a positive whole number
+	int g_SoftwareThreads = 0;
+	// software rasterizer object, created when rendering on the CPU
+	SoftwareRasterizer* g_SoftwareRasterizer = nullptr;
+	// benchmark object for timing the scripted camera playback
+	Benchmark* g_Benchmark = nullptr;
+}
+
+// Function declarations - all functions that are called manually
+// need to be pre-declared at the beginning of the source code.
+bool ParseCommandLine(int argc, char* argv[]);
+bool ParsePositiveInt(const char* text, int& value);
+bool ParsePositiveFloat(const char* text, float& value);
+void PrintUsage(const char* program);
+bool InitializeGLFW();
+bool InitializeGLEW();
+
+
+/***********************************************************
+ *  main(int, char*)
+ *
+ *  This function gets called after the application has been
+ *  launched.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	// if the command line options are not valid, then terminate the application
+	if (ParseCommandLine(argc, argv) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// if GLFW fails initialization, then terminate the application
+	if (InitializeGLFW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// try to create a new shader manager object
+	g_ShaderManager = new TrackedShaderManager();
+	// try to create a new view manager object
+	g_ViewManager = new ViewManager(
+		g_ShaderManager);
+
+	// try to create the main display window
+	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	if (g_Window == NULL)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// if GLEW fails initialization, then terminate the application
+	if (InitializeGLEW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// a headless window has no default framebuffer, so render into an FBO,
+	// the batch renderer and the golden test read their images back from one as well
+	if (((g_bHeadless == true) || (g_BatchFile != NULL) || (g_GoldenFile != NULL) || (g_bSoftware == true)) &&
+		(g_ViewManager->CreateOffscreenTarget() == false))
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// load the shader code from the external GLSL files
+	g_ShaderManager->LoadShaders(
+		"../../Utilities/shaders/vertexShader.glsl",
+		"../../Utilities/shaders/fragmentShader.glsl");
+	g_ShaderManager->use();
+
+	// try to create a new scene manager object and prepare the 3D scene
+	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->SetTextureCompression(g_bCompressTextures);
+	if (g_TextureBudgetMegabytes > 0)
+	{
+		g_SceneManager->SetTextureBudget(static_cast<size_t>(g_TextureBudgetMegabytes) << 20);
+	}
+	g_SceneManager->PrepareScene();
+	// saved, compared and timed renders start with every texture uploaded,
+	// only the interactive window draws placeholders while they arrive
+	if ((g_bHeadless == true) || (g_bBenchmark == true) || (g_BatchFile != NULL) ||
+		(g_GoldenFile != NULL) || (g_bSoftware == true))
+	{
+		g_SceneManager->FinishTextureLoads();
+	}
+	g_SceneManager->SetSortedSubmission(g_bSortDraws);
+	g_SceneManager->SetBindlessTextures(g_bBindlessTextures);
+	if ((g_SubmitMode != SceneManager::SUBMIT_DRAWS) &&
+		(g_SceneManager->SetSubmissionMode(g_SubmitMode) == false))
+	{
+		return(EXIT_FAILURE);
+	}
+	if (g_StressCopies > 0)
+	{
+		g_SceneManager->SetStressScene(g_StressCopies, g_bStressRandom);
+		std::cout << "INFO: Stress scene with " << g_StressCopies << " prop copies ("
+			<< ((g_bStressRandom == true) ? "random" : "grid") << " layout)" << std::endl;
+	}
+
+	// draw the scene on the CPU, OpenGL is only used to capture the meshes
+	if (g_bSoftware == true)
+	{
+		OffscreenTarget* pTarget = g_ViewManager->GetOffscreenTarget();
+		g_SoftwareRasterizer = new SoftwareRasterizer(g_ShaderManager);
+		if (g_SoftwareRasterizer->Create(pTarget->GetWidth(), pTarget->GetHeight(), g_SoftwareThreads) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+		g_SceneManager->SetSoftwareRasterizer(g_SoftwareRasterizer);
+	}
+
+	// render every view of the pose file to a PNG image and exit
+	if (g_BatchFile != NULL)
+	{
+		CameraScript poses;
+		bool bBatchDone = poses.Load(g_BatchFile);
+		if (bBatchDone == true)
+		{
+			BatchRenderer batchRenderer(g_ViewManager, g_SceneManager);
+			batchRenderer.SetSoftwareRasterizer(g_SoftwareRasterizer);
+			bBatchDone = batchRenderer.Run(poses.GetKeyframes(), g_BatchOutputPrefix);
+		}
+
+		// the texture loader and rasterizer threads end with their owners,
+		// so no zone is recorded while the trace is written. The scene
+		// drops its textures from the rasterizer, so it goes first
+		Trace::SetEnabled(false);
+		delete g_SceneManager;
+		delete g_SoftwareRasterizer;
+		if (g_TraceFile != NULL)
+		{
+			Trace::WriteChromeTrace(g_TraceFile);
+		}
+		delete g_ViewManager;
+		delete g_ShaderManager;
+		return(bBatchDone ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	// check the default view against the reference image and exit
+	if (g_GoldenFile != NULL)
+	{
+		GoldenTest goldenTest(g_ViewManager, g_SceneManager);
+		GOLDEN_TOLERANCE tolerance = { 1.0f, 10.0f, 0.005f, 1.25f };
+		if (g_GoldenMaxDeltaE > 0.0f)
+		{
+			tolerance.maxMeanDeltaE = g_GoldenMaxDeltaE;
+		}
+		if (g_GoldenMaxSlowdown > 0.0f)
+		{
+			tolerance.maxSlowdown = g_GoldenMaxSlowdown;
+		}
+		goldenTest.SetTolerance(tolerance);
+		goldenTest.SetSoftwareRasterizer(g_SoftwareRasterizer);
+		bool bGoldenPassed = goldenTest.Run(g_GoldenFile, g_bGoldenUpdate);
+
+		// the texture loader and rasterizer threads end with their owners,
+		// so no zone is recorded while the trace is written. The scene
+		// drops its textures from the rasterizer, so it goes first
+		Trace::SetEnabled(false);
+		delete g_SceneManager;
+		delete g_SoftwareRasterizer;
+		if (g_TraceFile != NULL)
+		{
+			Trace::WriteChromeTrace(g_TraceFile);
+		}
+		delete g_ViewManager;
+		delete g_ShaderManager;
+		return(bGoldenPassed ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	// hand the camera over to the script and render the whole path
+	if (g_bBenchmark == true)
+	{
+		g_Benchmark = new Benchmark(g_ViewManager, g_SceneManager);
+		g_Benchmark->SetTimeStep(g_TimeStep);
+		g_Benchmark->SetGroupTiming(g_bBenchmarkGroups);
+		if ((g_CameraScriptFile != NULL) &&
+			(g_Benchmark->LoadCameraScript(g_CameraScriptFile) == false))
+		{
+			return(EXIT_FAILURE);
+		}
+		if (g_Benchmark->Start() == false)
+		{
+			std::cerr << "Failed to create the benchmark GPU timer" << std::endl;
+			return(EXIT_FAILURE);
+		}
+		if (g_FrameLimit == 0)
+		{
+			g_FrameLimit = g_Benchmark->GetFrameCount();
+		}
+		// do not let the display refresh rate limit the frame times
+		if (g_bHeadless == false)
+		{
+			glfwSwapInterval(0);
+		}
+	}
+
+	int renderedFrames = 0;
+	double startTime = glfwGetTime();
+
+	// loop will keep running until the application is closed 
+	// or until an error has occurred
+	while (!glfwWindowShouldClose(g_Window) &&
+		((g_FrameLimit == 0) || (renderedFrames < g_FrameLimit)))
+	{
+		// the last frame stays on screen until the view changes or textures arrive
+		if ((g_bRenderOnDemand == true) && (g_ViewManager->IsSceneChanged() == false) &&
+			(g_SceneManager->IsLoadingTextures() == false))
+		{
+			{
+				TRACE_ZONE("glfwWaitEventsTimeout");
+				glfwWaitEventsTimeout(ON_DEMAND_WAIT_SECONDS);
+			}
+			g_ViewManager->ResetFrameTime();
+			continue;
+		}
+
+		TRACE_ZONE("Frame");
+
+		RenderStats::BeginFrame();
+		if (g_Benchmark != nullptr)
+		{
+			g_Benchmark->BeginFrame(renderedFrames);
+		}
+
+		// Enable z-depth
+		StateCache::Enable(GL_DEPTH_TEST);
+
+		// Clear the frame and z buffers
+		StateCache::ClearColor(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		// convert from 3D object space to 2D view
+		{
+			TRACE_ZONE("PrepareSceneView");
+			g_ViewManager->PrepareSceneView();
+		}
+
+		// refresh the 3D scene
+		{
+			TRACE_ZONE("RenderScene");
+			g_SceneManager->RenderScene();
+		}
+		if (g_SoftwareRasterizer != nullptr)
+		{
+			g_SoftwareRasterizer->Render();
+		}
+
+		RenderStats::EndFrame();
+		if (g_Benchmark != nullptr)
+		{
+			g_Benchmark->EndFrame();
+		}
+
+		// Flips the the back buffer with the front buffer every frame.
+		// There is nothing to flip when headless, so wait for the frame instead.
+		if (g_bHeadless == true)
+		{
+			TRACE_ZONE("glFinish");
+			glFinish();
+		}
+		else
+		{
+			TRACE_ZONE("glfwSwapBuffers");
+			glfwSwapBuffers(g_Window);
+		}
+
+		// query the latest GLFW events
+		{
+			TRACE_ZONE("glfwPollEvents");
+			glfwPollEvents();
+		}
+
+		renderedFrames++;
+	}
+
+	double elapsedTime = glfwGetTime() - startTime;
+	std::cout << "INFO: Rendered " << renderedFrames << " frames in "
+		<< elapsedTime * 1000.0 << " ms" << std::endl;
+
+	if (g_bPrintStats == true)
+	{
+		std::cout << "INFO: Last frame stats: ";
+		RenderStats::WriteJSON(std::cout, RenderStats::GetLastFrame());
+		std::cout << std::endl;
+	}
+
+	// zones the worker threads are still in are recorded until they end
+	Trace::SetEnabled(false);
+
+	if (g_Benchmark != nullptr)
+	{
+		g_Benchmark->WriteReport(g_BenchmarkOutputFile);
+		delete g_Benchmark;
+		g_Benchmark = nullptr;
+	}
+
+	// clear the allocated manager objects from memory, the scene before
+	// the rasterizer it drops its textures from
+	if (NULL != g_SceneManager)
+	{
+		delete g_SceneManager;
+		g_SceneManager = NULL;
+	}
+	if (NULL != g_SoftwareRasterizer)
+	{
+		delete g_SoftwareRasterizer;
+		g_SoftwareRasterizer = NULL;
+	}
+	// the texture loader threads have ended with the scene manager
+	if (g_TraceFile != NULL)
+	{
+		Trace::WriteChromeTrace(g_TraceFile);
+	}
+	if (NULL != g_ViewManager)
+	{
+		delete g_ViewManager;
+		g_ViewManager = NULL;
+	}
+	if (NULL != g_ShaderManager)
+	{
+		delete g_ShaderManager;
+		g_ShaderManager = NULL;
+	}
+
+	// Terminates the program successfully
+	exit(EXIT_SUCCESS); 
+}
+
+/***********************************************************
+ *	ParseCommandLine(int, char*)
+ *
+ *  This function is used to read the run options from the
+ *  command line.
+ *
+ *    --headless[=egl|osmesa]  render offscreen with no display
+ *    --frames N               exit after rendering N frames
+ *    --benchmark              time the scene along a scripted camera path
+ *    --camera-script FILE     camera keyframes for the benchmark
+ *    --benchmark-output FILE  write the benchmark JSON to a file
+ *    --benchmark-groups       also time each object group, which keeps the
+ *                             groups apart in the draw order and batches
+ *    --timestep SECONDS       benchmark time between frames (1/60)
+ *    --trace FILE             write CPU trace zones for chrome://tracing
+ *    --stats                  print the render statistics of the last frame
+ *    --on-demand              only render when the camera or window changes
+ *    --batch FILE             render every camera pose in FILE to a PNG
+ *    --batch-output PREFIX    start of the batch image names ("batch_")
+ *    --golden FILE            compare the default view with a reference image,
+ *                             exits with a failure on a visual or perf regression
+ *    --golden-update          store the render as the new reference and baseline
+ *    --golden-delta-e DE      highest mean color difference (1.0)
+ *    --golden-max-slowdown R  highest frame time over the baseline (1.25)
+ *    --software[=THREADS]     rasterize on the CPU, with --headless, --batch
+ *                             or --golden
+ *    --stress N               draw N copies of the props instead of the scene
+ *    --stress-layout L        place the copies on a "grid" or at "random"
+ *    --unsorted               submit the draws in authoring order, not by state
+ *    --submit MODE            one draw call per object ("draws"), one
+ *                             instanced draw call per mesh ("instanced") or
+ *                             one multi-draw call per frame ("indirect"), or
+ *                             one draw call per merged world-space mesh
+ *                             ("baked")
+ *    --raw-textures           upload the textures uncompressed, not as BC7/BC1
+ *    --no-bindless            sample texture arrays instead of bindless
+ *                             handles in the instanced and indirect modes
+ *    --texture-budget MB      keep the scene textures within MB megabytes,
+ *                             evicting or reducing the least recently drawn
+ ***********************************************************/
+bool ParseCommandLine(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string option = argv[i];
+
+		if ((option == "--headless") || (option == "--headless=egl"))
+		{
+			g_bHeadless = true;
+#ifdef GLFW_PLATFORM_NULL
+			g_HeadlessContextAPI = GLFW_EGL_CONTEXT_API;
+#endif
+		}
+		else if (option == "--headless=osmesa")
+		{
+			g_bHeadless = true;
+#ifdef GLFW_PLATFORM_NULL
+			g_HeadlessContextAPI = GLFW_OSMESA_CONTEXT_API;
+#endif
+		}
+		else if ((option == "--frames") && (i + 1 < argc))
+		{
+			if (ParsePositiveInt(argv[++i], g_FrameLimit) == false)
+			{
+				g_FrameLimit = -1;
+			}
+		}
+		else if (option == "--benchmark")
+		{
+			g_bBenchmark = true;
+		}
+		else if ((option == "--camera-script") && (i + 1 < argc))
+		{
+			g_bBenchmark = true;
+			g_CameraScriptFile = argv[++i];
+		}
+		else if ((option == "--benchmark-output") && (i + 1 < argc))
+		{
+			g_bBenchmark = true;
+			g_BenchmarkOutputFile = argv[++i];
+		}
+		else if (option == "--benchmark-groups")
+		{
+			g_bBenchmark = true;
+			g_bBenchmarkGroups = true;
+		}
+		else if ((option == "--timestep") && (i + 1 < argc))
+		{
+			if (ParsePositiveFloat(argv[++i], g_TimeStep) == false)
+			{
+				g_TimeStep = 0.0f;
+			}
+		}
+		else if ((option == "--batch") && (i + 1 < argc))
+		{
+			g_BatchFile = argv[++i];
+		}
+		else if ((option == "--batch-output") && (i + 1 < argc))
+		{
+			g_BatchOutputPrefix = argv[++i];
+		}
+		else if ((option == "--golden") && (i + 1 < argc))
+		{
+			g_GoldenFile = argv[++i];
+		}
+		else if (option == "--golden-update")
+		{
+			g_bGoldenUpdate = true;
+		}
+		else if ((option == "--golden-delta-e") && (i + 1 < argc))
+		{
+			if (ParsePositiveFloat(argv[++i], g_GoldenMaxDeltaE) == false)
+			{
+				g_GoldenMaxDeltaE = 0.0f;
+			}
+		}
+		else if ((option == "--golden-max-slowdown") && (i + 1 < argc))
+		{
+			if (ParsePositiveFloat(argv[++i], g_GoldenMaxSlowdown) == false)
+			{
+				g_GoldenMaxSlowdown = 0.0f;
+			}
+		}
+		else if (option == "--software")
+		{
+			g_bSoftware = true;
+		}
+		else if (option.compare(0, 11, "--software=") == 0)
+		{
+			g_bSoftware = true;
+			if (ParsePositiveInt(option.c_str() + 11, g_SoftwareThreads) == false)
+			{
+				g_SoftwareThreads = -1;
+			}
+		}
+		else if ((option == "--stress") && (i + 1 < argc))
+		{
+			if (ParsePositiveInt(argv[++i], g_StressCopies) == false)
+			{
+				g_StressCopies = -1;
+			}
+		}
+		else if ((option == "--stress-layout") && (i + 1 < argc) &&
+			((std::string(argv[i + 1]) == "grid") || (std::string(argv[i + 1]) == "random")))
+		{
+			g_bStressRandom = (std::string(argv[++i]) == "random");
+		}
+		else if (option == "--unsorted")
+		{
+			g_bSortDraws = false;
+		}
+		else if ((option == "--submit") && (i + 1 < argc) && (std::string(argv[i + 1]) == "draws"))
+		{
+			g_SubmitMode = SceneManager::SUBMIT_DRAWS;
+			i++;
+		}
+		else if ((option == "--submit") && (i + 1 < argc) && (std::string(argv[i + 1]) == "instanced"))
+		{
+			g_SubmitMode = SceneManager::SUBMIT_INSTANCED;
+			i++;
+		}
+		else if ((option == "--submit") && (i + 1 < argc) && (std::string(argv[i + 1]) == "indirect"))
+		{
+			g_SubmitMode = SceneManager::SUBMIT_INDIRECT;
+			i++;
+		}
+		else if ((option == "--submit") && (i + 1 < argc) && (std::string(argv[i + 1]) == "baked"))
+		{
+			g_SubmitMode = SceneManager::SUBMIT_BAKED;
+			i++;
+		}
+		else if (option == "--raw-textures")
+		{
+			g_bCompressTextures = false;
+		}
+		else if (option == "--no-bindless")
+		{
+			g_bBindlessTextures = false;
+		}
+		else if ((option == "--texture-budget") && (i + 1 < argc))
+		{
+			if (ParsePositiveInt(argv[++i], g_TextureBudgetMegabytes) == false)
+			{
+				g_TextureBudgetMegabytes = -1;
+			}
+		}
+		else if (option == "--on-demand")
+		{
+			g_bRenderOnDemand = true;
+		}
+		else if (option == "--stats")
+		{
+			g_bPrintStats = true;
+		}
+		else if ((option == "--trace") && (i + 1 < argc))
+		{
+#if SCENE_TRACE
+			g_TraceFile = argv[++i];
+			Trace::SetEnabled(true);
+#else
+			std::cerr << "Tracing was compiled out, rebuild with SCENE_TRACE=1" << std::endl;
+			return false;
+#endif
+		}
+		else
+		{
+			std::cerr << "Unknown option: " << option << std::endl;
+			PrintUsage(argv[0]);
+			return false;
+		}
+	}
+
+	// 0 would mean no limit and a negative count renders nothing
+	if (g_FrameLimit < 0)
+	{
+		std::cerr << "--frames needs a whole number of frames greater than 0" << std::endl;
+		PrintUsage(argv[0]);
+		return false;
+	}
+	// the benchmark divides the camera path by the step
+	if (g_TimeStep == 0.0f)
+	{
+		std::cerr << "--timestep needs a number of seconds greater than 0" << std::endl;
+		PrintUsage(argv[0]);
+		return false;
+	}
+	// 0 would draw the normal scene or use every core without saying so
+	if (g_StressCopies < 0)
+	{
+		std::cerr << "--stress needs a whole number of copies greater than 0" << std::endl;
+		PrintUsage(argv[0]);
+		return false;
+	}
+	if (g_SoftwareThreads < 0)
+	{
+		std::cerr << "--software= needs a whole number of threads greater than 0" << std::endl;
+		PrintUsage(argv[0]);
+		return false;
+	}
+	// the budget is a bare number of megabytes, "64MB" or 0 is refused
+	if (g_TextureBudgetMegabytes < 0)
+	{
+		std::cerr << "--texture-budget needs a whole number of megabytes greater than 0" << std::endl;
+		PrintUsage(argv[0]);
+		return false;
+	}
+	// a limit of 0 or less would fail every golden test
+	if ((g_GoldenMaxDeltaE == 0.0f) || (g_GoldenMaxSlowdown == 0.0f))
+	{
+		std::cerr << "--golden-delta-e and --golden-max-slowdown need a number greater than 0" << std::endl;
+		PrintUsage(argv[0]);
+		return false;
+	}
+	// with no display there are no events that could wake the loop
+	if ((g_bRenderOnDemand == true) && ((g_bHeadless == true) || (g_bBenchmark == true)))
+	{
+		std::cerr << "--on-demand needs a display window and cannot be combined with "
+			<< "--headless or the benchmark" << std::endl;
+		return false;
+	}
+	if ((g_BatchFile != NULL) && ((g_bBenchmark == true) || (g_bRenderOnDemand == true)))
+	{
+		std::cerr << "--batch cannot be combined with the benchmark or --on-demand" << std::endl;
+		return false;
+	}
+
+	if ((g_GoldenFile != NULL) &&
+		((g_BatchFile != NULL) || (g_bBenchmark == true) || (g_bRenderOnDemand == true)))
+	{
+		std::cerr << "--golden cannot be combined with --batch, the benchmark or --on-demand" << std::endl;
+		return false;
+	}
+	// the software image is only saved or compared, never shown in the window
+	if ((g_bSoftware == true) && (g_bHeadless == false) && (g_BatchFile == NULL) && (g_GoldenFile == NULL))
+	{
+		std::cerr << "--software needs --headless, --batch or --golden" << std::endl;
+		return false;
+	}
+	// the software rasterizer draws the meshes one at a time
+	if ((g_bSoftware == true) && (g_SubmitMode != SceneManager::SUBMIT_DRAWS))
+	{
+		std::cerr << "--software cannot be combined with --submit instanced, indirect or baked" << std::endl;
+		return false;
+	}
+	if ((g_bGoldenUpdate == true) && (g_GoldenFile == NULL))
+	{
+		std::cerr << "--golden-update needs the reference image given with --golden" << std::endl;
+		return false;
+	}
+
+#ifndef GLFW_PLATFORM_NULL
+	if (g_bHeadless == true)
+	{
+		std::cerr << "Headless rendering needs GLFW 3.4 or newer for the null platform" << std::endl;
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+/***********************************************************
+ *	ParsePositiveInt(const char*, int&)
+ *
+ *  This function is used to read a command line value as a
+ *  whole number greater than 0. The whole text has to be the
+ *  number, so "abc" or "64MB" fail instead of being read as
+ *  0 or 64. The value is only changed when it is valid.
+ ***********************************************************/
+bool ParsePositiveInt(const char* text, int& value)
+{
+	char* numberEnd = NULL;
+	long number = std::strtol(text, &numberEnd, 10);
+
+	if ((numberEnd == text) || (*numberEnd != '\0') ||
+		(number <= 0) || (number > INT_MAX))
+	{
+		return false;
+	}
+
+	value = static_cast<int>(number);
+	return true;
+}
+
+/***********************************************************
+ *	ParsePositiveFloat(const char*, float&)
+ *
+ *  This function is used to read a command line value as a
+ *  finite number greater than 0, with the whole text being
+ *  the number. The value is only changed when it is valid.
+ ***********************************************************/
+bool ParsePositiveFloat(const char* text, float& value)
+{
+	char* numberEnd = NULL;
+	float number = static_cast<float>(std::strtod(text, &numberEnd));
+
+	// NaN fails the comparison as well
+	if ((numberEnd == text) || (*numberEnd != '\0') ||
+		!(number > 0.0f) || (std::isfinite(number) == false))
+	{
+		return false;
+	}
+
+	value = number;
+	return true;
+}
+
+/***********************************************************
+ *	PrintUsage(const char*)
+ *
+ *  This function is used to print the command line options
+ *  after an option was not accepted.
+ ***********************************************************/
+void PrintUsage(const char* program)
+{
+	std::cerr << "Usage: " << program << " [--headless[=egl|osmesa]] [--frames N]\n"
+		<< "         [--benchmark] [--camera-script FILE] [--benchmark-output FILE]\n"
+		<< "         [--benchmark-groups] [--timestep SECONDS] [--trace FILE]\n"
+		<< "         [--stats] [--on-demand]\n"
+		<< "         [--batch FILE] [--batch-output PREFIX]\n"
+		<< "         [--golden FILE] [--golden-update] [--golden-delta-e DE]\n"
+		<< "         [--golden-max-slowdown RATIO] [--software[=THREADS]]\n"
+		<< "         [--stress N] [--stress-layout grid|random] [--unsorted]\n"
+		<< "         [--submit draws|instanced|indirect|baked] [--raw-textures]\n"
+		<< "         [--no-bindless] [--texture-budget MB]" << std::endl;
+}
+
+/***********************************************************
+ *	InitializeGLFW()
+ * 
+ *  This function is used to initialize the GLFW library.   
+ ***********************************************************/
+bool InitializeGLFW()
+{
+	// GLFW: initialize and configure library
+	// --------------------------------------
+#ifdef GLFW_PLATFORM_NULL
+	// the null platform needs no display server, the context
+	// comes from EGL surfaceless or OSMesa (llvmpipe)
+	if (g_bHeadless == true)
+	{
+		glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+	}
+#endif
+
+	if (glfwInit() == GLFW_FALSE)
+	{
+		std::cerr << "Failed to initialize GLFW" << std::endl;
+		return(false);
+	}
+
+#ifdef GLFW_PLATFORM_NULL
+	if (g_bHeadless == true)
+	{
+		// llvmpipe exposes OpenGL 4.5, which covers everything the scene uses
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, g_HeadlessContextAPI);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		return(true);
+	}
+#endif
+
+#ifdef __APPLE__
+	// set the version of OpenGL and profile to use
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#else
+	// set the version of OpenGL and profile to use
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#endif
+	// GLFW: end -------------------------------
+
+	return(true);
+}
+
+/***********************************************************
+ *	InitializeGLEW()
+ *
+ *  This function is used to initialize the GLEW library.
+ ***********************************************************/
+bool InitializeGLEW()
+{
+	// GLEW: initialize
+	// -----------------------------------------
+	GLenum GLEWInitResult = GLEW_OK;
+
+	// try to initialize the GLEW library
+	GLEWInitResult = glewInit();
+
+	// a GLX build of GLEW finds no X display for an EGL or OSMesa
+	// context, but the OpenGL entry points are loaded by then
+	if ((g_bHeadless == true) && (GLEWInitResult == GLEW_ERROR_NO_GLX_DISPLAY))
+	{
+		GLEWInitResult = GLEW_OK;
+	}
+
+	if (GLEW_OK != GLEWInitResult)
+	{
+		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
+		return false;
+	}
+	// GLEW: end -------------------------------
+
+	// Displays a successful OpenGL initialization message
+	std::cout << "INFO: OpenGL Successfully Initialized\n";
+	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
+
+	return(true);
 }
\ No newline at end of file
@@ -0,0 +1,175 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshcapture.cpp
+// ============
+// copy the triangles of a ShapeMeshes draw back from OpenGL
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshCapture.h"
+#include "StateCache.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// room for the largest captured mesh, 32 bytes per vertex
+	const GLsizeiptr CAPTURE_BUFFER_BYTES = 8 << 20;
+
+	// passes the mesh vertices through unchanged into the capture buffer
+	const char* g_CaptureShader =
+		"#version 330 core\n"
+		"layout (location = 0) in vec3 inVertexPosition;\n"
+		"layout (location = 1) in vec3 inVertexNormal;\n"
+		"layout (location = 2) in vec2 inTextureCoordinate;\n"
+		"out vec3 capturedPosition;\n"
+		"out vec3 capturedNormal;\n"
+		"out vec2 capturedTextureCoordinate;\n"
+		"void main()\n"
+		"{\n"
+		"	capturedPosition = inVertexPosition;\n"
+		"	capturedNormal = inVertexNormal;\n"
+		"	capturedTextureCoordinate = inTextureCoordinate;\n"
+		"	gl_Position = vec4(inVertexPosition, 1.0);\n"
+		"}\n";
+	const char* g_CaptureVaryings[] = {
+		"capturedPosition", "capturedNormal", "capturedTextureCoordinate" };
+}
+
+/***********************************************************
+ *  MeshCapture()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshCapture::MeshCapture()
+{
+	m_captureProgram = 0;
+	m_captureBuffer = 0;
+	m_captureQuery = 0;
+	m_savedProgram = 0;
+}
+
+/***********************************************************
+ *  ~MeshCapture()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MeshCapture::~MeshCapture()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the transform feedback
+ *  program, the buffer it writes into and the query that
+ *  counts the written triangles.
+ ***********************************************************/
+bool MeshCapture::Create()
+{
+	Destroy();
+
+	// the capture program only has a vertex stage, its outputs are
+	// written to the capture buffer and nothing is rasterized
+	GLuint shader = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(shader, 1, &g_CaptureShader, NULL);
+	glCompileShader(shader);
+	m_captureProgram = glCreateProgram();
+	glAttachShader(m_captureProgram, shader);
+	glTransformFeedbackVaryings(m_captureProgram, 3, g_CaptureVaryings, GL_INTERLEAVED_ATTRIBS);
+	glLinkProgram(m_captureProgram);
+	glDeleteShader(shader);
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(m_captureProgram, GL_LINK_STATUS, &linked);
+	if (linked == GL_FALSE)
+	{
+		char log[1024];
+		glGetProgramInfoLog(m_captureProgram, sizeof(log), NULL, log);
+		std::cout << "Could not link the mesh capture program: " << log << std::endl;
+		Destroy();
+		return false;
+	}
+
+	glGenBuffers(1, &m_captureBuffer);
+	glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, m_captureBuffer);
+	glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, CAPTURE_BUFFER_BYTES, NULL, GL_STREAM_READ);
+	glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+	glGenQueries(1, &m_captureQuery);
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the capture objects.
+ ***********************************************************/
+void MeshCapture::Destroy()
+{
+	if (m_captureProgram != 0)
+	{
+		glDeleteProgram(m_captureProgram);
+		m_captureProgram = 0;
+	}
+	if (m_captureBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_captureBuffer);
+		m_captureBuffer = 0;
+	}
+	if (m_captureQuery != 0)
+	{
+		glDeleteQueries(1, &m_captureQuery);
+		m_captureQuery = 0;
+	}
+}
+
+/***********************************************************
+ *  Begin()
+ *
+ *  This method is used for switching to the capture program
+ *  and starting the transform feedback, so the draws that
+ *  follow go into the capture buffer instead of the screen.
+ ***********************************************************/
+void MeshCapture::Begin()
+{
+	m_savedProgram = StateCache::GetProgram();
+	StateCache::UseProgram(m_captureProgram);
+	StateCache::Enable(GL_RASTERIZER_DISCARD);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_captureBuffer);
+	glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, m_captureQuery);
+	glBeginTransformFeedback(GL_TRIANGLES);
+}
+
+/***********************************************************
+ *  End()
+ *
+ *  This method is used for ending the transform feedback
+ *  and copying the triangles the draws wrote into the
+ *  capture buffer.
+ ***********************************************************/
+void MeshCapture::End(std::vector<MESH_VERTEX>& vertices)
+{
+	glEndTransformFeedback();
+	glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	StateCache::Disable(GL_RASTERIZER_DISCARD);
+	StateCache::UseProgram(m_savedProgram);
+
+	GLuint triangles = 0;
+	glGetQueryObjectuiv(m_captureQuery, GL_QUERY_RESULT, &triangles);
+
+	static_assert(sizeof(MESH_VERTEX) == 8 * sizeof(float), "MESH_VERTEX must match the capture layout");
+	GLsizeiptr bytes = static_cast<GLsizeiptr>(triangles) * 3 * sizeof(MESH_VERTEX);
+	if (bytes >= CAPTURE_BUFFER_BYTES)
+	{
+		std::cout << "Mesh capture buffer is full, the mesh may be cut off" << std::endl;
+		bytes = CAPTURE_BUFFER_BYTES;
+		triangles = static_cast<GLuint>(bytes / (3 * sizeof(MESH_VERTEX)));
+	}
+
+	vertices.resize(static_cast<size_t>(triangles) * 3);
+	glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, m_captureBuffer);
+	glGetBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, 0, bytes, vertices.data());
+	glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+}
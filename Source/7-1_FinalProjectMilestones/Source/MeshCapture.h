@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshcapture.h
+// ============
+// copy the triangles of a ShapeMeshes draw back from OpenGL
+//
+//  ShapeMeshes keeps its vertex data on the GPU only. Between Begin() and
+//  End() the OpenGL draws run through a transform feedback program with the
+//  rasterizer off, so the triangles land in a buffer instead of the screen
+//  and are read back exactly as ShapeMeshes generated them.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class MeshCapture
+{
+public:
+	// vertex layout of the ShapeMeshes vertex buffers
+	struct MESH_VERTEX
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 uv;
+	};
+
+	// constructor
+	MeshCapture();
+	// destructor
+	~MeshCapture();
+
+	// create the transform feedback program, buffer and query
+	bool Create();
+	// free the capture objects
+	void Destroy();
+	// true between Create() and Destroy()
+	bool IsCreated() const { return m_captureProgram != 0; }
+
+	// send the following OpenGL draws into the capture buffer
+	void Begin();
+	// stop the capture and copy out the triangles, fans and strips
+	// arrive as separate triangles
+	void End(std::vector<MESH_VERTEX>& vertices);
+
+private:
+	GLuint m_captureProgram;
+	GLuint m_captureBuffer;
+	GLuint m_captureQuery;
+	// program in use before Begin(), restored by End()
+	GLuint m_savedProgram;
+};
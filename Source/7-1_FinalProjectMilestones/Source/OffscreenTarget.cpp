@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+// offscreentarget.cpp
+// ============
+// render the 3D scene into a framebuffer object instead of a display window
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OffscreenTarget.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  OffscreenTarget()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OffscreenTarget::OffscreenTarget()
+{
+	m_framebufferID = 0;
+	m_colorBufferID = 0;
+	m_depthBufferID = 0;
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  ~OffscreenTarget()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+OffscreenTarget::~OffscreenTarget()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the framebuffer object
+ *  with an RGBA8 color attachment and a 24-bit depth
+ *  attachment of the passed in size.
+ ***********************************************************/
+bool OffscreenTarget::Create(int width, int height)
+{
+	Destroy();
+
+	m_width = width;
+	m_height = height;
+
+	// color buffer that the scene is rendered into
+	glGenRenderbuffers(1, &m_colorBufferID);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	// depth buffer for the z-depth testing
+	glGenRenderbuffers(1, &m_depthBufferID);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebufferID);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBufferID);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Offscreen framebuffer is incomplete, status:" << std::hex << status << std::dec << std::endl;
+		Destroy();
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the framebuffer object
+ *  and its attachments.
+ ***********************************************************/
+void OffscreenTarget::Destroy()
+{
+	if (m_framebufferID != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebufferID);
+		m_framebufferID = 0;
+	}
+	if (m_colorBufferID != 0)
+	{
+		glDeleteRenderbuffers(1, &m_colorBufferID);
+		m_colorBufferID = 0;
+	}
+	if (m_depthBufferID != 0)
+	{
+		glDeleteRenderbuffers(1, &m_depthBufferID);
+		m_depthBufferID = 0;
+	}
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for making the framebuffer the
+ *  target of the following draw commands.
+ ***********************************************************/
+void OffscreenTarget::Bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glViewport(0, 0, m_width, m_height);
+}
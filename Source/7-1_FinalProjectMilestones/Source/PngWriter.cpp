@@ -0,0 +1,178 @@
+///////////////////////////////////////////////////////////////////////////////
+// pngwriter.cpp
+// ============
+// save rendered frames as PNG image files
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PngWriter.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#ifdef SCENE_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+// declaration of global variables and helper functions
+namespace
+{
+	// largest payload of one uncompressed deflate block
+	const size_t MAX_STORED_BLOCK = 65535;
+
+	// build the lookup table of the PNG chunk checksum
+	std::vector<uint32_t> BuildCrcTable()
+	{
+		std::vector<uint32_t> table(256);
+		for (uint32_t n = 0; n < 256; n++)
+		{
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++)
+			{
+				c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+			}
+			table[n] = c;
+		}
+		return table;
+	}
+
+	// get the PNG chunk checksum of the passed in bytes
+	uint32_t Crc32(const unsigned char* data, size_t length)
+	{
+		// built once, also when worker threads encode at the same time
+		static const std::vector<uint32_t> table = BuildCrcTable();
+
+		uint32_t crc = 0xFFFFFFFFu;
+		for (size_t i = 0; i < length; i++)
+		{
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return crc ^ 0xFFFFFFFFu;
+	}
+
+	// append a 32-bit big-endian value
+	void PutUint32(std::vector<unsigned char>& buffer, uint32_t value)
+	{
+		buffer.push_back(static_cast<unsigned char>(value >> 24));
+		buffer.push_back(static_cast<unsigned char>(value >> 16));
+		buffer.push_back(static_cast<unsigned char>(value >> 8));
+		buffer.push_back(static_cast<unsigned char>(value));
+	}
+
+	// write one length, type, data and checksum chunk
+	void WriteChunk(FILE* file, const char* type, const std::vector<unsigned char>& data)
+	{
+		std::vector<unsigned char> chunk;
+		PutUint32(chunk, static_cast<uint32_t>(data.size()));
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data.begin(), data.end());
+		PutUint32(chunk, Crc32(chunk.data() + 4, chunk.size() - 4));
+		fwrite(chunk.data(), 1, chunk.size(), file);
+	}
+
+	// wrap the passed in bytes into a zlib stream
+	std::vector<unsigned char> Deflate(const std::vector<unsigned char>& raw)
+	{
+		std::vector<unsigned char> stream;
+#ifdef SCENE_HAVE_ZLIB
+		uLongf streamLength = compressBound(static_cast<uLong>(raw.size()));
+		stream.resize(streamLength);
+		if (compress2(stream.data(), &streamLength, raw.data(),
+			static_cast<uLong>(raw.size()), Z_BEST_SPEED) == Z_OK)
+		{
+			stream.resize(streamLength);
+			return stream;
+		}
+		stream.clear();
+#endif
+		// zlib header without compression, then stored deflate blocks
+		stream.push_back(0x78);
+		stream.push_back(0x01);
+		size_t offset = 0;
+		do
+		{
+			size_t blockLength = raw.size() - offset;
+			if (blockLength > MAX_STORED_BLOCK)
+			{
+				blockLength = MAX_STORED_BLOCK;
+			}
+			bool bLastBlock = (offset + blockLength >= raw.size());
+			stream.push_back(bLastBlock ? 1 : 0);
+			stream.push_back(static_cast<unsigned char>(blockLength));
+			stream.push_back(static_cast<unsigned char>(blockLength >> 8));
+			stream.push_back(static_cast<unsigned char>(~blockLength));
+			stream.push_back(static_cast<unsigned char>(~blockLength >> 8));
+			stream.insert(stream.end(), raw.begin() + offset, raw.begin() + offset + blockLength);
+			offset += blockLength;
+		} while (offset < raw.size());
+
+		// adler-32 checksum of the uncompressed bytes
+		uint32_t a = 1;
+		uint32_t b = 0;
+		for (unsigned char byte : raw)
+		{
+			a = (a + byte) % 65521;
+			b = (b + a) % 65521;
+		}
+		PutUint32(stream, (b << 16) | a);
+
+		return stream;
+	}
+}
+
+/***********************************************************
+ *  Write()
+ *
+ *  This function is used for writing the passed in pixels
+ *  as a PNG file. Each row is stored with the "up" filter,
+ *  which suits the smooth shading of rendered frames.
+ ***********************************************************/
+bool PngWriter::Write(const char* filename, int width, int height, int channels,
+	const unsigned char* pixels)
+{
+	if ((channels != 3) && (channels != 4))
+	{
+		return false;
+	}
+
+	// filter byte plus the difference to the row above for every row
+	size_t rowLength = static_cast<size_t>(width) * channels;
+	std::vector<unsigned char> raw((rowLength + 1) * height);
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* row = pixels + rowLength * y;
+		unsigned char* filtered = &raw[(rowLength + 1) * y];
+		filtered[0] = 2;
+		for (size_t x = 0; x < rowLength; x++)
+		{
+			unsigned char above = (y > 0) ? row[x - rowLength] : 0;
+			filtered[x + 1] = static_cast<unsigned char>(row[x] - above);
+		}
+	}
+
+	FILE* file = fopen(filename, "wb");
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	static const unsigned char signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+	fwrite(signature, 1, sizeof(signature), file);
+
+	std::vector<unsigned char> header;
+	PutUint32(header, static_cast<uint32_t>(width));
+	PutUint32(header, static_cast<uint32_t>(height));
+	header.push_back(8);
+	header.push_back(channels == 4 ? 6 : 2);
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+	WriteChunk(file, "IHDR", header);
+	WriteChunk(file, "IDAT", Deflate(raw));
+	WriteChunk(file, "IEND", std::vector<unsigned char>());
+
+	bool bWritten = (ferror(file) == 0);
+	fclose(file);
+
+	return bWritten;
+}
@@ -0,0 +1,18 @@
+///////////////////////////////////////////////////////////////////////////////
+// pngwriter.h
+// ============
+// save rendered frames as PNG image files
+//
+//  Images are deflated with zlib when the build defines SCENE_HAVE_ZLIB,
+//  otherwise they are written with uncompressed deflate blocks, which every
+//  PNG reader accepts but which makes the files about as large as the pixels.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+namespace PngWriter
+{
+	// write 8-bit RGB or RGBA pixels, top row first, to a PNG file
+	bool Write(const char* filename, int width, int height, int channels,
+		const unsigned char* pixels);
+}
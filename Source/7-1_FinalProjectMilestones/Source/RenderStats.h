@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderstats.h
+// ============
+// per-frame counters for the work the scene sends to OpenGL
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <ostream>
+
+namespace RenderStats
+{
+	// basic shapes drawn through TrackedShapeMeshes
+	enum MESH_TYPE
+	{
+		MESH_BOX,
+		MESH_CONE,
+		MESH_CYLINDER,
+		MESH_PLANE,
+		MESH_PRISM,
+		MESH_PYRAMID4,
+		MESH_SPHERE,
+		MESH_TAPERED_CYLINDER,
+		MESH_TORUS,
+		MESH_TYPE_COUNT
+	};
+
+	struct FRAME_STATS
+	{
+		// ShapeMeshes draw submissions, in total and per shape
+		int drawCalls;
+		int meshDraws[MESH_TYPE_COUNT];
+		// objects drawn by instanced draw calls, each of which counts as one draw call
+		int drawnInstances;
+		// commands of the multi-draw calls, the call itself counts as one draw call
+		int multiDrawCommands;
+		// objects merged into the baked meshes drawn, each mesh counts as one draw call
+		int bakedObjects;
+		// ShaderManager set*Value calls
+		int uniformUploads;
+		// uploads dropped because the uniform already had the value
+		int redundantUniformUploads;
+		// buffer writes of the camera and light uniform blocks
+		int uniformBlockWrites;
+		// frames that had to wait for the GPU before reusing a ring buffer region
+		int ringBufferWaits;
+		// glActiveTexture and glBindTexture calls
+		int activeTextureChanges;
+		int textureBinds;
+		// state changes asked of the StateCache, and those it dropped
+		// because OpenGL already held the value
+		int stateChanges;
+		int skippedStateChanges;
+		// material and texture switches between consecutive scene draws
+		int materialChanges;
+		int textureChanges;
+	};
+
+	// clear the counters for the frame about to be rendered
+	void BeginFrame();
+	// keep the counters of the frame that was just rendered
+	void EndFrame();
+	// get the counters of the last completed frame
+	const FRAME_STATS& GetLastFrame();
+	// write the passed in counters as one JSON object
+	void WriteJSON(std::ostream& output, const FRAME_STATS& stats);
+
+	// get the share of the state changes that were skipped
+	double GetStateSkipRatio(const FRAME_STATS& stats);
+	// get the display name of a mesh type
+	const char* GetMeshTypeName(int meshType);
+
+	// counting hooks called by the tracked shader manager and meshes
+	void CountDrawCall(MESH_TYPE meshType);
+	void CountInstances(int instanceCount);
+	void CountMultiDraw(int commandCount);
+	void CountBakedDraw(int objectCount);
+	void CountUniformUpload(bool bRedundant);
+	void CountUniformBlockWrite();
+	void CountRingBufferWait();
+	void CountActiveTexture();
+	void CountTextureBind();
+	void CountStateChange(bool bSkipped);
+	void CountMaterialChange();
+	void CountTextureChange();
+}
@@ -0,0 +1,198 @@
+///////////////////////////////////////////////////////////////////////////////
+// ringbuffer.cpp
+// ============
+// persistently mapped buffer for data the renderer writes every frame
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RingBuffer.h"
+#include "RenderStats.h"
+#include "Trace.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// how long one wait on a region fence may take before it is retried
+	const GLuint64 FENCE_WAIT_NANOSECONDS = 1000000;
+}
+
+/***********************************************************
+ *  RingBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RingBuffer::RingBuffer()
+{
+	m_bufferID = 0;
+	m_pMapped = NULL;
+	m_frameBytes = 0;
+	m_frame = 0;
+	m_frameUsed = 0;
+}
+
+/***********************************************************
+ *  ~RingBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RingBuffer::~RingBuffer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking for glBufferStorage,
+ *  which is core in OpenGL 4.4 and otherwise comes from the
+ *  ARB_buffer_storage extension.
+ ***********************************************************/
+bool RingBuffer::IsSupported()
+{
+	return (GLEW_VERSION_4_4 == GL_TRUE) || (GLEW_ARB_buffer_storage == GL_TRUE);
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the buffer with room
+ *  for every frame in flight and mapping it for good. The
+ *  mapping is coherent, so writes reach the GPU without a
+ *  flush.
+ ***********************************************************/
+bool RingBuffer::Create(GLsizeiptr frameBytes, int frameCount)
+{
+	Destroy();
+	if ((IsSupported() == false) || (frameBytes <= 0) || (frameCount <= 0))
+	{
+		return false;
+	}
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	GLsizeiptr totalBytes = frameBytes * frameCount;
+	glGenBuffers(1, &m_bufferID);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_bufferID);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, totalBytes, NULL, flags);
+	m_pMapped = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, totalBytes, flags));
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	if (m_pMapped == NULL)
+	{
+		std::cout << "Could not map the ring buffer" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	m_frameBytes = frameBytes;
+	m_frame = 0;
+	m_frameUsed = 0;
+	m_fences.assign(frameCount, static_cast<GLsync>(0));
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for waiting for the frames still in
+ *  flight and then unmapping and freeing the buffer.
+ ***********************************************************/
+void RingBuffer::Destroy()
+{
+	for (GLsync& fence : m_fences)
+	{
+		if (fence != 0)
+		{
+			glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(fence);
+			fence = 0;
+		}
+	}
+	m_fences.clear();
+
+	if (m_bufferID != 0)
+	{
+		if (m_pMapped != NULL)
+		{
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_bufferID);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			m_pMapped = NULL;
+		}
+		glDeleteBuffers(1, &m_bufferID);
+		m_bufferID = 0;
+	}
+	m_frameBytes = 0;
+	m_frameUsed = 0;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for fencing the region the last
+ *  frame wrote, after all of its draws were sent, and for
+ *  moving on to the next region. A region the GPU may still
+ *  read is waited for before it is handed out again.
+ ***********************************************************/
+void RingBuffer::BeginFrame()
+{
+	if (m_bufferID == 0)
+	{
+		return;
+	}
+
+	if (m_frameUsed > 0)
+	{
+		m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	m_frame = (m_frame + 1) % static_cast<int>(m_fences.size());
+	m_frameUsed = 0;
+
+	GLsync& fence = m_fences[m_frame];
+	if (fence == 0)
+	{
+		return;
+	}
+
+	// the first check does not block, later ones flush so the fence is sure to signal
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED)
+	{
+		TRACE_ZONE("RingBufferWait");
+		RenderStats::CountRingBufferWait();
+		do
+		{
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_WAIT_NANOSECONDS);
+		} while (result == GL_TIMEOUT_EXPIRED);
+	}
+	glDeleteSync(fence);
+	fence = 0;
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for reserving bytes in the region of
+ *  this frame. The returned pointer is written directly,
+ *  and the range at offset is bound to read it back.
+ ***********************************************************/
+void* RingBuffer::Allocate(GLsizeiptr size, GLsizeiptr alignment, GLintptr& offset)
+{
+	if (m_bufferID == 0)
+	{
+		return NULL;
+	}
+
+	GLsizeiptr start = m_frameUsed;
+	if (alignment > 1)
+	{
+		start = (start + alignment - 1) / alignment * alignment;
+	}
+	if (start + size > m_frameBytes)
+	{
+		return NULL;
+	}
+
+	m_frameUsed = start + size;
+	offset = static_cast<GLintptr>(m_frame) * m_frameBytes + start;
+	return m_pMapped + offset;
+}
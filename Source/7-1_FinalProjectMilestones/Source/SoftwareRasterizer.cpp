@@ -0,0 +1,999 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerasterizer.cpp
+// ============
+// render the scene on the CPU for hosts without a GPU
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SoftwareRasterizer.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define SOFTWARE_RASTER_SSE2 1
+#else
+#define SOFTWARE_RASTER_SSE2 0
+#endif
+
+// declaration of global variables and helper functions
+namespace
+{
+	// width and height of the screen tiles in pixels, a multiple of 4
+	const int TILE_SIZE = 64;
+	// visibility buffer entry of a pixel no triangle covers
+	const uint32_t NO_TRIANGLE = 0xFFFFFFFFu;
+	// visibility entries hold the chunk in the top 8 bits and the
+	// triangle of the chunk below, chunk 255 is left for NO_TRIANGLE
+	const int MAX_CHUNKS = 255;
+	const int MAX_CHUNK_TRIANGLES = 1 << 23;
+	const uint32_t EXTRA_VERTEX = 0x80000000u;
+	// set the screen position, depth and 1/w of a transformed vertex
+	template <typename VERTEX> void ProjectVertex(VERTEX& vertex, int width, int height)
+	{
+		float invW = 1.0f / vertex.clip.w;
+		vertex.screen.x = (vertex.clip.x * invW * 0.5f + 0.5f) * width;
+		vertex.screen.y = (vertex.clip.y * invW * 0.5f + 0.5f) * height;
+		vertex.screen.z = vertex.clip.z * invW * 0.5f + 0.5f;
+		vertex.screen.w = invW;
+	}
+
+	// edge function E(x, y) = A * x + B * y + C of one triangle edge
+	struct EDGE
+	{
+		float A;
+		float B;
+		float C;
+		// pixel centers exactly on the edge belong to the triangle
+		bool bInclusive;
+	};
+
+	// set up the edges of a triangle so they are positive inside, returns
+	// twice the triangle area or 0 when the triangle covers no area
+	float SetupEdges(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, EDGE edges[3])
+	{
+		// edge i lies opposite vertex i, so E_i / area is the weight of vertex i
+		const glm::vec4* points[3] = { &a, &b, &c };
+		float area = 0.0f;
+		for (int i = 0; i < 3; i++)
+		{
+			const glm::vec4& p = *points[(i + 1) % 3];
+			const glm::vec4& q = *points[(i + 2) % 3];
+			edges[i].A = p.y - q.y;
+			edges[i].B = q.x - p.x;
+			edges[i].C = p.x * q.y - p.y * q.x;
+			area += edges[i].C;
+		}
+
+		if ((area == 0.0f) || (std::isfinite(area) == false))
+		{
+			return 0.0f;
+		}
+		float orientation = (area < 0.0f) ? -1.0f : 1.0f;
+		for (int i = 0; i < 3; i++)
+		{
+			edges[i].A *= orientation;
+			edges[i].B *= orientation;
+			edges[i].C *= orientation;
+			// a shared edge is inclusive for exactly one of its two triangles
+			edges[i].bInclusive = (edges[i].A > 0.0f) || ((edges[i].A == 0.0f) && (edges[i].B > 0.0f));
+		}
+
+		return area * orientation;
+	}
+}
+
+/***********************************************************
+ *  SoftwareRasterizer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SoftwareRasterizer::SoftwareRasterizer(TrackedShaderManager* pShaderManager)
+{
+	m_pShaderManager = pShaderManager;
+	m_width = 0;
+	m_height = 0;
+	m_tilesX = 0;
+	m_tilesY = 0;
+	m_pCaptureMesh = NULL;
+	m_totalVertices = 0;
+	m_chunkTriangles = 0;
+	m_pJob = NULL;
+	m_jobCount = 0;
+	m_nextJob = 0;
+	m_activeWorkers = 0;
+	m_generation = 0;
+	m_bStopWorkers = false;
+	std::fill(m_unitTextures, m_unitTextures + TEXTURE_UNITS, -2);
+}
+
+/***********************************************************
+ *  ~SoftwareRasterizer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for allocating the image, creating
+ *  the transform feedback program that captures the meshes,
+ *  and starting the tile threads.
+ ***********************************************************/
+bool SoftwareRasterizer::Create(int width, int height, int threadCount)
+{
+	Destroy();
+
+	m_width = width;
+	m_height = height;
+	m_tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	m_tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+	m_pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+
+	if (m_capture.Create() == false)
+	{
+		Destroy();
+		return false;
+	}
+
+	if (threadCount <= 0)
+	{
+		threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+	m_tileBuffers.resize(threadCount);
+	for (TILE_BUFFER& buffer : m_tileBuffers)
+	{
+		buffer.depth.resize(TILE_SIZE * TILE_SIZE);
+		buffer.triangle.resize(TILE_SIZE * TILE_SIZE);
+	}
+
+	m_bStopWorkers = false;
+	for (int worker = 1; worker < threadCount; worker++)
+	{
+		m_workers.emplace_back(&SoftwareRasterizer::WorkerLoop, this, worker);
+	}
+
+	std::cout << "INFO: Software rasterizer " << width << "x" << height << " on " << threadCount
+		<< " threads" << (SOFTWARE_RASTER_SSE2 ? " with SSE2" : "") << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for stopping the tile threads and
+ *  freeing the capture objects, meshes and textures.
+ ***********************************************************/
+void SoftwareRasterizer::Destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_poolMutex);
+		m_bStopWorkers = true;
+	}
+	m_poolChanged.notify_all();
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+
+	m_capture.Destroy();
+	m_meshes.clear();
+	m_textures.clear();
+	m_textureNames.clear();
+	m_draws.clear();
+	m_tileBuffers.clear();
+	std::fill(m_unitTextures, m_unitTextures + TEXTURE_UNITS, -2);
+}
+
+/***********************************************************
+ *  SubmitDraw()
+ *
+ *  This method is used for recording a draw of a mesh with
+ *  the shader settings the scene has made for it. The first
+ *  draw of each mesh variant starts a transform feedback
+ *  capture and lets the OpenGL draw run into it.
+ ***********************************************************/
+bool SoftwareRasterizer::SubmitDraw(RenderStats::MESH_TYPE meshType, int variant)
+{
+	int meshKey = meshType * 8 + variant;
+	bool bCapture = (m_meshes.find(meshKey) == m_meshes.end()) && m_capture.IsCreated();
+	std::vector<MESH_VERTEX>& vertices = m_meshes[meshKey];
+
+	// start from the defaults of the shader for anything never set
+	glm::mat4 view(1.0f);
+	glm::mat4 projection(1.0f);
+	float useLighting = 0.0f;
+	float useTexture = 0.0f;
+	float textureUnit = 0.0f;
+
+	DRAW_ITEM draw;
+	draw.pVertices = &vertices;
+	draw.firstVertex = 0;
+	draw.model = glm::mat4(1.0f);
+	draw.viewPosition = glm::vec3(0.0f);
+	draw.objectColor = glm::vec4(1.0f);
+	draw.uvScale = glm::vec2(1.0f);
+
+	m_pShaderManager->GetUniformValue("model", &draw.model[0][0], 16);
+	m_pShaderManager->GetUniformValue("view", &view[0][0], 16);
+	m_pShaderManager->GetUniformValue("projection", &projection[0][0], 16);
+	m_pShaderManager->GetUniformValue("viewPosition", &draw.viewPosition[0], 3);
+	m_pShaderManager->GetUniformValue("bUseLighting", &useLighting, 1);
+	m_pShaderManager->GetUniformValue("bUseTexture", &useTexture, 1);
+	m_pShaderManager->GetUniformValue("objectTexture", &textureUnit, 1);
+	m_pShaderManager->GetUniformValue("objectColor", &draw.objectColor[0], 4);
+	m_pShaderManager->GetUniformValue("UVscale", &draw.uvScale[0], 2);
+
+	draw.normalMatrix = glm::transpose(glm::inverse(glm::mat3(draw.model)));
+	draw.viewProjection = projection * view;
+	draw.bUseLighting = (useLighting != 0.0f);
+	draw.bUseTexture = (useTexture != 0.0f);
+	draw.texture = draw.bUseTexture ? GetUnitTexture(static_cast<int>(textureUnit)) : -1;
+	draw.lightCount = 0;
+	if (draw.bUseLighting == true)
+	{
+		SetupLights(draw);
+	}
+	m_draws.push_back(draw);
+
+	if (bCapture == false)
+	{
+		return false;
+	}
+
+	// the draw that follows goes into the capture buffer instead of the screen
+	m_pCaptureMesh = &vertices;
+	m_capture.Begin();
+
+	return true;
+}
+
+/***********************************************************
+ *  EndMeshCapture()
+ *
+ *  This method is used for copying the triangles that the
+ *  OpenGL draw wrote into the capture buffer. Fans and
+ *  strips arrive as separate triangles.
+ ***********************************************************/
+void SoftwareRasterizer::EndMeshCapture()
+{
+	if (m_pCaptureMesh == NULL)
+	{
+		return;
+	}
+
+	m_capture.End(*m_pCaptureMesh);
+	m_pCaptureMesh = NULL;
+}
+
+/***********************************************************
+ *  GetUnitTexture()
+ *
+ *  This method is used for finding the software copy of
+ *  the texture bound to a texture unit. A texture is read
+ *  back from OpenGL the first time it is used.
+ ***********************************************************/
+int SoftwareRasterizer::GetUnitTexture(int unit)
+{
+	if ((unit < 0) || (unit >= TEXTURE_UNITS))
+	{
+		return -1;
+	}
+	if (m_unitTextures[unit] != -2)
+	{
+		return m_unitTextures[unit];
+	}
+
+	GLint activeTexture = GL_TEXTURE0;
+	GLint textureName = 0;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &textureName);
+
+	int texture = -1;
+	if (textureName != 0)
+	{
+		std::unordered_map<GLuint, int>::iterator found = m_textureNames.find(textureName);
+		if (found != m_textureNames.end())
+		{
+			texture = found->second;
+		}
+		else
+		{
+			TEXTURE copy;
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &copy.width);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &copy.height);
+			copy.texels.resize(static_cast<size_t>(copy.width) * copy.height * 4);
+			glPixelStorei(GL_PACK_ALIGNMENT, 1);
+			glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, copy.texels.data());
+
+			texture = static_cast<int>(m_textures.size());
+			m_textures.push_back(std::move(copy));
+			m_textureNames[textureName] = texture;
+		}
+	}
+	glActiveTexture(activeTexture);
+
+	m_unitTextures[unit] = texture;
+	return texture;
+}
+
+/***********************************************************
+ *  ForgetTexture()
+ *
+ *  This method is used for dropping the software copy of a
+ *  deleted texture, so a new texture that gets the same name
+ *  is read back instead of sampling the old copy.
+ ***********************************************************/
+void SoftwareRasterizer::ForgetTexture(GLuint texture)
+{
+	std::unordered_map<GLuint, int>::iterator found = m_textureNames.find(texture);
+	if (found == m_textureNames.end())
+	{
+		return;
+	}
+
+	// draws waiting for Render() may still sample the copy, so its
+	// texels are only freed when there are none
+	if (m_draws.empty() == true)
+	{
+		TEXTURE& copy = m_textures[found->second];
+		copy.width = 0;
+		copy.height = 0;
+		std::vector<unsigned char>().swap(copy.texels);
+	}
+	m_textureNames.erase(found);
+	std::fill(m_unitTextures, m_unitTextures + TEXTURE_UNITS, -2);
+}
+
+/***********************************************************
+ *  SetupLights()
+ *
+ *  This method is used for reading the light and material
+ *  uniforms of a draw. The ambient part is the same for
+ *  every pixel, and lights with no diffuse or specular
+ *  color are left out of the per pixel loop.
+ ***********************************************************/
+void SoftwareRasterizer::SetupLights(DRAW_ITEM& draw)
+{
+	glm::vec3 ambientColor(0.0f);
+	float ambientStrength = 0.0f;
+	glm::vec3 diffuseColor(0.0f);
+	glm::vec3 specularColor(0.0f);
+	m_pShaderManager->GetUniformValue("material.ambientColor", &ambientColor[0], 3);
+	m_pShaderManager->GetUniformValue("material.ambientStrength", &ambientStrength, 1);
+	m_pShaderManager->GetUniformValue("material.diffuseColor", &diffuseColor[0], 3);
+	m_pShaderManager->GetUniformValue("material.specularColor", &specularColor[0], 3);
+
+	draw.ambient = glm::vec3(0.0f);
+	draw.lightCount = 0;
+	char name[64];
+	for (int i = 0; i < TOTAL_LIGHTS; i++)
+	{
+		glm::vec3 lightPosition(0.0f);
+		glm::vec3 lightAmbient(0.0f);
+		glm::vec3 lightDiffuse(0.0f);
+		glm::vec3 lightSpecular(0.0f);
+		float focalStrength = 0.0f;
+		float specularIntensity = 0.0f;
+
+		snprintf(name, sizeof(name), "lightSources[%d].position", i);
+		m_pShaderManager->GetUniformValue(name, &lightPosition[0], 3);
+		snprintf(name, sizeof(name), "lightSources[%d].ambientColor", i);
+		m_pShaderManager->GetUniformValue(name, &lightAmbient[0], 3);
+		snprintf(name, sizeof(name), "lightSources[%d].diffuseColor", i);
+		m_pShaderManager->GetUniformValue(name, &lightDiffuse[0], 3);
+		snprintf(name, sizeof(name), "lightSources[%d].specularColor", i);
+		m_pShaderManager->GetUniformValue(name, &lightSpecular[0], 3);
+		snprintf(name, sizeof(name), "lightSources[%d].focalStrength", i);
+		m_pShaderManager->GetUniformValue(name, &focalStrength, 1);
+		snprintf(name, sizeof(name), "lightSources[%d].specularIntensity", i);
+		m_pShaderManager->GetUniformValue(name, &specularIntensity, 1);
+
+		draw.ambient += ambientStrength * ambientColor + lightAmbient;
+
+		DRAW_LIGHT& light = draw.lights[draw.lightCount];
+		light.position = lightPosition;
+		light.diffuse = lightDiffuse * diffuseColor;
+		light.specular = specularIntensity * specularColor * lightSpecular;
+		light.focalStrength = focalStrength;
+		if ((light.diffuse != glm::vec3(0.0f)) || (light.specular != glm::vec3(0.0f)))
+		{
+			draw.lightCount++;
+		}
+	}
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used for rasterizing the recorded draws.
+ *  The vertices of all draws are transformed in parallel,
+ *  the triangles are clipped and sorted into the tiles they
+ *  touch in parallel chunks, and then every tile is
+ *  rasterized and shaded by one thread.
+ ***********************************************************/
+void SoftwareRasterizer::Render()
+{
+	TRACE_ZONE("SoftwareRender");
+
+	m_totalVertices = 0;
+	for (DRAW_ITEM& draw : m_draws)
+	{
+		draw.firstVertex = m_totalVertices;
+		m_totalVertices += static_cast<uint32_t>(draw.pVertices->size());
+	}
+	m_clipVertices.resize(m_totalVertices);
+
+	{
+		TRACE_ZONE("SoftwareTransform");
+		RunParallel(static_cast<int>(m_draws.size()), [this](int drawIndex, int) { TransformDraw(drawIndex); });
+	}
+
+	// a few chunks per thread so the binning stays balanced
+	int triangleCount = static_cast<int>(m_totalVertices / 3);
+	int chunkCount = std::max(static_cast<int>(m_tileBuffers.size()) * 4, triangleCount / MAX_CHUNK_TRIANGLES + 1);
+	chunkCount = std::min(chunkCount, MAX_CHUNKS);
+	m_chunkTriangles = std::max(1, (triangleCount + chunkCount - 1) / chunkCount);
+	m_chunks.resize(chunkCount);
+	{
+		TRACE_ZONE("SoftwareBinning");
+		RunParallel(chunkCount, [this](int chunkIndex, int) { SetupChunk(chunkIndex); });
+	}
+
+	{
+		TRACE_ZONE("SoftwareTiles");
+		RunParallel(m_tilesX * m_tilesY, [this](int tileIndex, int worker) { RenderTile(tileIndex, worker); });
+	}
+
+	m_draws.clear();
+	std::fill(m_unitTextures, m_unitTextures + TEXTURE_UNITS, -2);
+}
+
+/***********************************************************
+ *  TransformDraw()
+ *
+ *  This method is used for running the vertex shader of
+ *  vertexShader.glsl on the vertices of one draw.
+ ***********************************************************/
+void SoftwareRasterizer::TransformDraw(int drawIndex)
+{
+	const DRAW_ITEM& draw = m_draws[drawIndex];
+	glm::mat4 modelViewProjection = draw.viewProjection * draw.model;
+
+	CLIP_VERTEX* pOutput = &m_clipVertices[draw.firstVertex];
+	for (const MESH_VERTEX& vertex : *draw.pVertices)
+	{
+		glm::vec4 position(vertex.position, 1.0f);
+		pOutput->clip = modelViewProjection * position;
+		pOutput->world = glm::vec3(draw.model * position);
+		pOutput->normal = draw.normalMatrix * vertex.normal;
+		pOutput->uv = vertex.uv;
+		if (pOutput->clip.w > 0.0f)
+		{
+			ProjectVertex(*pOutput, m_width, m_height);
+		}
+		pOutput++;
+	}
+}
+
+/***********************************************************
+ *  SetupChunk()
+ *
+ *  This method is used for clipping a range of triangles
+ *  against the near plane and adding them to the lists of
+ *  the tiles they touch.
+ ***********************************************************/
+void SoftwareRasterizer::SetupChunk(int chunkIndex)
+{
+	CHUNK& chunk = m_chunks[chunkIndex];
+	chunk.triangles.clear();
+	chunk.extraVertices.clear();
+	chunk.tiles.resize(m_tilesX * m_tilesY);
+	for (std::vector<uint32_t>& tile : chunk.tiles)
+	{
+		tile.clear();
+	}
+
+	uint32_t firstTriangle = static_cast<uint32_t>(chunkIndex) * m_chunkTriangles;
+	uint32_t endTriangle = std::min(firstTriangle + m_chunkTriangles, m_totalVertices / 3);
+	if (firstTriangle >= endTriangle)
+	{
+		return;
+	}
+
+	// the draw holding the first triangle, later draws follow in order
+	uint32_t drawIndex = static_cast<uint32_t>(std::upper_bound(m_draws.begin(), m_draws.end(), firstTriangle * 3,
+		[](uint32_t vertex, const DRAW_ITEM& draw) { return vertex < draw.firstVertex; }) - m_draws.begin()) - 1;
+
+	for (uint32_t triangleIndex = firstTriangle; triangleIndex < endTriangle; triangleIndex++)
+	{
+		uint32_t firstVertex = triangleIndex * 3;
+		while ((drawIndex + 1 < m_draws.size()) && (firstVertex >= m_draws[drawIndex + 1].firstVertex))
+		{
+			drawIndex++;
+		}
+
+		const CLIP_VERTEX* vertices[3] = {
+			&m_clipVertices[firstVertex], &m_clipVertices[firstVertex + 1], &m_clipVertices[firstVertex + 2] };
+		int insideCount = 0;
+		for (const CLIP_VERTEX* pVertex : vertices)
+		{
+			insideCount += (pVertex->clip.z + pVertex->clip.w >= 0.0f) ? 1 : 0;
+		}
+
+		if (insideCount == 3)
+		{
+			TRIANGLE triangle = { { firstVertex, firstVertex + 1, firstVertex + 2 }, drawIndex };
+			BinTriangle(chunk, triangle);
+		}
+		else if (insideCount > 0)
+		{
+			ClipTriangle(chunk, drawIndex, vertices);
+		}
+	}
+}
+
+/***********************************************************
+ *  ClipTriangle()
+ *
+ *  This method is used for cutting off the part of a
+ *  triangle in front of the near plane, which leaves a
+ *  triangle or a quad to bin as two triangles.
+ ***********************************************************/
+void SoftwareRasterizer::ClipTriangle(CHUNK& chunk, uint32_t drawIndex, const CLIP_VERTEX* vertices[3])
+{
+	CLIP_VERTEX polygon[4];
+	int count = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		const CLIP_VERTEX& a = *vertices[i];
+		const CLIP_VERTEX& b = *vertices[(i + 1) % 3];
+		float distanceA = a.clip.z + a.clip.w;
+		float distanceB = b.clip.z + b.clip.w;
+
+		if (distanceA >= 0.0f)
+		{
+			polygon[count++] = a;
+		}
+		if ((distanceA >= 0.0f) != (distanceB >= 0.0f))
+		{
+			float t = distanceA / (distanceA - distanceB);
+			CLIP_VERTEX& cut = polygon[count++];
+			cut.clip = glm::mix(a.clip, b.clip, t);
+			cut.world = glm::mix(a.world, b.world, t);
+			cut.normal = glm::mix(a.normal, b.normal, t);
+			cut.uv = glm::mix(a.uv, b.uv, t);
+			ProjectVertex(cut, m_width, m_height);
+		}
+	}
+
+	uint32_t first = static_cast<uint32_t>(chunk.extraVertices.size()) | EXTRA_VERTEX;
+	chunk.extraVertices.insert(chunk.extraVertices.end(), polygon, polygon + count);
+	for (int i = 1; i + 1 < count; i++)
+	{
+		TRIANGLE triangle = { { first, first + i, first + i + 1 }, drawIndex };
+		BinTriangle(chunk, triangle);
+	}
+}
+
+/***********************************************************
+ *  BinTriangle()
+ *
+ *  This method is used for adding a triangle to the lists
+ *  of the tiles its pixel bounds overlap.
+ ***********************************************************/
+void SoftwareRasterizer::BinTriangle(CHUNK& chunk, const TRIANGLE& triangle)
+{
+	const glm::vec4& a = GetVertex(chunk, triangle.vertices[0]).screen;
+	const glm::vec4& b = GetVertex(chunk, triangle.vertices[1]).screen;
+	const glm::vec4& c = GetVertex(chunk, triangle.vertices[2]).screen;
+
+	// behind the far plane or without area
+	if (((a.z > 1.0f) && (b.z > 1.0f) && (c.z > 1.0f)) ||
+		((b.x - a.x) * (c.y - a.y) == (b.y - a.y) * (c.x - a.x)))
+	{
+		return;
+	}
+
+	// pixels whose centers can be inside, clamped to the image
+	float minX = std::max(std::ceil(std::min(std::min(a.x, b.x), c.x) - 0.5f), 0.0f);
+	float maxX = std::min(std::floor(std::max(std::max(a.x, b.x), c.x) - 0.5f), m_width - 1.0f);
+	float minY = std::max(std::ceil(std::min(std::min(a.y, b.y), c.y) - 0.5f), 0.0f);
+	float maxY = std::min(std::floor(std::max(std::max(a.y, b.y), c.y) - 0.5f), m_height - 1.0f);
+	if ((minX > maxX) || (minY > maxY))
+	{
+		return;
+	}
+
+	uint32_t index = static_cast<uint32_t>(chunk.triangles.size());
+	chunk.triangles.push_back(triangle);
+
+	int firstTileX = static_cast<int>(minX) / TILE_SIZE;
+	int lastTileX = static_cast<int>(maxX) / TILE_SIZE;
+	int firstTileY = static_cast<int>(minY) / TILE_SIZE;
+	int lastTileY = static_cast<int>(maxY) / TILE_SIZE;
+	for (int tileY = firstTileY; tileY <= lastTileY; tileY++)
+	{
+		for (int tileX = firstTileX; tileX <= lastTileX; tileX++)
+		{
+			chunk.tiles[tileY * m_tilesX + tileX].push_back(index);
+		}
+	}
+}
+
+/***********************************************************
+ *  GetVertex()
+ *
+ *  This method is used for looking up a triangle vertex in
+ *  the transformed vertices or the clipped ones.
+ ***********************************************************/
+const SoftwareRasterizer::CLIP_VERTEX& SoftwareRasterizer::GetVertex(const CHUNK& chunk, uint32_t index) const
+{
+	if ((index & EXTRA_VERTEX) != 0)
+	{
+		return chunk.extraVertices[index & ~EXTRA_VERTEX];
+	}
+	return m_clipVertices[index];
+}
+
+/***********************************************************
+ *  RenderTile()
+ *
+ *  This method is used for rasterizing the triangles of a
+ *  tile into its depth and visibility buffers, four pixels
+ *  at a time, and then shading every visible pixel once.
+ ***********************************************************/
+void SoftwareRasterizer::RenderTile(int tileIndex, int worker)
+{
+	TILE_BUFFER& buffer = m_tileBuffers[worker];
+	int tileX = (tileIndex % m_tilesX) * TILE_SIZE;
+	int tileY = (tileIndex / m_tilesX) * TILE_SIZE;
+	int tileWidth = std::min(TILE_SIZE, m_width - tileX);
+	int tileHeight = std::min(TILE_SIZE, m_height - tileY);
+
+	std::fill(buffer.depth.begin(), buffer.depth.end(), 1.0f);
+	std::fill(buffer.triangle.begin(), buffer.triangle.end(), NO_TRIANGLE);
+
+	for (size_t chunkIndex = 0; chunkIndex < m_chunks.size(); chunkIndex++)
+	{
+		const CHUNK& chunk = m_chunks[chunkIndex];
+		for (uint32_t index : chunk.tiles[tileIndex])
+		{
+			const TRIANGLE& triangle = chunk.triangles[index];
+			const glm::vec4& a = GetVertex(chunk, triangle.vertices[0]).screen;
+			const glm::vec4& b = GetVertex(chunk, triangle.vertices[1]).screen;
+			const glm::vec4& c = GetVertex(chunk, triangle.vertices[2]).screen;
+
+			EDGE edges[3];
+			float area = SetupEdges(a, b, c, edges);
+			if (area == 0.0f)
+			{
+				continue;
+			}
+
+			// depth is linear in screen space, z = zA * x + zB * y + zC
+			float zA = (edges[0].A * a.z + edges[1].A * b.z + edges[2].A * c.z) / area;
+			float zB = (edges[0].B * a.z + edges[1].B * b.z + edges[2].B * c.z) / area;
+			float zC = (edges[0].C * a.z + edges[1].C * b.z + edges[2].C * c.z) / area;
+
+			int minX = std::max(static_cast<int>(std::ceil(std::min(std::min(a.x, b.x), c.x) - 0.5f)), tileX);
+			int maxX = std::min(static_cast<int>(std::floor(std::max(std::max(a.x, b.x), c.x) - 0.5f)), tileX + tileWidth - 1);
+			int minY = std::max(static_cast<int>(std::ceil(std::min(std::min(a.y, b.y), c.y) - 0.5f)), tileY);
+			int maxY = std::min(static_cast<int>(std::floor(std::max(std::max(a.y, b.y), c.y) - 0.5f)), tileY + tileHeight - 1);
+			// start on a 4 pixel boundary of the tile
+			minX = tileX + ((minX - tileX) & ~3);
+			uint32_t reference = (static_cast<uint32_t>(chunkIndex) << 24) | index;
+
+#if SOFTWARE_RASTER_SSE2
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 pixelOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+			const __m128 referenceValue = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(reference)));
+			const __m128 edgeA0 = _mm_set1_ps(edges[0].A);
+			const __m128 edgeA1 = _mm_set1_ps(edges[1].A);
+			const __m128 edgeA2 = _mm_set1_ps(edges[2].A);
+			const __m128 depthA = _mm_set1_ps(zA);
+
+			for (int y = minY; y <= maxY; y++)
+			{
+				float centerY = y + 0.5f;
+				__m128 row0 = _mm_set1_ps(edges[0].B * centerY + edges[0].C);
+				__m128 row1 = _mm_set1_ps(edges[1].B * centerY + edges[1].C);
+				__m128 row2 = _mm_set1_ps(edges[2].B * centerY + edges[2].C);
+				__m128 depthRow = _mm_set1_ps(zB * centerY + zC);
+				float* pDepth = &buffer.depth[(y - tileY) * TILE_SIZE - tileX];
+				uint32_t* pTriangle = &buffer.triangle[(y - tileY) * TILE_SIZE - tileX];
+
+				for (int x = minX; x <= maxX; x += 4)
+				{
+					__m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), pixelOffsets);
+					__m128 e0 = _mm_add_ps(_mm_mul_ps(edgeA0, centerX), row0);
+					__m128 e1 = _mm_add_ps(_mm_mul_ps(edgeA1, centerX), row1);
+					__m128 e2 = _mm_add_ps(_mm_mul_ps(edgeA2, centerX), row2);
+					__m128 inside = _mm_and_ps(
+						edges[0].bInclusive ? _mm_cmpge_ps(e0, zero) : _mm_cmpgt_ps(e0, zero),
+						edges[1].bInclusive ? _mm_cmpge_ps(e1, zero) : _mm_cmpgt_ps(e1, zero));
+					inside = _mm_and_ps(inside,
+						edges[2].bInclusive ? _mm_cmpge_ps(e2, zero) : _mm_cmpgt_ps(e2, zero));
+					if (_mm_movemask_ps(inside) == 0)
+					{
+						continue;
+					}
+
+					__m128 depth = _mm_add_ps(_mm_mul_ps(depthA, centerX), depthRow);
+					__m128 oldDepth = _mm_loadu_ps(pDepth + x);
+					__m128 pass = _mm_and_ps(inside, _mm_cmplt_ps(depth, oldDepth));
+					if (_mm_movemask_ps(pass) == 0)
+					{
+						continue;
+					}
+
+					__m128 oldTriangle = _mm_loadu_ps(reinterpret_cast<float*>(pTriangle + x));
+					_mm_storeu_ps(pDepth + x, _mm_or_ps(_mm_and_ps(pass, depth), _mm_andnot_ps(pass, oldDepth)));
+					_mm_storeu_ps(reinterpret_cast<float*>(pTriangle + x),
+						_mm_or_ps(_mm_and_ps(pass, referenceValue), _mm_andnot_ps(pass, oldTriangle)));
+				}
+			}
+#else
+			for (int y = minY; y <= maxY; y++)
+			{
+				float centerY = y + 0.5f;
+				float* pDepth = &buffer.depth[(y - tileY) * TILE_SIZE - tileX];
+				uint32_t* pTriangle = &buffer.triangle[(y - tileY) * TILE_SIZE - tileX];
+				for (int x = minX; x <= maxX; x++)
+				{
+					float centerX = x + 0.5f;
+					bool bInside = true;
+					for (const EDGE& edge : edges)
+					{
+						float e = edge.A * centerX + edge.B * centerY + edge.C;
+						bInside = bInside && (edge.bInclusive ? (e >= 0.0f) : (e > 0.0f));
+					}
+					float depth = zA * centerX + zB * centerY + zC;
+					if (bInside && (depth < pDepth[x]))
+					{
+						pDepth[x] = depth;
+						pTriangle[x] = reference;
+					}
+				}
+			}
+#endif
+		}
+	}
+
+	// shade the visible triangle of every pixel, bottom row first
+	uint32_t lastReference = NO_TRIANGLE;
+	const DRAW_ITEM* pDraw = NULL;
+	const CLIP_VERTEX* pVertices[3] = { NULL, NULL, NULL };
+	EDGE edges[3];
+	float invArea = 0.0f;
+
+	for (int localY = 0; localY < tileHeight; localY++)
+	{
+		int y = tileY + localY;
+		unsigned char* pPixel = &m_pixels[(static_cast<size_t>(y) * m_width + tileX) * 4];
+		for (int localX = 0; localX < tileWidth; localX++, pPixel += 4)
+		{
+			uint32_t reference = buffer.triangle[localY * TILE_SIZE + localX];
+			if (reference == NO_TRIANGLE)
+			{
+				pPixel[0] = 0;
+				pPixel[1] = 0;
+				pPixel[2] = 0;
+				pPixel[3] = 255;
+				continue;
+			}
+
+			if (reference != lastReference)
+			{
+				const CHUNK& chunk = m_chunks[reference >> 24];
+				const TRIANGLE& triangle = chunk.triangles[reference & 0xFFFFFF];
+				for (int i = 0; i < 3; i++)
+				{
+					pVertices[i] = &GetVertex(chunk, triangle.vertices[i]);
+				}
+				pDraw = &m_draws[triangle.draw];
+				invArea = 1.0f / SetupEdges(pVertices[0]->screen, pVertices[1]->screen, pVertices[2]->screen, edges);
+				lastReference = reference;
+			}
+
+			// perspective correct weights of the three vertices
+			float centerX = tileX + localX + 0.5f;
+			float centerY = y + 0.5f;
+			float weights[3];
+			float weightSum = 0.0f;
+			for (int i = 0; i < 3; i++)
+			{
+				weights[i] = (edges[i].A * centerX + edges[i].B * centerY + edges[i].C) * invArea * pVertices[i]->screen.w;
+				weightSum += weights[i];
+			}
+			for (float& weight : weights)
+			{
+				weight /= weightSum;
+			}
+
+			glm::vec3 world = weights[0] * pVertices[0]->world + weights[1] * pVertices[1]->world + weights[2] * pVertices[2]->world;
+			glm::vec3 normal = weights[0] * pVertices[0]->normal + weights[1] * pVertices[1]->normal + weights[2] * pVertices[2]->normal;
+			glm::vec2 uv = weights[0] * pVertices[0]->uv + weights[1] * pVertices[1]->uv + weights[2] * pVertices[2]->uv;
+
+			glm::vec4 color = glm::clamp(ShadePixel(*pDraw, world, normal, uv), 0.0f, 1.0f);
+			pPixel[0] = static_cast<unsigned char>(color.r * 255.0f + 0.5f);
+			pPixel[1] = static_cast<unsigned char>(color.g * 255.0f + 0.5f);
+			pPixel[2] = static_cast<unsigned char>(color.b * 255.0f + 0.5f);
+			pPixel[3] = 255;
+		}
+	}
+}
+
+/***********************************************************
+ *  ShadePixel()
+ *
+ *  This method is used for computing the color of a pixel
+ *  the same way fragmentShader.glsl does. Draws are treated
+ *  as opaque, as every color and texture of the scene is.
+ ***********************************************************/
+glm::vec4 SoftwareRasterizer::ShadePixel(const DRAW_ITEM& draw, const glm::vec3& world,
+	const glm::vec3& normal, const glm::vec2& uv) const
+{
+	glm::vec4 textureColor(0.0f, 0.0f, 0.0f, 1.0f);
+	if ((draw.bUseTexture == true) && (draw.texture >= 0))
+	{
+		textureColor = SampleTexture(m_textures[draw.texture], uv * draw.uvScale);
+	}
+
+	if (draw.bUseLighting == false)
+	{
+		return draw.bUseTexture ? textureColor : draw.objectColor;
+	}
+
+	glm::vec3 lightNormal = glm::normalize(normal);
+	glm::vec3 viewDirection = glm::normalize(draw.viewPosition - world);
+	glm::vec3 phongResult = draw.ambient;
+
+	for (int i = 0; i < draw.lightCount; i++)
+	{
+		const DRAW_LIGHT& light = draw.lights[i];
+		glm::vec3 lightDirection = glm::normalize(light.position - world);
+		float impact = glm::dot(lightNormal, lightDirection);
+		if (impact > 0.0f)
+		{
+			phongResult += impact * light.diffuse;
+		}
+
+		// pow is the most expensive part, and zero without a highlight
+		glm::vec3 reflectDirection = glm::reflect(-lightDirection, lightNormal);
+		float highlight = glm::dot(viewDirection, reflectDirection);
+		if (highlight > 0.0f)
+		{
+			phongResult += std::pow(highlight, light.focalStrength) * light.specular;
+		}
+	}
+
+	if (draw.bUseTexture == true)
+	{
+		return glm::vec4(phongResult * glm::vec3(textureColor), 1.0f);
+	}
+	return glm::vec4(phongResult * glm::vec3(draw.objectColor), draw.objectColor.a);
+}
+
+/***********************************************************
+ *  SampleTexture()
+ *
+ *  This method is used for reading a texture with repeat
+ *  wrapping and linear filtering, the sampler settings of
+ *  SceneManager::CreateGLTexture().
+ ***********************************************************/
+glm::vec4 SoftwareRasterizer::SampleTexture(const TEXTURE& texture, glm::vec2 uv) const
+{
+	float x = uv.x * texture.width - 0.5f;
+	float y = uv.y * texture.height - 0.5f;
+	float floorX = std::floor(x);
+	float floorY = std::floor(y);
+	float fractionX = x - floorX;
+	float fractionY = y - floorY;
+
+	int x0 = static_cast<int>(std::fmod(floorX, static_cast<float>(texture.width)));
+	int y0 = static_cast<int>(std::fmod(floorY, static_cast<float>(texture.height)));
+	x0 = (x0 < 0) ? x0 + texture.width : x0;
+	y0 = (y0 < 0) ? y0 + texture.height : y0;
+	int x1 = (x0 + 1 == texture.width) ? 0 : x0 + 1;
+	int y1 = (y0 + 1 == texture.height) ? 0 : y0 + 1;
+
+	const unsigned char* row0 = &texture.texels[static_cast<size_t>(y0) * texture.width * 4];
+	const unsigned char* row1 = &texture.texels[static_cast<size_t>(y1) * texture.width * 4];
+	glm::vec4 color;
+	for (int channel = 0; channel < 4; channel++)
+	{
+		float top = row0[x0 * 4 + channel] + (row0[x1 * 4 + channel] - row0[x0 * 4 + channel]) * fractionX;
+		float bottom = row1[x0 * 4 + channel] + (row1[x1 * 4 + channel] - row1[x0 * 4 + channel]) * fractionX;
+		color[channel] = (top + (bottom - top) * fractionY) / 255.0f;
+	}
+
+	return color;
+}
+
+/***********************************************************
+ *  RunParallel()
+ *
+ *  This method is used for running a job for every index
+ *  from 0 to jobCount on the tile threads and the calling
+ *  thread, returning when all of them are done.
+ ***********************************************************/
+void SoftwareRasterizer::RunParallel(int jobCount, const std::function<void(int, int)>& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_poolMutex);
+		m_pJob = &job;
+		m_jobCount = jobCount;
+		m_nextJob = 0;
+		m_activeWorkers = static_cast<int>(m_workers.size());
+		m_generation++;
+	}
+	m_poolChanged.notify_all();
+
+	RunJobs(0);
+
+	std::unique_lock<std::mutex> lock(m_poolMutex);
+	m_poolDone.wait(lock, [this]() { return m_activeWorkers == 0; });
+	m_pJob = NULL;
+}
+
+/***********************************************************
+ *  RunJobs()
+ *
+ *  This method is used for taking job indices until none
+ *  are left.
+ ***********************************************************/
+void SoftwareRasterizer::RunJobs(int worker)
+{
+	for (int index = m_nextJob++; index < m_jobCount; index = m_nextJob++)
+	{
+		(*m_pJob)(index, worker);
+	}
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is used by each tile thread for waiting for
+ *  the next RunParallel call until it is stopped.
+ ***********************************************************/
+void SoftwareRasterizer::WorkerLoop(int worker)
+{
+	unsigned int seenGeneration = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_poolMutex);
+		seenGeneration = m_generation;
+	}
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_poolMutex);
+			m_poolChanged.wait(lock, [this, seenGeneration]() {
+				return m_bStopWorkers || (m_generation != seenGeneration); });
+			if (m_bStopWorkers == true)
+			{
+				return;
+			}
+			seenGeneration = m_generation;
+		}
+
+		RunJobs(worker);
+
+		std::lock_guard<std::mutex> lock(m_poolMutex);
+		if (--m_activeWorkers == 0)
+		{
+			m_poolDone.notify_all();
+		}
+	}
+}
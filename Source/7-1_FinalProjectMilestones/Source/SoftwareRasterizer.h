@@ -0,0 +1,210 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerasterizer.h
+// ============
+// render the scene on the CPU for hosts without a GPU
+//
+//  The scene still runs its normal RenderScene code. TrackedShapeMeshes
+//  hands every draw to this class, which records it together with the
+//  uniform values the scene set through the TrackedShaderManager. Each mesh
+//  is captured once from OpenGL with transform feedback, so the triangles
+//  are exactly the ones ShapeMeshes generates. Render() then transforms and
+//  bins the triangles into screen tiles and rasterizes the tiles on all
+//  cores with SSE2 edge functions into a visibility buffer, and shades each
+//  covered pixel once with the lighting of fragmentShader.glsl. The image
+//  has the layout glReadPixels returns for the OpenGL path.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshCapture.h"
+#include "RenderStats.h"
+#include "TrackedShaderManager.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class SoftwareRasterizer
+{
+public:
+	// constructor
+	SoftwareRasterizer(TrackedShaderManager* pShaderManager);
+	// destructor
+	~SoftwareRasterizer();
+
+	// allocate the image and start the tile threads, 0 uses every core
+	bool Create(int width, int height, int threadCount = 0);
+	// stop the threads and free the captured meshes and textures
+	void Destroy();
+
+	// record a draw with the current shader settings, true when the
+	// caller has to run the OpenGL draw so the mesh can be captured
+	bool SubmitDraw(RenderStats::MESH_TYPE meshType, int variant);
+	// finish the capture started by SubmitDraw
+	void EndMeshCapture();
+	// drop the software copy of a texture, to be called when the texture
+	// is deleted, as OpenGL may give its name to a new texture
+	void ForgetTexture(GLuint texture);
+
+	// rasterize the draws recorded since the last call
+	void Render();
+
+	// RGBA pixels of the last render, bottom row first like glReadPixels
+	const unsigned char* GetPixels() const { return m_pixels.data(); }
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+
+private:
+	// lights in fragmentShader.glsl
+	static const int TOTAL_LIGHTS = 5;
+	// texture units the scene binds its textures to
+	static const int TEXTURE_UNITS = 16;
+
+	typedef MeshCapture::MESH_VERTEX MESH_VERTEX;
+
+	// light of the shader with the material of a draw already applied
+	struct DRAW_LIGHT
+	{
+		glm::vec3 position;
+		glm::vec3 diffuse;
+		glm::vec3 specular;
+		float focalStrength;
+	};
+
+	struct DRAW_ITEM
+	{
+		// captured triangle list and its first vertex this frame
+		const std::vector<MESH_VERTEX>* pVertices;
+		uint32_t firstVertex;
+
+		glm::mat4 model;
+		glm::mat3 normalMatrix;
+		glm::mat4 viewProjection;
+		glm::vec3 viewPosition;
+
+		bool bUseLighting;
+		glm::vec4 objectColor;
+		// texture is the index into m_textures, -1 when the unit is empty
+		bool bUseTexture;
+		int texture;
+		glm::vec2 uvScale;
+
+		// ambient of all lights, and the lights that add more than ambient
+		glm::vec3 ambient;
+		DRAW_LIGHT lights[TOTAL_LIGHTS];
+		int lightCount;
+	};
+
+	struct TEXTURE
+	{
+		int width;
+		int height;
+		std::vector<unsigned char> texels;
+	};
+
+	// vertex after the transform, screen holds x, y, depth and 1/w
+	struct CLIP_VERTEX
+	{
+		glm::vec4 clip;
+		glm::vec4 screen;
+		glm::vec3 world;
+		glm::vec3 normal;
+		glm::vec2 uv;
+	};
+
+	// triangle of a binning chunk, vertex indices with EXTRA_VERTEX set
+	// refer to the vertices the near plane clipping added to the chunk
+	struct TRIANGLE
+	{
+		uint32_t vertices[3];
+		uint32_t draw;
+	};
+
+	struct CHUNK
+	{
+		std::vector<TRIANGLE> triangles;
+		std::vector<CLIP_VERTEX> extraVertices;
+		// triangle indices touching each tile, in submission order
+		std::vector<std::vector<uint32_t>> tiles;
+	};
+
+	// depth and visible triangle of every pixel of a tile
+	struct TILE_BUFFER
+	{
+		std::vector<float> depth;
+		std::vector<uint32_t> triangle;
+	};
+
+	// find the software copy of the texture bound to a unit
+	int GetUnitTexture(int unit);
+	// read the lights and the material of the draw
+	void SetupLights(DRAW_ITEM& draw);
+
+	// run job(index, worker) for every index on all threads
+	void RunParallel(int jobCount, const std::function<void(int, int)>& job);
+	void RunJobs(int worker);
+	void WorkerLoop(int worker);
+
+	// the three passes of Render()
+	void TransformDraw(int drawIndex);
+	void SetupChunk(int chunkIndex);
+	void RenderTile(int tileIndex, int worker);
+
+	// clip a triangle against the near plane and bin what is left
+	void ClipTriangle(CHUNK& chunk, uint32_t drawIndex, const CLIP_VERTEX* vertices[3]);
+	void BinTriangle(CHUNK& chunk, const TRIANGLE& triangle);
+	const CLIP_VERTEX& GetVertex(const CHUNK& chunk, uint32_t index) const;
+	// shade one covered pixel like fragmentShader.glsl
+	glm::vec4 ShadePixel(const DRAW_ITEM& draw, const glm::vec3& world,
+		const glm::vec3& normal, const glm::vec2& uv) const;
+	glm::vec4 SampleTexture(const TEXTURE& texture, glm::vec2 uv) const;
+
+	TrackedShaderManager* m_pShaderManager;
+
+	int m_width;
+	int m_height;
+	int m_tilesX;
+	int m_tilesY;
+	std::vector<unsigned char> m_pixels;
+
+	// captured meshes by mesh type and variant
+	std::unordered_map<int, std::vector<MESH_VERTEX>> m_meshes;
+	// mesh being captured, and the capture of the OpenGL draws
+	std::vector<MESH_VERTEX>* m_pCaptureMesh;
+	MeshCapture m_capture;
+
+	// software copies of the textures, by OpenGL texture name
+	std::vector<TEXTURE> m_textures;
+	std::unordered_map<GLuint, int> m_textureNames;
+	int m_unitTextures[TEXTURE_UNITS];
+
+	// draws recorded since the last render
+	std::vector<DRAW_ITEM> m_draws;
+	uint32_t m_totalVertices;
+
+	// per frame work buffers
+	std::vector<CLIP_VERTEX> m_clipVertices;
+	std::vector<CHUNK> m_chunks;
+	int m_chunkTriangles;
+	std::vector<TILE_BUFFER> m_tileBuffers;
+
+	// worker threads, the calling thread works as worker 0
+	std::vector<std::thread> m_workers;
+	std::mutex m_poolMutex;
+	std::condition_variable m_poolChanged;
+	std::condition_variable m_poolDone;
+	const std::function<void(int, int)>* m_pJob;
+	int m_jobCount;
+	std::atomic<int> m_nextJob;
+	int m_activeWorkers;
+	unsigned int m_generation;
+	bool m_bStopWorkers;
+};
@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////////////
+// statecache.h
+// ============
+// shadow copy of the OpenGL state the scene changes, to drop redundant calls
+//
+//  The scene code sets the program, texture bindings, enable flags and the
+//  clear color through these functions instead of calling OpenGL directly.
+//  A call that would set the value OpenGL already has is skipped. Every
+//  value starts out unknown, so the first call always reaches OpenGL, and
+//  Reset() forgets everything after code outside the cache changed state.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+namespace StateCache
+{
+	// texture units whose bindings are tracked, higher units pass through
+	const int TRACKED_TEXTURE_UNITS = 32;
+
+	// forget the shadow state, the next call of each kind reaches OpenGL
+	void Reset();
+
+	// glUseProgram
+	void UseProgram(GLuint program);
+	// the current program, only asks OpenGL while it is unknown
+	GLuint GetProgram();
+
+	// glActiveTexture, unit counts from 0 instead of GL_TEXTURE0
+	void ActiveTexture(GLuint unit);
+	// glBindTexture(GL_TEXTURE_2D) on the active unit
+	void BindTexture2D(GLuint texture);
+	// glBindTexture(GL_TEXTURE_2D_ARRAY) on the active unit
+	void BindTextureArray(GLuint texture);
+	// forget a texture name, to be called when the texture is deleted
+	void ForgetTexture(GLuint texture);
+
+	// glEnable and glDisable
+	void Enable(GLenum capability);
+	void Disable(GLenum capability);
+
+	// glClearColor
+	void ClearColor(const glm::vec4& color);
+}
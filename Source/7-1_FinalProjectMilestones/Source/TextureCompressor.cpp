@@ -0,0 +1,709 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecompressor.cpp
+// ============
+// block compress texture images and keep them in a KTX2 file cache
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureCompressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+// declaration of global variables and helper functions
+namespace
+{
+	// Vulkan format numbers KTX2 files name their block formats by
+	const uint32_t VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+	const uint32_t VK_FORMAT_BC7_UNORM_BLOCK = 145;
+	// data format descriptor color models of the block formats
+	const uint32_t KHR_DF_MODEL_BC1A = 128;
+	const uint32_t KHR_DF_MODEL_BC7 = 134;
+
+	// KTX2 file identifier, then the fixed size header and index
+	const unsigned char g_KtxIdentifier[12] = {
+		0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	const size_t KTX_HEADER_SIZE = 80;
+	const size_t KTX_LEVEL_ENTRY_SIZE = 24;
+	// the level data alignment, a multiple of every block size and of 4
+	const size_t KTX_LEVEL_ALIGNMENT = 16;
+	// the images are stored bottom row first, as OpenGL expects them
+	const char g_OrientationKey[] = "KTXorientation";
+	const char g_OrientationValue[] = "ru";
+
+	// interpolation weights of the 4-bit BC7 indices, out of 64
+	const int g_Bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// get the bytes of one 4x4 block of the format
+	size_t GetBlockSize(GLenum format)
+	{
+		return (format == GL_COMPRESSED_RGBA_BPTC_UNORM) ? 16 : 8;
+	}
+
+	// append a 32 or 64-bit little-endian value
+	void PutUint32(std::vector<unsigned char>& buffer, uint32_t value)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			buffer.push_back(static_cast<unsigned char>(value >> (i * 8)));
+		}
+	}
+	void PutUint64(std::vector<unsigned char>& buffer, uint64_t value)
+	{
+		for (int i = 0; i < 8; i++)
+		{
+			buffer.push_back(static_cast<unsigned char>(value >> (i * 8)));
+		}
+	}
+
+	// read a 32 or 64-bit little-endian value
+	uint32_t GetUint32(const unsigned char* data)
+	{
+		return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+			(static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+	}
+	uint64_t GetUint64(const unsigned char* data)
+	{
+		return static_cast<uint64_t>(GetUint32(data)) | (static_cast<uint64_t>(GetUint32(data + 4)) << 32);
+	}
+
+	// halve an RGBA image, odd edges repeat their last texel
+	void Downsample(const std::vector<unsigned char>& source, int width, int height,
+		std::vector<unsigned char>& destination, int newWidth, int newHeight)
+	{
+		destination.resize(static_cast<size_t>(newWidth) * newHeight * 4);
+		for (int y = 0; y < newHeight; y++)
+		{
+			int y0 = std::min(y * 2, height - 1);
+			int y1 = std::min(y * 2 + 1, height - 1);
+			for (int x = 0; x < newWidth; x++)
+			{
+				int x0 = std::min(x * 2, width - 1);
+				int x1 = std::min(x * 2 + 1, width - 1);
+				for (int c = 0; c < 4; c++)
+				{
+					int sum = source[(static_cast<size_t>(y0) * width + x0) * 4 + c] +
+						source[(static_cast<size_t>(y0) * width + x1) * 4 + c] +
+						source[(static_cast<size_t>(y1) * width + x0) * 4 + c] +
+						source[(static_cast<size_t>(y1) * width + x1) * 4 + c];
+					destination[(static_cast<size_t>(y) * newWidth + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+				}
+			}
+		}
+	}
+
+	// fit a line through the block texels along their principal axis and
+	// get its two ends, the texels then lie between the endpoints
+	void FindEndpoints(const int texels[16][4], int channels, float end0[4], float end1[4])
+	{
+		float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < channels; c++)
+			{
+				mean[c] += texels[i][c] / 16.0f;
+			}
+		}
+
+		float covariance[4][4] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			for (int a = 0; a < channels; a++)
+			{
+				for (int b = 0; b < channels; b++)
+				{
+					covariance[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+				}
+			}
+		}
+
+		// a few power iterations find the axis of the largest spread
+		float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			float length = 0.0f;
+			for (int a = 0; a < channels; a++)
+			{
+				for (int b = 0; b < channels; b++)
+				{
+					next[a] += covariance[a][b] * axis[b];
+				}
+				length = std::max(length, std::fabs(next[a]));
+			}
+			if (length < 1e-6f)
+			{
+				break;
+			}
+			for (int a = 0; a < channels; a++)
+			{
+				axis[a] = next[a] / length;
+			}
+		}
+
+		float minProjection = 0.0f;
+		float maxProjection = 0.0f;
+		float axisLength = 0.0f;
+		for (int c = 0; c < channels; c++)
+		{
+			axisLength += axis[c] * axis[c];
+		}
+		for (int i = 0; (i < 16) && (axisLength > 1e-6f); i++)
+		{
+			float projection = 0.0f;
+			for (int c = 0; c < channels; c++)
+			{
+				projection += (texels[i][c] - mean[c]) * axis[c];
+			}
+			minProjection = std::min(minProjection, projection / axisLength);
+			maxProjection = std::max(maxProjection, projection / axisLength);
+		}
+
+		for (int c = 0; c < 4; c++)
+		{
+			end0[c] = 255.0f;
+			end1[c] = 255.0f;
+		}
+		for (int c = 0; c < channels; c++)
+		{
+			end0[c] = std::min(std::max(mean[c] + axis[c] * minProjection, 0.0f), 255.0f);
+			end1[c] = std::min(std::max(mean[c] + axis[c] * maxProjection, 0.0f), 255.0f);
+		}
+	}
+
+	// get the index of the palette entry closest to the texel
+	int FindClosest(const int texel[4], const int palette[][4], int paletteSize, int channels)
+	{
+		int bestIndex = 0;
+		int bestError = 0x7FFFFFFF;
+		for (int p = 0; p < paletteSize; p++)
+		{
+			int error = 0;
+			for (int c = 0; c < channels; c++)
+			{
+				int delta = texel[c] - palette[p][c];
+				error += delta * delta;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				bestIndex = p;
+			}
+		}
+		return bestIndex;
+	}
+
+	// convert an endpoint to 5:6:5 bits
+	uint16_t ToRgb565(const float color[4])
+	{
+		int r = static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f);
+		int g = static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f);
+		int b = static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	// expand 5:6:5 bits back to 8 bits per channel
+	void FromRgb565(uint16_t color, int rgb[4])
+	{
+		int r = (color >> 11) & 31;
+		int g = (color >> 5) & 63;
+		int b = color & 31;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+		rgb[3] = 255;
+	}
+
+	// compress one block in the four color mode of BC1
+	void CompressBc1Block(const int texels[16][4], unsigned char* block)
+	{
+		float end0[4];
+		float end1[4];
+		FindEndpoints(texels, 3, end0, end1);
+
+		uint16_t color0 = ToRgb565(end1);
+		uint16_t color1 = ToRgb565(end0);
+		// the four color mode needs the first color to be the larger one
+		if (color0 < color1)
+		{
+			std::swap(color0, color1);
+		}
+
+		uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			int palette[4][4];
+			FromRgb565(color0, palette[0]);
+			FromRgb565(color1, palette[1]);
+			for (int c = 0; c < 3; c++)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			for (int i = 0; i < 16; i++)
+			{
+				indices |= static_cast<uint32_t>(FindClosest(texels[i], palette, 4, 3)) << (i * 2);
+			}
+		}
+
+		block[0] = static_cast<unsigned char>(color0);
+		block[1] = static_cast<unsigned char>(color0 >> 8);
+		block[2] = static_cast<unsigned char>(color1);
+		block[3] = static_cast<unsigned char>(color1 >> 8);
+		for (int i = 0; i < 4; i++)
+		{
+			block[4 + i] = static_cast<unsigned char>(indices >> (i * 8));
+		}
+	}
+
+	// quantize an endpoint to 7 bits per channel and the shared low bit
+	// that fits it best, as BC7 mode 6 stores it
+	void QuantizeBc7Endpoint(const float color[4], int quantized[4], int& pBit)
+	{
+		int bestError = 0x7FFFFFFF;
+		for (int p = 0; p < 2; p++)
+		{
+			int candidate[4];
+			int error = 0;
+			for (int c = 0; c < 4; c++)
+			{
+				candidate[c] = std::min(std::max(static_cast<int>((color[c] - p) / 2.0f + 0.5f), 0), 127);
+				int delta = candidate[c] * 2 + p - static_cast<int>(color[c] + 0.5f);
+				error += delta * delta;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				pBit = p;
+				std::copy(candidate, candidate + 4, quantized);
+			}
+		}
+	}
+
+	// append bits to a block, lowest bit first
+	void PutBits(unsigned char* block, int& bitPosition, uint32_t value, int bitCount)
+	{
+		for (int i = 0; i < bitCount; i++, bitPosition++)
+		{
+			if ((value >> i) & 1)
+			{
+				block[bitPosition >> 3] |= static_cast<unsigned char>(1 << (bitPosition & 7));
+			}
+		}
+	}
+
+	// compress one block with BC7 mode 6, one RGBA endpoint pair and
+	// 16 interpolation steps
+	void CompressBc7Block(const int texels[16][4], unsigned char* block)
+	{
+		float end0[4];
+		float end1[4];
+		FindEndpoints(texels, 4, end0, end1);
+
+		int quantized[2][4];
+		int pBits[2] = { 0, 0 };
+		QuantizeBc7Endpoint(end0, quantized[0], pBits[0]);
+		QuantizeBc7Endpoint(end1, quantized[1], pBits[1]);
+
+		int palette[16][4];
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				int value0 = quantized[0][c] * 2 + pBits[0];
+				int value1 = quantized[1][c] * 2 + pBits[1];
+				palette[i][c] = ((64 - g_Bc7Weights[i]) * value0 + g_Bc7Weights[i] * value1 + 32) >> 6;
+			}
+		}
+
+		int indices[16];
+		for (int i = 0; i < 16; i++)
+		{
+			indices[i] = FindClosest(texels[i], palette, 16, 4);
+		}
+
+		// the first index is stored without its top bit, so it has to be
+		// below 8, swapping the endpoints mirrors every index
+		if (indices[0] >= 8)
+		{
+			std::swap(quantized[0], quantized[1]);
+			std::swap(pBits[0], pBits[1]);
+			for (int i = 0; i < 16; i++)
+			{
+				indices[i] = 15 - indices[i];
+			}
+		}
+
+		std::memset(block, 0, 16);
+		int bitPosition = 0;
+		PutBits(block, bitPosition, 1 << 6, 7);
+		for (int c = 0; c < 4; c++)
+		{
+			PutBits(block, bitPosition, quantized[0][c], 7);
+			PutBits(block, bitPosition, quantized[1][c], 7);
+		}
+		PutBits(block, bitPosition, pBits[0], 1);
+		PutBits(block, bitPosition, pBits[1], 1);
+		PutBits(block, bitPosition, indices[0], 3);
+		for (int i = 1; i < 16; i++)
+		{
+			PutBits(block, bitPosition, indices[i], 4);
+		}
+	}
+
+	// compress one RGBA mip level, edge blocks repeat the last texels
+	void CompressLevel(const std::vector<unsigned char>& rgba, int width, int height,
+		GLenum format, unsigned char* output)
+	{
+		size_t blockSize = GetBlockSize(format);
+		int blocksWide = (width + 3) / 4;
+		int blocksHigh = (height + 3) / 4;
+		for (int blockY = 0; blockY < blocksHigh; blockY++)
+		{
+			for (int blockX = 0; blockX < blocksWide; blockX++)
+			{
+				int texels[16][4];
+				for (int i = 0; i < 16; i++)
+				{
+					int x = std::min(blockX * 4 + (i & 3), width - 1);
+					int y = std::min(blockY * 4 + (i >> 2), height - 1);
+					for (int c = 0; c < 4; c++)
+					{
+						texels[i][c] = rgba[(static_cast<size_t>(y) * width + x) * 4 + c];
+					}
+				}
+
+				unsigned char* block = output + (static_cast<size_t>(blockY) * blocksWide + blockX) * blockSize;
+				if (format == GL_COMPRESSED_RGBA_BPTC_UNORM)
+				{
+					CompressBc7Block(texels, block);
+				}
+				else
+				{
+					CompressBc1Block(texels, block);
+				}
+			}
+		}
+	}
+
+	// lay out the mip levels of an image, largest first
+	void BuildLevels(int width, int height, GLenum format, std::vector<TextureCompressor::MIP_LEVEL>& levels, size_t& totalSize)
+	{
+		levels.clear();
+		totalSize = 0;
+		while (true)
+		{
+			TextureCompressor::MIP_LEVEL level;
+			level.width = width;
+			level.height = height;
+			level.offset = totalSize;
+			level.size = static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+			levels.push_back(level);
+			totalSize += level.size;
+			if ((width == 1) && (height == 1))
+			{
+				break;
+			}
+			width = std::max(width / 2, 1);
+			height = std::max(height / 2, 1);
+		}
+	}
+}
+
+/***********************************************************
+ *  ChooseFormat()
+ *
+ *  This method is used for choosing the compressed format
+ *  the textures are stored in. BC7 keeps the most detail at
+ *  4:1, BC1 is used where BC7 is not supported, and 0 keeps
+ *  the textures uncompressed. ETC2 is not used, as desktop
+ *  drivers unpack it to RGBA8 on upload.
+ ***********************************************************/
+GLenum TextureCompressor::ChooseFormat()
+{
+	if ((GLEW_VERSION_4_2 == GL_TRUE) || (GLEW_ARB_texture_compression_bptc == GL_TRUE))
+	{
+		return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+	if (GLEW_EXT_texture_compression_s3tc == GL_TRUE)
+	{
+		return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	}
+	return 0;
+}
+
+/***********************************************************
+ *  GetFormatName()
+ *
+ *  This method is used for getting the display name of a
+ *  compressed format.
+ ***********************************************************/
+const char* TextureCompressor::GetFormatName(GLenum format)
+{
+	if (format == GL_COMPRESSED_RGBA_BPTC_UNORM)
+	{
+		return "BC7";
+	}
+	if (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+	{
+		return "BC1";
+	}
+	return "uncompressed";
+}
+
+/***********************************************************
+ *  GetCachePath()
+ *
+ *  This method is used for getting the name of the KTX2
+ *  file an image is cached in, next to the image itself.
+ ***********************************************************/
+std::string TextureCompressor::GetCachePath(const std::string& filename, GLenum format)
+{
+	std::string extension = (format == GL_COMPRESSED_RGBA_BPTC_UNORM) ? ".bc7.ktx2" : ".bc1.ktx2";
+	return filename + extension;
+}
+
+/***********************************************************
+ *  Compress()
+ *
+ *  This method is used for building the mip chain of an
+ *  image and compressing every level into the format. The
+ *  pixels are read in the order they are stored, so images
+ *  loaded bottom row first stay that way.
+ ***********************************************************/
+bool TextureCompressor::Compress(const unsigned char* pixels, int width, int height, int channels,
+	GLenum format, COMPRESSED_IMAGE& image)
+{
+	if (((channels != 3) && (channels != 4)) || (width <= 0) || (height <= 0) ||
+		((format != GL_COMPRESSED_RGBA_BPTC_UNORM) && (format != GL_COMPRESSED_RGB_S3TC_DXT1_EXT)))
+	{
+		return false;
+	}
+
+	image.format = format;
+	image.width = width;
+	image.height = height;
+	size_t totalSize = 0;
+	BuildLevels(width, height, format, image.levels, totalSize);
+	image.data.assign(totalSize, 0);
+
+	// every level is compressed from RGBA, opaque when the image has no alpha
+	std::vector<unsigned char> level(static_cast<size_t>(width) * height * 4);
+	for (size_t i = 0; i < static_cast<size_t>(width) * height; i++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			level[i * 4 + c] = (c < channels) ? pixels[i * channels + c] : 255;
+		}
+	}
+
+	std::vector<unsigned char> smaller;
+	for (size_t i = 0; i < image.levels.size(); i++)
+	{
+		const MIP_LEVEL& mip = image.levels[i];
+		if (i > 0)
+		{
+			Downsample(level, image.levels[i - 1].width, image.levels[i - 1].height, smaller, mip.width, mip.height);
+			level.swap(smaller);
+		}
+		CompressLevel(level, mip.width, mip.height, format, image.data.data() + mip.offset);
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  ReadCache()
+ *
+ *  This method is used for reading a compressed image back
+ *  from its KTX2 file. A cache older than its source image,
+ *  in another format or with an unexpected layout is not
+ *  used, so it gets written again.
+ ***********************************************************/
+bool TextureCompressor::ReadCache(const std::string& cachePath, const std::string& sourcePath,
+	GLenum format, COMPRESSED_IMAGE& image)
+{
+	std::error_code error;
+	std::filesystem::file_time_type cacheTime = std::filesystem::last_write_time(cachePath, error);
+	if (error)
+	{
+		return false;
+	}
+	std::filesystem::file_time_type sourceTime = std::filesystem::last_write_time(sourcePath, error);
+	if (error || (sourceTime > cacheTime))
+	{
+		return false;
+	}
+
+	FILE* file = fopen(cachePath.c_str(), "rb");
+	if (file == NULL)
+	{
+		return false;
+	}
+	std::vector<unsigned char> contents;
+	unsigned char chunk[65536];
+	size_t readBytes = 0;
+	while ((readBytes = fread(chunk, 1, sizeof(chunk), file)) > 0)
+	{
+		contents.insert(contents.end(), chunk, chunk + readBytes);
+	}
+	fclose(file);
+
+	if ((contents.size() < KTX_HEADER_SIZE) ||
+		(std::memcmp(contents.data(), g_KtxIdentifier, sizeof(g_KtxIdentifier)) != 0))
+	{
+		return false;
+	}
+
+	const unsigned char* header = contents.data() + sizeof(g_KtxIdentifier);
+	uint32_t vkFormat = GetUint32(header);
+	uint32_t expectedFormat = (format == GL_COMPRESSED_RGBA_BPTC_UNORM) ?
+		VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+	int width = static_cast<int>(GetUint32(header + 8));
+	int height = static_cast<int>(GetUint32(header + 12));
+	uint32_t levelCount = GetUint32(header + 28);
+	uint32_t supercompression = GetUint32(header + 32);
+	if ((vkFormat != expectedFormat) || (width <= 0) || (height <= 0) ||
+		(GetUint32(header + 16) != 0) || (GetUint32(header + 20) != 0) ||
+		(GetUint32(header + 24) != 1) || (supercompression != 0))
+	{
+		return false;
+	}
+
+	image.format = format;
+	image.width = width;
+	image.height = height;
+	size_t totalSize = 0;
+	BuildLevels(width, height, format, image.levels, totalSize);
+	if ((levelCount != image.levels.size()) ||
+		(contents.size() < KTX_HEADER_SIZE + levelCount * KTX_LEVEL_ENTRY_SIZE))
+	{
+		return false;
+	}
+
+	image.data.resize(totalSize);
+	for (uint32_t i = 0; i < levelCount; i++)
+	{
+		const unsigned char* entry = contents.data() + KTX_HEADER_SIZE + i * KTX_LEVEL_ENTRY_SIZE;
+		uint64_t byteOffset = GetUint64(entry);
+		uint64_t byteLength = GetUint64(entry + 8);
+		const MIP_LEVEL& mip = image.levels[i];
+		if ((byteLength != mip.size) || (byteOffset > contents.size()) ||
+			(contents.size() - byteOffset < byteLength))
+		{
+			return false;
+		}
+		std::memcpy(image.data.data() + mip.offset, contents.data() + byteOffset, mip.size);
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  WriteCache()
+ *
+ *  This method is used for writing a compressed image as a
+ *  KTX2 file, with the data format descriptor of its block
+ *  format and the mip levels stored smallest first.
+ ***********************************************************/
+bool TextureCompressor::WriteCache(const std::string& cachePath, const COMPRESSED_IMAGE& image)
+{
+	bool bBc7 = (image.format == GL_COMPRESSED_RGBA_BPTC_UNORM);
+	uint32_t levelCount = static_cast<uint32_t>(image.levels.size());
+
+	// data format descriptor, one basic block with a single sample
+	std::vector<unsigned char> descriptor;
+	PutUint32(descriptor, 44);
+	PutUint32(descriptor, 0);
+	PutUint32(descriptor, 2 | (40 << 16));
+	// color model, BT.709 primaries, linear transfer as the textures are sampled
+	PutUint32(descriptor, (bBc7 ? KHR_DF_MODEL_BC7 : KHR_DF_MODEL_BC1A) | (1 << 8) | (1 << 16));
+	PutUint32(descriptor, 3 | (3 << 8));
+	PutUint32(descriptor, bBc7 ? 16 : 8);
+	PutUint32(descriptor, 0);
+	PutUint32(descriptor, (bBc7 ? 127 : 63) << 16);
+	PutUint32(descriptor, 0);
+	PutUint32(descriptor, 0);
+	PutUint32(descriptor, 0xFFFFFFFFu);
+
+	std::vector<unsigned char> keyValues;
+	uint32_t keyValueLength = static_cast<uint32_t>(sizeof(g_OrientationKey) + sizeof(g_OrientationValue));
+	PutUint32(keyValues, keyValueLength);
+	keyValues.insert(keyValues.end(), g_OrientationKey, g_OrientationKey + sizeof(g_OrientationKey));
+	keyValues.insert(keyValues.end(), g_OrientationValue, g_OrientationValue + sizeof(g_OrientationValue));
+	while (keyValues.size() % 4 != 0)
+	{
+		keyValues.push_back(0);
+	}
+
+	size_t descriptorOffset = KTX_HEADER_SIZE + levelCount * KTX_LEVEL_ENTRY_SIZE;
+	size_t keyValueOffset = descriptorOffset + descriptor.size();
+	size_t dataOffset = keyValueOffset + keyValues.size();
+
+	// smallest level first, each one aligned
+	std::vector<size_t> levelOffsets(levelCount);
+	for (uint32_t i = levelCount; i-- > 0;)
+	{
+		dataOffset = (dataOffset + KTX_LEVEL_ALIGNMENT - 1) / KTX_LEVEL_ALIGNMENT * KTX_LEVEL_ALIGNMENT;
+		levelOffsets[i] = dataOffset;
+		dataOffset += image.levels[i].size;
+	}
+
+	std::vector<unsigned char> contents(g_KtxIdentifier, g_KtxIdentifier + sizeof(g_KtxIdentifier));
+	PutUint32(contents, bBc7 ? VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK);
+	PutUint32(contents, 1);
+	PutUint32(contents, static_cast<uint32_t>(image.width));
+	PutUint32(contents, static_cast<uint32_t>(image.height));
+	PutUint32(contents, 0);
+	PutUint32(contents, 0);
+	PutUint32(contents, 1);
+	PutUint32(contents, levelCount);
+	PutUint32(contents, 0);
+	PutUint32(contents, static_cast<uint32_t>(descriptorOffset));
+	PutUint32(contents, static_cast<uint32_t>(descriptor.size()));
+	PutUint32(contents, static_cast<uint32_t>(keyValueOffset));
+	PutUint32(contents, static_cast<uint32_t>(keyValues.size()));
+	PutUint64(contents, 0);
+	PutUint64(contents, 0);
+	for (uint32_t i = 0; i < levelCount; i++)
+	{
+		PutUint64(contents, levelOffsets[i]);
+		PutUint64(contents, image.levels[i].size);
+		PutUint64(contents, image.levels[i].size);
+	}
+	contents.insert(contents.end(), descriptor.begin(), descriptor.end());
+	contents.insert(contents.end(), keyValues.begin(), keyValues.end());
+	contents.resize(dataOffset, 0);
+	for (uint32_t i = 0; i < levelCount; i++)
+	{
+		const MIP_LEVEL& mip = image.levels[i];
+		std::memcpy(contents.data() + levelOffsets[i], image.data.data() + mip.offset, mip.size);
+	}
+
+	// written under a temporary name, so a cut off write is never read back
+	std::string temporaryPath = cachePath + ".tmp";
+	FILE* file = fopen(temporaryPath.c_str(), "wb");
+	if (file == NULL)
+	{
+		return false;
+	}
+	bool bWritten = (fwrite(contents.data(), 1, contents.size(), file) == contents.size());
+	bWritten = (fclose(file) == 0) && bWritten;
+
+	std::error_code error;
+	if (bWritten == true)
+	{
+		std::filesystem::rename(temporaryPath, cachePath, error);
+	}
+	if ((bWritten == false) || error)
+	{
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+
+	return true;
+}
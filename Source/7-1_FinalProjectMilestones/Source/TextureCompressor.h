@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecompressor.h
+// ============
+// block compress texture images and keep them in a KTX2 file cache
+//
+//  Images are compressed with a full mip chain into BC7 (mode 6, one
+//  endpoint pair per 4x4 block) or BC1, whichever the GPU samples. The
+//  result is written next to the source image as a KTX2 file, so later
+//  runs read the blocks back instead of decoding and compressing again.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace TextureCompressor
+{
+	// one mip level of a compressed image, offset and size are in bytes
+	struct MIP_LEVEL
+	{
+		int width;
+		int height;
+		size_t offset;
+		size_t size;
+	};
+
+	// compressed image with every mip level, largest first, in one buffer
+	struct COMPRESSED_IMAGE
+	{
+		GLenum format;
+		int width;
+		int height;
+		std::vector<MIP_LEVEL> levels;
+		std::vector<unsigned char> data;
+	};
+
+	// get the best compressed format the GPU supports, 0 when there is none
+	GLenum ChooseFormat();
+	// get the display name of a compressed format
+	const char* GetFormatName(GLenum format);
+	// get the cache file name of an image compressed into the format
+	std::string GetCachePath(const std::string& filename, GLenum format);
+
+	// compress 8-bit RGB or RGBA pixels and their mip chain into the format
+	bool Compress(const unsigned char* pixels, int width, int height, int channels,
+		GLenum format, COMPRESSED_IMAGE& image);
+	// read a cached image, false when the file is missing, stale or invalid
+	bool ReadCache(const std::string& cachePath, const std::string& sourcePath,
+		GLenum format, COMPRESSED_IMAGE& image);
+	// write a compressed image as a KTX2 file
+	bool WriteCache(const std::string& cachePath, const COMPRESSED_IMAGE& image);
+}
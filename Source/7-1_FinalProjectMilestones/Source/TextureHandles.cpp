@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturehandles.cpp
+// ============
+// bindless handles of the scene textures, in a storage buffer table
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureHandles.h"
+#include "Trace.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  TextureHandles()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureHandles::TextureHandles()
+{
+	m_handleTableBuffer = 0;
+}
+
+/***********************************************************
+ *  ~TextureHandles()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureHandles::~TextureHandles()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  This method is used for checking whether the driver
+ *  exposes bindless textures.
+ ***********************************************************/
+bool TextureHandles::IsSupported()
+{
+	return (GLEW_ARB_bindless_texture == GL_TRUE);
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for getting the handle of every
+ *  passed in texture, making it resident and uploading the
+ *  handles into the handle table, in texture slot order.
+ *  The handles stay resident until Destroy().
+ ***********************************************************/
+bool TextureHandles::Build(const std::vector<GLuint>& textures)
+{
+	TRACE_ZONE("BuildTextureHandles");
+	Destroy();
+	if (IsSupported() == false)
+	{
+		std::cout << "Bindless textures need ARB_bindless_texture" << std::endl;
+		return false;
+	}
+
+	for (GLuint texture : textures)
+	{
+		GLuint64 handle = glGetTextureHandleARB(texture);
+		if (handle == 0)
+		{
+			std::cout << "Could not get a bindless handle for texture " << texture << std::endl;
+			Destroy();
+			return false;
+		}
+		glMakeTextureHandleResidentARB(handle);
+		m_handles.push_back(handle);
+	}
+
+	// an empty storage buffer cannot be bound, so there is always one entry
+	std::vector<GLuint64> handleTable = m_handles;
+	if (handleTable.empty() == true)
+	{
+		handleTable.push_back(0);
+	}
+	glGenBuffers(1, &m_handleTableBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handleTableBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, handleTable.size() * sizeof(GLuint64), handleTable.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	std::cout << "INFO: Made " << m_handles.size() << " bindless texture handles resident" << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for making the handles non-resident
+ *  and freeing the handle table. The handles themselves
+ *  live as long as their textures.
+ ***********************************************************/
+void TextureHandles::Destroy()
+{
+	for (GLuint64 handle : m_handles)
+	{
+		glMakeTextureHandleNonResidentARB(handle);
+	}
+	m_handles.clear();
+
+	if (m_handleTableBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_handleTableBuffer);
+		m_handleTableBuffer = 0;
+	}
+}
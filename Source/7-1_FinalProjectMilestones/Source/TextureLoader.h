@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.h
+// ============
+// decode texture images on worker threads and upload them a few per frame
+//
+//  Load() gives the texture a one texel placeholder right away and queues
+//  its image file. Worker threads decode the queued files, and Update(),
+//  called on the OpenGL thread once per frame, uploads decoded images
+//  through a pixel buffer object until the frame's byte budget is used.
+//  The texture name never changes, so the scene can bind and draw with a
+//  texture while its image is still on the way.
+//
+//  A load can be cancelled before its texture is deleted, and the textures
+//  uploaded since the last call can be collected, so the owner knows when
+//  the image has replaced the placeholder.
+//
+//  Where the GPU supports block compression the threads read the image
+//  from its KTX2 cache instead, compressing and caching it on first use,
+//  and the upload sends the compressed mip chain as it is.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "TextureCompressor.h"
+
+#include <GL/glew.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class TextureLoader
+{
+public:
+	// texture unit the loader binds textures on, away from the scene slots
+	static const GLuint UPLOAD_TEXTURE_UNIT = 31;
+
+	// constructor
+	TextureLoader();
+	// destructor
+	~TextureLoader();
+
+	// upload the images block compressed where the GPU supports it, call
+	// before the first Load, on by default
+	void SetCompression(bool bCompress) { m_bCompress = bCompress; }
+	// fill the texture with the placeholder and queue the image file for it
+	void Load(const char* filename, GLuint texture);
+	// upload decoded images until byteBudget bytes were sent, always at least one
+	void Update(size_t byteBudget);
+	// wait for every queued image and upload it
+	void Finish();
+	// drop the queued image of the texture, call before deleting it
+	void Cancel(GLuint texture);
+	// move out the textures that got their image since the last call
+	void TakeUploaded(std::vector<GLuint>& textures);
+	// number of queued images that are not uploaded yet
+	int GetPendingCount() const { return m_pendingImages; }
+
+private:
+	struct LOAD_JOB
+	{
+		std::string filename;
+		GLuint texture;
+		// number of the Load call, a newer Load or a Cancel outdates it
+		uint64_t serial;
+		// decoded image, NULL when the file could not be read
+		unsigned char* pixels;
+		int width;
+		int height;
+		int channels;
+		// compressed image, used when it holds any levels
+		TextureCompressor::COMPRESSED_IMAGE compressed;
+	};
+
+	// upload a decoded image into its texture and free the pixels
+	size_t Upload(LOAD_JOB& job);
+	// upload a compressed image and its mip levels into its texture
+	size_t UploadCompressed(LOAD_JOB& job);
+	// copy bytes into the pixel buffer, false when it could not be mapped
+	bool FillUploadBuffer(const unsigned char* data, size_t bytes);
+	// read the job image from its cache, or decode it and fill the cache
+	void DecodeCompressed(LOAD_JOB& job);
+
+	// start and stop the decoding threads
+	void StartDecoders(int threadCount);
+	void StopDecoders();
+	// loop run by every decoding thread
+	void DecodeJobs();
+
+	// files waiting for a thread and images waiting for the upload,
+	// guarded by the mutex
+	std::mutex m_jobsMutex;
+	std::condition_variable m_jobsChanged;
+	std::deque<LOAD_JOB> m_jobs;
+	std::deque<LOAD_JOB> m_decodedJobs;
+	bool m_bStopDecoders;
+	std::vector<std::thread> m_decoders;
+	// images queued and not uploaded, only used on the OpenGL thread
+	int m_pendingImages;
+	// serial of the load each texture waits for, and the last serial given
+	std::unordered_map<GLuint, uint64_t> m_loadSerials;
+	uint64_t m_lastSerial;
+	// textures uploaded since the last TakeUploaded
+	std::vector<GLuint> m_uploadedTextures;
+	// pixel buffer the images are uploaded from
+	GLuint m_uploadBuffer;
+	// true to use block compression where the GPU supports it
+	bool m_bCompress;
+	// compressed format the images are uploaded in, 0 for uncompressed,
+	// chosen before the decoding threads start
+	GLenum m_compressedFormat;
+};
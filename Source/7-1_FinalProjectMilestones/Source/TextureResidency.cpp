@@ -0,0 +1,588 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureresidency.cpp
+// ============
+// the scene textures by slot, kept inside a texture memory budget
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureResidency.h"
+#include "SoftwareRasterizer.h"
+#include "StateCache.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// bytes of the one texel placeholder a texture holds while it loads
+	const size_t PLACEHOLDER_BYTES = 4;
+	// a texture is not reduced below this many texels on its longer side
+	const int MIN_REDUCED_SIZE = 32;
+	// most mip levels a texture is measured for
+	const int MAX_TEXTURE_LEVELS = 16;
+}
+
+/***********************************************************
+ *  TextureResidency()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureResidency::TextureResidency()
+{
+	m_budgetBytes = 0;
+	m_residentBytes = 0;
+	m_reservedBytes = 0;
+	m_staleBytes = 0;
+	m_reloadBytes = 0;
+	m_frame = 0;
+	m_bPinned = false;
+	m_bReportedOverBudget = false;
+	m_pSoftwareRasterizer = NULL;
+}
+
+/***********************************************************
+ *  ~TextureResidency()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureResidency::~TextureResidency()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Add()
+ *
+ *  This method is used for creating the texture of an image
+ *  file in the next texture slot. The texture holds the
+ *  loader placeholder until its image is uploaded.
+ ***********************************************************/
+int TextureResidency::Add(const char* filename, const std::string& tag)
+{
+	TEXTURE_SLOT textureSlot;
+	textureSlot.tag = tag;
+	textureSlot.filename = filename;
+	textureSlot.texture = 0;
+	textureSlot.loadingTexture = 0;
+	textureSlot.bytes = 0;
+	textureSlot.fullBytes = 0;
+	textureSlot.droppedLevels = 0;
+	textureSlot.lastUsedFrame = m_frame;
+	m_slots.push_back(textureSlot);
+
+	int slot = static_cast<int>(m_slots.size()) - 1;
+	Reload(slot);
+	return slot;
+}
+
+/***********************************************************
+ *  FindSlot()
+ *
+ *  This method is used for getting the slot of the texture
+ *  associated with the passed in tag.
+ ***********************************************************/
+int TextureResidency::FindSlot(const std::string& tag) const
+{
+	for (size_t slot = 0; slot < m_slots.size(); slot++)
+	{
+		if (m_slots[slot].tag == tag)
+		{
+			return static_cast<int>(slot);
+		}
+	}
+	return -1;
+}
+
+/***********************************************************
+ *  GetTexture()
+ *
+ *  This method is used for getting the current texture of
+ *  a slot without marking it used.
+ ***********************************************************/
+GLuint TextureResidency::GetTexture(int slot) const
+{
+	if ((slot < 0) || (slot >= GetCount()))
+	{
+		return 0;
+	}
+	return m_slots[slot].texture;
+}
+
+/***********************************************************
+ *  Use()
+ *
+ *  This method is used for marking a slot drawn this frame
+ *  and getting its texture. An evicted texture is loaded
+ *  again and draws the placeholder meanwhile. A reduced
+ *  texture is loaded again when its full image fits the
+ *  budget, and draws reduced meanwhile.
+ ***********************************************************/
+GLuint TextureResidency::Use(int slot)
+{
+	if ((slot < 0) || (slot >= GetCount()))
+	{
+		return 0;
+	}
+
+	TEXTURE_SLOT& textureSlot = m_slots[slot];
+	textureSlot.lastUsedFrame = m_frame;
+	if ((m_bPinned == false) && (textureSlot.loadingTexture == 0))
+	{
+		if (textureSlot.texture == 0)
+		{
+			Reload(slot);
+		}
+		else if ((textureSlot.droppedLevels > 0) && (FitsBudget(textureSlot) == true))
+		{
+			m_reloadBytes += textureSlot.fullBytes - textureSlot.bytes;
+			Reload(slot);
+		}
+	}
+
+	return textureSlot.texture;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for starting a new frame of use
+ *  marks, uploading the images decoded so far and evicting
+ *  or reducing textures until they fit the budget again.
+ ***********************************************************/
+void TextureResidency::Update(size_t uploadBudget)
+{
+	m_frame++;
+	m_reloadBytes = 0;
+	m_loader.Update(uploadBudget);
+	CollectUploads();
+	EnforceBudget();
+
+	m_staleBytes = 0;
+	for (const TEXTURE_SLOT& textureSlot : m_slots)
+	{
+		if ((textureSlot.loadingTexture == 0) && (textureSlot.lastUsedFrame < m_frame - 1))
+		{
+			m_staleBytes += textureSlot.bytes;
+		}
+	}
+}
+
+/***********************************************************
+ *  Finish()
+ *
+ *  This method is used for loading the full image of every
+ *  reduced or evicted texture again and waiting until every
+ *  image is uploaded, for renders that must show the full
+ *  textures. Later updates apply the budget again.
+ ***********************************************************/
+void TextureResidency::Finish()
+{
+	for (int slot = 0; (slot < GetCount()) && (m_bPinned == false); slot++)
+	{
+		if ((m_slots[slot].texture == 0) || (m_slots[slot].droppedLevels > 0))
+		{
+			Reload(slot);
+		}
+	}
+	m_loader.Finish();
+	CollectUploads();
+}
+
+/***********************************************************
+ *  EvictAll()
+ *
+ *  This method is used for deleting every texture that is
+ *  not loading, once copies of them are drawn instead, so
+ *  the budget only counts the copies. A slot that is used
+ *  again loads its image again.
+ ***********************************************************/
+void TextureResidency::EvictAll()
+{
+	for (TEXTURE_SLOT& textureSlot : m_slots)
+	{
+		if ((textureSlot.texture != 0) && (textureSlot.loadingTexture == 0))
+		{
+			Evict(textureSlot);
+		}
+	}
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for cancelling the loads, deleting
+ *  every texture and forgetting the slots. Bindless handles
+ *  of the textures have to be non-resident before this.
+ ***********************************************************/
+void TextureResidency::Destroy()
+{
+	for (TEXTURE_SLOT& textureSlot : m_slots)
+	{
+		if (textureSlot.loadingTexture != textureSlot.texture)
+		{
+			DeleteTexture(textureSlot.loadingTexture);
+		}
+		DeleteTexture(textureSlot.texture);
+	}
+	m_slots.clear();
+	m_loadingSlots.clear();
+	m_residentBytes = 0;
+	m_reservedBytes = 0;
+	m_staleBytes = 0;
+	m_reloadBytes = 0;
+	m_bPinned = false;
+	m_bReportedOverBudget = false;
+}
+
+/***********************************************************
+ *  Reload()
+ *
+ *  This method is used for queueing the full image of a
+ *  slot into a new texture. An evicted slot draws the new
+ *  texture with its placeholder right away, the others
+ *  keep drawing their texture until the image is in.
+ ***********************************************************/
+void TextureResidency::Reload(int slot)
+{
+	TEXTURE_SLOT& textureSlot = m_slots[slot];
+	if (textureSlot.loadingTexture != 0)
+	{
+		return;
+	}
+
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	m_loader.Load(textureSlot.filename.c_str(), texture);
+	textureSlot.loadingTexture = texture;
+	m_loadingSlots[texture] = slot;
+
+	if (textureSlot.texture == 0)
+	{
+		textureSlot.texture = texture;
+		textureSlot.bytes = PLACEHOLDER_BYTES;
+		textureSlot.droppedLevels = 0;
+		m_residentBytes += textureSlot.bytes;
+	}
+}
+
+/***********************************************************
+ *  CollectUploads()
+ *
+ *  This method is used for swapping every texture whose
+ *  image was uploaded in for the texture of its slot, and
+ *  measuring it.
+ ***********************************************************/
+void TextureResidency::CollectUploads()
+{
+	std::vector<GLuint> uploadedTextures;
+	m_loader.TakeUploaded(uploadedTextures);
+	for (GLuint texture : uploadedTextures)
+	{
+		std::unordered_map<GLuint, int>::iterator found = m_loadingSlots.find(texture);
+		if (found == m_loadingSlots.end())
+		{
+			continue;
+		}
+		TEXTURE_SLOT& textureSlot = m_slots[found->second];
+		m_loadingSlots.erase(found);
+
+		m_residentBytes -= textureSlot.bytes;
+		if (textureSlot.texture != texture)
+		{
+			DeleteTexture(textureSlot.texture);
+			textureSlot.texture = texture;
+		}
+		textureSlot.loadingTexture = 0;
+		textureSlot.bytes = MeasureTexture(texture);
+		textureSlot.fullBytes = textureSlot.bytes;
+		textureSlot.droppedLevels = 0;
+		m_residentBytes += textureSlot.bytes;
+	}
+}
+
+/***********************************************************
+ *  EnforceBudget()
+ *
+ *  This method is used for bringing the textures inside the
+ *  budget. The textures not drawn last frame are evicted
+ *  first, least recently drawn first. When the drawn ones
+ *  alone are over the budget, the largest of them lose
+ *  their top mip level instead, so they stay visible.
+ *  Textures that are still loading are left alone. Pinned
+ *  textures and the reserved bytes cannot be given back,
+ *  so a budget they exceed is reported once.
+ ***********************************************************/
+void TextureResidency::EnforceBudget()
+{
+	if (m_budgetBytes == 0)
+	{
+		return;
+	}
+	if (m_bPinned == true)
+	{
+		if (m_residentBytes + m_reservedBytes > m_budgetBytes)
+		{
+			ReportOverBudget();
+		}
+		return;
+	}
+
+	TRACE_ZONE("EnforceTextureBudget");
+	while (m_residentBytes + m_reservedBytes > m_budgetBytes)
+	{
+		int evictSlot = -1;
+		for (int slot = 0; slot < GetCount(); slot++)
+		{
+			const TEXTURE_SLOT& textureSlot = m_slots[slot];
+			if ((textureSlot.texture != 0) && (textureSlot.loadingTexture == 0) &&
+				(textureSlot.lastUsedFrame < m_frame - 1) &&
+				((evictSlot < 0) || (textureSlot.lastUsedFrame < m_slots[evictSlot].lastUsedFrame)))
+			{
+				evictSlot = slot;
+			}
+		}
+		if (evictSlot >= 0)
+		{
+			Evict(m_slots[evictSlot]);
+			continue;
+		}
+
+		// largest first, a texture that cannot shrink any more is skipped
+		std::vector<int> reduceSlots;
+		for (int slot = 0; slot < GetCount(); slot++)
+		{
+			if ((m_slots[slot].texture != 0) && (m_slots[slot].loadingTexture == 0))
+			{
+				reduceSlots.push_back(slot);
+			}
+		}
+		std::sort(reduceSlots.begin(), reduceSlots.end(),
+			[this](int a, int b) { return m_slots[a].bytes > m_slots[b].bytes; });
+
+		bool bReduced = false;
+		for (size_t i = 0; (i < reduceSlots.size()) && (bReduced == false); i++)
+		{
+			bReduced = DropLevel(m_slots[reduceSlots[i]]);
+		}
+		if (bReduced == false)
+		{
+			ReportOverBudget();
+			return;
+		}
+	}
+}
+
+/***********************************************************
+ *  ReportOverBudget()
+ *
+ *  This method is used for reporting once that the budget
+ *  cannot be met, with the bytes nothing can be evicted
+ *  from.
+ ***********************************************************/
+void TextureResidency::ReportOverBudget()
+{
+	if (m_bReportedOverBudget == true)
+	{
+		return;
+	}
+
+	size_t fixedBytes = m_reservedBytes + (m_bPinned ? m_residentBytes : 0);
+	std::cout << "The textures take " << ((m_residentBytes + m_reservedBytes) >> 20) << " MB, over the texture budget of "
+		<< (m_budgetBytes >> 20) << " MB, " << (fixedBytes >> 20)
+		<< " MB of them in texture arrays or bindless handles that cannot be evicted" << std::endl;
+	m_bReportedOverBudget = true;
+}
+
+/***********************************************************
+ *  FitsBudget()
+ *
+ *  This method is used for checking whether the full image
+ *  of a reduced slot fits the budget, counting the textures
+ *  not drawn last frame as free, since they are evicted
+ *  before any drawn texture is reduced.
+ ***********************************************************/
+bool TextureResidency::FitsBudget(const TEXTURE_SLOT& textureSlot) const
+{
+	if (m_budgetBytes == 0)
+	{
+		return true;
+	}
+
+	size_t neededBytes = m_residentBytes + m_reservedBytes + m_reloadBytes + (textureSlot.fullBytes - textureSlot.bytes);
+	return neededBytes <= m_budgetBytes + m_staleBytes;
+}
+
+/***********************************************************
+ *  DropLevel()
+ *
+ *  This method is used for replacing the texture of a slot
+ *  by a new texture that starts at its second mip level,
+ *  copied over on the GPU, which takes about a quarter of
+ *  the memory. False is returned when the texture has no
+ *  mip levels to spare or image copies are not supported.
+ ***********************************************************/
+bool TextureResidency::DropLevel(TEXTURE_SLOT& textureSlot)
+{
+	if ((GLEW_VERSION_4_3 == GL_FALSE) && (GLEW_ARB_copy_image == GL_FALSE))
+	{
+		return false;
+	}
+
+	StateCache::ActiveTexture(TextureLoader::UPLOAD_TEXTURE_UNIT);
+	StateCache::BindTexture2D(textureSlot.texture);
+
+	GLint width = 0;
+	GLint height = 0;
+	GLint internalFormat = 0;
+	GLint compressed = GL_FALSE;
+	GLint maxLevel = 0;
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+	glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+
+	// the levels the texture really has, generated mipmaps go down to one texel
+	int levels = 1;
+	while ((levels <= maxLevel) && (levels < MAX_TEXTURE_LEVELS) && ((std::max(width, height) >> levels) > 0))
+	{
+		levels++;
+	}
+	if ((levels < 2) || ((std::max(width, height) >> 1) < MIN_REDUCED_SIZE))
+	{
+		return false;
+	}
+
+	std::vector<GLint> levelSizes(levels, 0);
+	for (int level = 1; (level < levels) && (compressed == GL_TRUE); level++)
+	{
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &levelSizes[level]);
+	}
+	GLint parameters[4] = { GL_TEXTURE_WRAP_S, GL_TEXTURE_WRAP_T, GL_TEXTURE_MIN_FILTER, GL_TEXTURE_MAG_FILTER };
+	GLint parameterValues[4];
+	for (int i = 0; i < 4; i++)
+	{
+		glGetTexParameteriv(GL_TEXTURE_2D, parameters[i], &parameterValues[i]);
+	}
+
+	GLuint reduced = 0;
+	glGenTextures(1, &reduced);
+	StateCache::BindTexture2D(reduced);
+	for (int level = 1; level < levels; level++)
+	{
+		GLsizei levelWidth = std::max(1, width >> level);
+		GLsizei levelHeight = std::max(1, height >> level);
+		if (compressed == GL_TRUE)
+		{
+			glCompressedTexImage2D(GL_TEXTURE_2D, level - 1, internalFormat, levelWidth, levelHeight, 0, levelSizes[level], NULL);
+		}
+		else
+		{
+			glTexImage2D(GL_TEXTURE_2D, level - 1, internalFormat, levelWidth, levelHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		}
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 2);
+	for (int i = 0; i < 4; i++)
+	{
+		glTexParameteri(GL_TEXTURE_2D, parameters[i], parameterValues[i]);
+	}
+	for (int level = 1; level < levels; level++)
+	{
+		glCopyImageSubData(textureSlot.texture, GL_TEXTURE_2D, level, 0, 0, 0,
+			reduced, GL_TEXTURE_2D, level - 1, 0, 0, 0,
+			std::max(1, width >> level), std::max(1, height >> level), 1);
+	}
+
+	m_residentBytes -= textureSlot.bytes;
+	DeleteTexture(textureSlot.texture);
+	textureSlot.texture = reduced;
+	textureSlot.bytes = MeasureTexture(reduced);
+	textureSlot.droppedLevels++;
+	m_residentBytes += textureSlot.bytes;
+	return true;
+}
+
+/***********************************************************
+ *  Evict()
+ *
+ *  This method is used for deleting the texture of a slot.
+ *  The slot is loaded again the next time it is drawn.
+ ***********************************************************/
+void TextureResidency::Evict(TEXTURE_SLOT& textureSlot)
+{
+	m_residentBytes -= textureSlot.bytes;
+	DeleteTexture(textureSlot.texture);
+	textureSlot.texture = 0;
+	textureSlot.bytes = 0;
+	textureSlot.droppedLevels = 0;
+}
+
+/***********************************************************
+ *  DeleteTexture()
+ *
+ *  This method is used for cancelling any load into a
+ *  texture, dropping it from the state cache and the
+ *  software rasterizer and deleting it. OpenGL may give the
+ *  name to the next texture created.
+ ***********************************************************/
+void TextureResidency::DeleteTexture(GLuint texture)
+{
+	if (texture == 0)
+	{
+		return;
+	}
+
+	m_loader.Cancel(texture);
+	m_loadingSlots.erase(texture);
+	StateCache::ForgetTexture(texture);
+	if (m_pSoftwareRasterizer != NULL)
+	{
+		m_pSoftwareRasterizer->ForgetTexture(texture);
+	}
+	glDeleteTextures(1, &texture);
+}
+
+/***********************************************************
+ *  MeasureTexture()
+ *
+ *  This method is used for adding up the GPU bytes of every
+ *  mip level of a texture. Uncompressed texels are counted
+ *  as four bytes, as drivers pad RGB images to RGBA.
+ ***********************************************************/
+size_t TextureResidency::MeasureTexture(GLuint texture)
+{
+	StateCache::ActiveTexture(TextureLoader::UPLOAD_TEXTURE_UNIT);
+	StateCache::BindTexture2D(texture);
+
+	GLint maxLevel = 0;
+	GLint compressed = GL_FALSE;
+	glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+
+	size_t bytes = 0;
+	for (int level = 0; (level <= maxLevel) && (level < MAX_TEXTURE_LEVELS); level++)
+	{
+		GLint width = 0;
+		GLint height = 0;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &height);
+		if ((width == 0) || (height == 0))
+		{
+			break;
+		}
+
+		if (compressed == GL_TRUE)
+		{
+			GLint levelSize = 0;
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &levelSize);
+			bytes += static_cast<size_t>(levelSize);
+		}
+		else
+		{
+			bytes += static_cast<size_t>(width) * height * 4;
+		}
+	}
+
+	return bytes;
+}
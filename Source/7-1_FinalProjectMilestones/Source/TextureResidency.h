@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureresidency.h
+// ============
+// the scene textures by slot, kept inside a texture memory budget
+//
+//  Every texture slot keeps its tag, image file and the GPU bytes its
+//  texture takes. Drawing with a slot marks it used for the frame. Once
+//  per frame, when the textures take more than the budget, the textures
+//  that were not drawn lately are deleted, least recently used first, and
+//  then the largest of the drawn ones lose their top mip level. A deleted
+//  texture is loaded again the next time it is drawn, and a reduced one
+//  once its full image fits the budget again, drawing the old texture
+//  until the new one is uploaded. Reducing or reloading gives the slot a
+//  new texture name, so the name has to be looked up per frame.
+//
+//  Texture memory the slots cannot give back, the texture arrays or the
+//  textures pinned by bindless handles, still counts against the budget.
+//  When it alone is over the budget that is reported, as nothing can be
+//  evicted to meet it.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "TextureLoader.h"
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class SoftwareRasterizer;
+
+class TextureResidency
+{
+public:
+	// constructor
+	TextureResidency();
+	// destructor
+	~TextureResidency();
+
+	// upload the images block compressed where the GPU supports it, call
+	// before the first Add
+	void SetCompression(bool bCompress) { m_loader.SetCompression(bCompress); }
+	// bytes of texture memory the slots may take, 0 for no limit
+	void SetBudget(size_t budgetBytes) { m_budgetBytes = budgetBytes; }
+	// true keeps every texture and its name as they are, while bindless
+	// handles of them are resident
+	void SetPinned(bool bPinned) { m_bPinned = bPinned; m_bReportedOverBudget = false; }
+	// bytes of texture memory outside the slots the budget has to cover
+	void SetReservedBytes(size_t reservedBytes) { m_reservedBytes = reservedBytes; m_bReportedOverBudget = false; }
+	// rasterizer whose copies of the textures are dropped with them, NULL
+	// when drawing with OpenGL
+	void SetSoftwareRasterizer(SoftwareRasterizer* pRasterizer) { m_pSoftwareRasterizer = pRasterizer; }
+
+	// create a texture for the image file in the next slot, returns the slot
+	int Add(const char* filename, const std::string& tag);
+	// find the slot of a tag, -1 when there is none
+	int FindSlot(const std::string& tag) const;
+	// number of texture slots
+	int GetCount() const { return static_cast<int>(m_slots.size()); }
+	// current texture of a slot, 0 while it is evicted
+	GLuint GetTexture(int slot) const;
+	// mark the slot used this frame and get its texture, loading it again
+	// when it was evicted
+	GLuint Use(int slot);
+
+	// upload decoded images, then keep the textures inside the budget,
+	// once per frame before drawing
+	void Update(size_t uploadBudget);
+	// load every reduced or evicted texture again and wait for all uploads
+	void Finish();
+	// delete every loaded texture, for when copies of them are drawn
+	// instead, each loads again the next time its slot is used
+	void EvictAll();
+	// number of images that are not uploaded yet
+	int GetPendingCount() const { return m_loader.GetPendingCount(); }
+	// GPU bytes of all current textures
+	size_t GetResidentBytes() const { return m_residentBytes; }
+	// delete every texture and forget the slots
+	void Destroy();
+
+private:
+	struct TEXTURE_SLOT
+	{
+		std::string tag;
+		std::string filename;
+		// texture drawn for the slot, 0 while evicted
+		GLuint texture;
+		// texture the full image is loading into, 0 when none is
+		GLuint loadingTexture;
+		// GPU bytes of the texture, and of it with every mip level
+		size_t bytes;
+		size_t fullBytes;
+		// top mip levels the texture lost to the budget
+		int droppedLevels;
+		// frame the slot was last drawn in
+		int lastUsedFrame;
+	};
+
+	// load the full image of a slot into a new texture
+	void Reload(int slot);
+	// swap the uploaded textures in for the ones they replace
+	void CollectUploads();
+	// evict and reduce textures until they fit the budget
+	void EnforceBudget();
+	// report once that the budget cannot be met
+	void ReportOverBudget();
+	// true when the full image of a reduced slot fits the budget
+	bool FitsBudget(const TEXTURE_SLOT& textureSlot) const;
+	// replace the texture of a slot by a copy without its top mip level
+	bool DropLevel(TEXTURE_SLOT& textureSlot);
+	// delete the texture of a slot
+	void Evict(TEXTURE_SLOT& textureSlot);
+	// cancel the load of a texture and delete it
+	void DeleteTexture(GLuint texture);
+	// GPU bytes of every mip level of a texture
+	static size_t MeasureTexture(GLuint texture);
+
+	TextureLoader m_loader;
+	std::vector<TEXTURE_SLOT> m_slots;
+	// slot each loading texture belongs to
+	std::unordered_map<GLuint, int> m_loadingSlots;
+	SoftwareRasterizer* m_pSoftwareRasterizer;
+	size_t m_budgetBytes;
+	size_t m_residentBytes;
+	size_t m_reservedBytes;
+	// bytes of the textures not drawn last frame, which are evicted
+	// first, and the bytes the full images loading this frame add
+	size_t m_staleBytes;
+	size_t m_reloadBytes;
+	// number of Update calls, the frame the slots are marked used in
+	int m_frame;
+	bool m_bPinned;
+	// true once the budget could not be met, so it is reported once
+	bool m_bReportedOverBudget;
+};
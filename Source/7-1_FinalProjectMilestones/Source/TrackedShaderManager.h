@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+// trackedshadermanager.h
+// ============
+// shader manager that reports its uniform uploads to the render statistics
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "UniformBlocks.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+/***********************************************************
+ *  UNIFORM_NAME
+ *
+ *  The name of a uniform together with a 64-bit FNV-1a hash
+ *  of it. Names declared as constexpr constants are hashed
+ *  by the compiler, names built at run time are hashed when
+ *  they are passed in.
+ ***********************************************************/
+struct UNIFORM_NAME
+{
+	constexpr UNIFORM_NAME(const char* uniformName) : name(uniformName), hash(Hash(uniformName)) {}
+
+	static constexpr uint64_t Hash(const char* text)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (; *text != '\0'; text++)
+		{
+			hash = (hash ^ static_cast<unsigned char>(*text)) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	const char* name;
+	uint64_t hash;
+};
+
+/***********************************************************
+ *  TrackedShaderManager
+ *
+ *  The scene and view managers upload every uniform through
+ *  this class, so each set*Value call can be counted before
+ *  it is passed on to OpenGL. The last value of every
+ *  uniform is kept, and an upload of the value a uniform
+ *  already holds is counted as redundant and dropped.
+ *
+ *  The uniform locations are looked up once per program and
+ *  kept by name hash, so an upload is a map lookup on an
+ *  integer and the glUniform call, with no string work.
+ *
+ *  It also holds the camera and light uniform blocks, which
+ *  the programs other than the course program read.
+ ***********************************************************/
+class TrackedShaderManager : public ShaderManager
+{
+public:
+	// constructor
+	TrackedShaderManager();
+
+	// make the program current and start a new location cache for it
+	void use();
+
+	void setBoolValue(const UNIFORM_NAME& name, bool value);
+	void setIntValue(const UNIFORM_NAME& name, int value);
+	void setFloatValue(const UNIFORM_NAME& name, float value);
+	void setSampler2DValue(const UNIFORM_NAME& name, int value);
+	void setVec2Value(const UNIFORM_NAME& name, const glm::vec2& value);
+	void setVec3Value(const UNIFORM_NAME& name, const glm::vec3& value);
+	void setVec3Value(const UNIFORM_NAME& name, float x, float y, float z);
+	void setVec4Value(const UNIFORM_NAME& name, const glm::vec4& value);
+	void setMat4Value(const UNIFORM_NAME& name, const glm::mat4& value);
+
+	// find a uniform location of the current program once, -1 when the
+	// program has no such uniform
+	GLint GetLocation(const UNIFORM_NAME& name);
+	// forget the last uniform values, needed after switching programs
+	void ResetUniformCache() { m_lastValues.clear(); }
+	// copy the last values set for a uniform, false when it was never set
+	bool GetUniformValue(const UNIFORM_NAME& name, float* values, int count) const;
+	// get the camera and light blocks shared by the programs
+	UniformBlocks& GetUniformBlocks() { return m_uniformBlocks; }
+
+private:
+	struct UNIFORM_VALUE
+	{
+		float values[16];
+		int count;
+	};
+
+	// count the upload and remember the value, true when it was already set
+	bool CountUpload(const UNIFORM_NAME& name, const float* values, int count);
+
+	// last value uploaded to each uniform of the program in use, by name hash
+	std::unordered_map<uint64_t, UNIFORM_VALUE> m_lastValues;
+	// program the locations were looked up in
+	GLuint m_locationProgram;
+	// locations looked up so far, by name hash
+	std::unordered_map<uint64_t, GLint> m_locations;
+	// camera and light buffers, written next to the uniforms of the course program
+	UniformBlocks m_uniformBlocks;
+};
@@ -0,0 +1,715 @@
+///////////////////////////////////////////////////////////////////////////////
+// trackedshapemeshes.cpp
+// ============
+// shape meshes that report their draws to the render statistics
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TrackedShapeMeshes.h"
+#include "SoftwareRasterizer.h"
+#include "Trace.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables and helper functions
+namespace
+{
+	// attribute location of the object index of an instance
+	const GLuint INSTANCE_ATTRIBUTE = 3;
+
+	// key of a mesh variant in the instanced mesh table
+	int GetMeshKey(RenderStats::MESH_TYPE meshType, int variant)
+	{
+		return meshType * 8 + variant;
+	}
+
+	// hash and compare captured vertices bit for bit, so the copies a
+	// fan or strip capture repeats are merged into one indexed vertex
+	struct VERTEX_HASH
+	{
+		size_t operator()(const MeshCapture::MESH_VERTEX& vertex) const
+		{
+			uint32_t words[8];
+			std::memcpy(words, &vertex, sizeof(words));
+			size_t hash = 2166136261u;
+			for (uint32_t word : words)
+			{
+				hash = (hash ^ word) * 16777619u;
+			}
+			return hash;
+		}
+	};
+	struct VERTEX_EQUAL
+	{
+		bool operator()(const MeshCapture::MESH_VERTEX& a, const MeshCapture::MESH_VERTEX& b) const
+		{
+			return std::memcmp(&a, &b, sizeof(a)) == 0;
+		}
+	};
+}
+
+/***********************************************************
+ *  TrackedShapeMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TrackedShapeMeshes::TrackedShapeMeshes()
+{
+	m_pSoftwareRasterizer = NULL;
+	m_packedVertexArray = 0;
+	m_packedVertexBuffer = 0;
+	m_packedIndexBuffer = 0;
+	m_bPackedDirty = false;
+	m_instanceBuffer = 0;
+	m_indirectBuffer = 0;
+	m_bakedVertexArray = 0;
+	m_bakedVertexBuffer = 0;
+	m_bakedIndexBuffer = 0;
+	m_bBakedDirty = false;
+}
+
+/***********************************************************
+ *  ~TrackedShapeMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TrackedShapeMeshes::~TrackedShapeMeshes()
+{
+	DestroyBakedMeshes();
+	DestroyInstancedMeshes();
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing a mesh picked by its
+ *  type, with the part flags of a DRAW_ITEM variant.
+ ***********************************************************/
+void TrackedShapeMeshes::DrawMesh(RenderStats::MESH_TYPE meshType, int variant)
+{
+	bool bTop = (variant & 1) != 0;
+	bool bBottom = (variant & 2) != 0;
+	bool bSides = (variant & 4) != 0;
+
+	switch (meshType)
+	{
+	case RenderStats::MESH_BOX:
+		DrawBoxMesh();
+		break;
+	case RenderStats::MESH_CONE:
+		DrawConeMesh(variant != 0);
+		break;
+	case RenderStats::MESH_CYLINDER:
+		DrawCylinderMesh(bTop, bBottom, bSides);
+		break;
+	case RenderStats::MESH_PLANE:
+		DrawPlaneMesh();
+		break;
+	case RenderStats::MESH_PRISM:
+		DrawPrismMesh();
+		break;
+	case RenderStats::MESH_PYRAMID4:
+		DrawPyramid4Mesh();
+		break;
+	case RenderStats::MESH_SPHERE:
+		DrawSphereMesh();
+		break;
+	case RenderStats::MESH_TAPERED_CYLINDER:
+		DrawTaperedCylinderMesh(bTop, bBottom, bSides);
+		break;
+	case RenderStats::MESH_TORUS:
+		DrawTorusMesh();
+		break;
+	default:
+		break;
+	}
+}
+
+void TrackedShapeMeshes::DrawBoxMesh()
+{
+	TRACE_ZONE("DrawBoxMesh");
+	if (BeginDraw(RenderStats::MESH_BOX, 0) == true)
+	{
+		ShapeMeshes::DrawBoxMesh();
+		EndDraw();
+	}
+}
+
+void TrackedShapeMeshes::DrawConeMesh(bool bDrawBottom)
+{
+	TRACE_ZONE("DrawConeMesh");
+	if (BeginDraw(RenderStats::MESH_CONE, bDrawBottom ? 1 : 0) == true)
+	{
+		ShapeMeshes::DrawConeMesh(bDrawBottom);
+		EndDraw();
+	}
+}
+
+void TrackedShapeMeshes::DrawCylinderMesh(bool bDrawTop, bool bDrawBottom, bool bDrawSides)
+{
+	TRACE_ZONE("DrawCylinderMesh");
+	if (BeginDraw(RenderStats::MESH_CYLINDER, (bDrawTop ? 1 : 0) | (bDrawBottom ? 2 : 0) | (bDrawSides ? 4 : 0)) == true)
+	{
+		ShapeMeshes::DrawCylinderMesh(bDrawTop, bDrawBottom, bDrawSides);
+		EndDraw();
+	}
+}
+
+void TrackedShapeMeshes::DrawPlaneMesh()
+{
+	TRACE_ZONE("DrawPlaneMesh");
+	if (BeginDraw(RenderStats::MESH_PLANE, 0) == true)
+	{
+		ShapeMeshes::DrawPlaneMesh();
+		EndDraw();
+	}
+}
+
+void TrackedShapeMeshes::DrawPrismMesh()
+{
+	TRACE_ZONE("DrawPrismMesh");
+	if (BeginDraw(RenderStats::MESH_PRISM, 0) == true)
+	{
+		ShapeMeshes::DrawPrismMesh();
+		EndDraw();
+	}
+}
+
+void TrackedShapeMeshes::DrawPyramid4Mesh()
+{
+	TRACE_ZONE("DrawPyramid4Mesh");
+	if (BeginDraw(RenderStats::MESH_PYRAMID4, 0) == true)
+	{
+		ShapeMeshes::DrawPyramid4Mesh();
+		EndDraw();
+	}
+}
+
+void TrackedShapeMeshes::DrawSphereMesh()
+{
+	TRACE_ZONE("DrawSphereMesh");
+	if (BeginDraw(RenderStats::MESH_SPHERE, 0) == true)
+	{
+		ShapeMeshes::DrawSphereMesh();
+		EndDraw();
+	}
+}
+
+void TrackedShapeMeshes::DrawTaperedCylinderMesh(bool bDrawTop, bool bDrawBottom, bool bDrawSides)
+{
+	TRACE_ZONE("DrawTaperedCylinderMesh");
+	if (BeginDraw(RenderStats::MESH_TAPERED_CYLINDER, (bDrawTop ? 1 : 0) | (bDrawBottom ? 2 : 0) | (bDrawSides ? 4 : 0)) == true)
+	{
+		ShapeMeshes::DrawTaperedCylinderMesh(bDrawTop, bDrawBottom, bDrawSides);
+		EndDraw();
+	}
+}
+
+void TrackedShapeMeshes::DrawTorusMesh()
+{
+	TRACE_ZONE("DrawTorusMesh");
+	if (BeginDraw(RenderStats::MESH_TORUS, 0) == true)
+	{
+		ShapeMeshes::DrawTorusMesh();
+		EndDraw();
+	}
+}
+
+/***********************************************************
+ *  BeginDraw()
+ *
+ *  This method is used for passing the draw to the recorder
+ *  while one is set, or else counting it and handing it to
+ *  the software rasterizer when one is attached. The OpenGL
+ *  draw only runs without either, or once per mesh variant
+ *  while the rasterizer captures its triangles.
+ ***********************************************************/
+bool TrackedShapeMeshes::BeginDraw(RenderStats::MESH_TYPE meshType, int variant)
+{
+	if (m_recorder)
+	{
+		m_recorder(meshType, variant);
+		return false;
+	}
+
+	RenderStats::CountDrawCall(meshType);
+	if (m_pSoftwareRasterizer == NULL)
+	{
+		return true;
+	}
+
+	return m_pSoftwareRasterizer->SubmitDraw(meshType, variant);
+}
+
+/***********************************************************
+ *  EndDraw()
+ *
+ *  This method is used for finishing a mesh capture of the
+ *  software rasterizer after the OpenGL draw.
+ ***********************************************************/
+void TrackedShapeMeshes::EndDraw()
+{
+	if (m_pSoftwareRasterizer != NULL)
+	{
+		m_pSoftwareRasterizer->EndMeshCapture();
+	}
+}
+
+/***********************************************************
+ *  DrawShapeMesh()
+ *
+ *  This method is used for running the ShapeMeshes draw of
+ *  a mesh variant directly, so it is neither counted nor
+ *  handed to the recorder or the software rasterizer.
+ ***********************************************************/
+void TrackedShapeMeshes::DrawShapeMesh(RenderStats::MESH_TYPE meshType, int variant)
+{
+	bool bTop = (variant & 1) != 0;
+	bool bBottom = (variant & 2) != 0;
+	bool bSides = (variant & 4) != 0;
+
+	switch (meshType)
+	{
+	case RenderStats::MESH_BOX:
+		ShapeMeshes::DrawBoxMesh();
+		break;
+	case RenderStats::MESH_CONE:
+		ShapeMeshes::DrawConeMesh(variant != 0);
+		break;
+	case RenderStats::MESH_CYLINDER:
+		ShapeMeshes::DrawCylinderMesh(bTop, bBottom, bSides);
+		break;
+	case RenderStats::MESH_PLANE:
+		ShapeMeshes::DrawPlaneMesh();
+		break;
+	case RenderStats::MESH_PRISM:
+		ShapeMeshes::DrawPrismMesh();
+		break;
+	case RenderStats::MESH_PYRAMID4:
+		ShapeMeshes::DrawPyramid4Mesh();
+		break;
+	case RenderStats::MESH_SPHERE:
+		ShapeMeshes::DrawSphereMesh();
+		break;
+	case RenderStats::MESH_TAPERED_CYLINDER:
+		ShapeMeshes::DrawTaperedCylinderMesh(bTop, bBottom, bSides);
+		break;
+	case RenderStats::MESH_TORUS:
+		ShapeMeshes::DrawTorusMesh();
+		break;
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  PrepareInstancedMesh()
+ *
+ *  This method is used for capturing the triangles of a
+ *  mesh variant from ShapeMeshes and appending them as an
+ *  indexed mesh to the packed buffers, which the instanced
+ *  and indirect draws share. Meshes are only captured once.
+ ***********************************************************/
+bool TrackedShapeMeshes::PrepareInstancedMesh(RenderStats::MESH_TYPE meshType, int variant)
+{
+	int meshKey = GetMeshKey(meshType, variant);
+	if (m_instancedMeshes.find(meshKey) != m_instancedMeshes.end())
+	{
+		return true;
+	}
+	if ((m_capture.IsCreated() == false) && (m_capture.Create() == false))
+	{
+		return false;
+	}
+
+	TRACE_ZONE("PrepareInstancedMesh");
+	std::vector<MeshCapture::MESH_VERTEX> triangles;
+	m_capture.Begin();
+	DrawShapeMesh(meshType, variant);
+	m_capture.End(triangles);
+
+	// merge the repeated vertices of the triangle list into an indexed mesh,
+	// the indices count from the first vertex of the mesh
+	INSTANCED_MESH mesh;
+	mesh.firstIndex = static_cast<GLuint>(m_packedIndices.size());
+	mesh.baseVertex = static_cast<GLint>(m_packedVertices.size());
+	std::unordered_map<MeshCapture::MESH_VERTEX, GLuint, VERTEX_HASH, VERTEX_EQUAL> vertexIndices;
+	for (const MeshCapture::MESH_VERTEX& vertex : triangles)
+	{
+		std::pair<std::unordered_map<MeshCapture::MESH_VERTEX, GLuint, VERTEX_HASH, VERTEX_EQUAL>::iterator, bool> inserted =
+			vertexIndices.insert(std::make_pair(vertex, static_cast<GLuint>(m_packedVertices.size() - mesh.baseVertex)));
+		if (inserted.second == true)
+		{
+			m_packedVertices.push_back(vertex);
+		}
+		m_packedIndices.push_back(inserted.first->second);
+	}
+	mesh.vertexCount = static_cast<GLsizei>(m_packedVertices.size() - mesh.baseVertex);
+	mesh.indexCount = static_cast<GLsizei>(m_packedIndices.size() - mesh.firstIndex);
+
+	m_instancedMeshes[meshKey] = mesh;
+	m_bPackedDirty = true;
+	return true;
+}
+
+/***********************************************************
+ *  BindPackedMeshes()
+ *
+ *  This method is used for binding the VAO of the packed
+ *  meshes. The VAO is made with the first mesh, and the
+ *  buffers are uploaded again whenever meshes were added
+ *  since the last draw.
+ ***********************************************************/
+void TrackedShapeMeshes::BindPackedMeshes()
+{
+	if (m_packedVertexArray == 0)
+	{
+		if (m_instanceBuffer == 0)
+		{
+			glGenBuffers(1, &m_instanceBuffer);
+		}
+		glGenVertexArrays(1, &m_packedVertexArray);
+		glGenBuffers(1, &m_packedVertexBuffer);
+		glGenBuffers(1, &m_packedIndexBuffer);
+		glBindVertexArray(m_packedVertexArray);
+
+		glBindBuffer(GL_ARRAY_BUFFER, m_packedVertexBuffer);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_packedIndexBuffer);
+		GLsizei vertexStride = sizeof(MeshCapture::MESH_VERTEX);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, vertexStride, (void*)offsetof(MeshCapture::MESH_VERTEX, position));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, vertexStride, (void*)offsetof(MeshCapture::MESH_VERTEX, normal));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, vertexStride, (void*)offsetof(MeshCapture::MESH_VERTEX, uv));
+
+		// the object index advances once per instance instead of per vertex
+		glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+		glEnableVertexAttribArray(INSTANCE_ATTRIBUTE);
+		glVertexAttribIPointer(INSTANCE_ATTRIBUTE, 1, GL_UNSIGNED_INT, sizeof(GLuint), NULL);
+		glVertexAttribDivisor(INSTANCE_ATTRIBUTE, 1);
+	}
+	else
+	{
+		glBindVertexArray(m_packedVertexArray);
+	}
+
+	if (m_bPackedDirty == true)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_packedVertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, m_packedVertices.size() * sizeof(MeshCapture::MESH_VERTEX), m_packedVertices.data(), GL_STATIC_DRAW);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_packedIndices.size() * sizeof(GLuint), m_packedIndices.data(), GL_STATIC_DRAW);
+		m_bPackedDirty = false;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  SetInstances()
+ *
+ *  This method is used for uploading the object index of
+ *  every instance the following instanced draws read.
+ ***********************************************************/
+void TrackedShapeMeshes::SetInstances(const std::vector<GLuint>& objectIndices)
+{
+	if (m_instanceBuffer == 0)
+	{
+		glGenBuffers(1, &m_instanceBuffer);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, objectIndices.size() * sizeof(GLuint), objectIndices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  DrawMeshInstanced()
+ *
+ *  This method is used for drawing a run of instances of a
+ *  prepared mesh with one glDrawElementsInstanced call. The
+ *  base vertex finds the mesh in the packed buffers and the
+ *  base instance picks the run out of the instance buffer.
+ ***********************************************************/
+void TrackedShapeMeshes::DrawMeshInstanced(RenderStats::MESH_TYPE meshType, int variant, int firstInstance, int instanceCount)
+{
+	TRACE_ZONE("DrawMeshInstanced");
+	std::unordered_map<int, INSTANCED_MESH>::const_iterator found = m_instancedMeshes.find(GetMeshKey(meshType, variant));
+	if ((found == m_instancedMeshes.end()) || (instanceCount <= 0))
+	{
+		return;
+	}
+
+	RenderStats::CountDrawCall(meshType);
+	RenderStats::CountInstances(instanceCount);
+	if (found->second.indexCount == 0)
+	{
+		return;
+	}
+
+	BindPackedMeshes();
+	glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, found->second.indexCount, GL_UNSIGNED_INT,
+		(void*)(static_cast<size_t>(found->second.firstIndex) * sizeof(GLuint)),
+		instanceCount, found->second.baseVertex, static_cast<GLuint>(firstInstance));
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  GetDrawCommand()
+ *
+ *  This method is used for filling in the multi-draw
+ *  command that draws a run of instances of a prepared
+ *  mesh, false when the mesh was never prepared.
+ ***********************************************************/
+bool TrackedShapeMeshes::GetDrawCommand(RenderStats::MESH_TYPE meshType, int variant, int firstInstance, int instanceCount, DRAW_COMMAND& command) const
+{
+	std::unordered_map<int, INSTANCED_MESH>::const_iterator found = m_instancedMeshes.find(GetMeshKey(meshType, variant));
+	if (found == m_instancedMeshes.end())
+	{
+		return false;
+	}
+
+	command.indexCount = static_cast<GLuint>(found->second.indexCount);
+	command.instanceCount = static_cast<GLuint>(instanceCount);
+	command.firstIndex = found->second.firstIndex;
+	command.baseVertex = found->second.baseVertex;
+	command.baseInstance = static_cast<GLuint>(firstInstance);
+	return true;
+}
+
+/***********************************************************
+ *  SetDrawCommands()
+ *
+ *  This method is used for uploading the commands the
+ *  following indirect draws read.
+ ***********************************************************/
+void TrackedShapeMeshes::SetDrawCommands(const std::vector<DRAW_COMMAND>& commands)
+{
+	static_assert(sizeof(DRAW_COMMAND) == 5 * sizeof(GLuint), "DRAW_COMMAND must match DrawElementsIndirectCommand");
+	if (m_indirectBuffer == 0)
+	{
+		glGenBuffers(1, &m_indirectBuffer);
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DRAW_COMMAND), commands.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	m_drawCommands = commands;
+}
+
+/***********************************************************
+ *  DrawMeshesIndirect()
+ *
+ *  This method is used for drawing a range of the uploaded
+ *  commands with one glMultiDrawElementsIndirect call. The
+ *  base instance of each command leads the shader to the
+ *  objects of its draws.
+ ***********************************************************/
+void TrackedShapeMeshes::DrawMeshesIndirect(int firstCommand, int commandCount)
+{
+	TRACE_ZONE("DrawMeshesIndirect");
+	if ((commandCount <= 0) || (firstCommand + commandCount > static_cast<int>(m_drawCommands.size())))
+	{
+		return;
+	}
+
+	int instanceCount = 0;
+	for (int index = firstCommand; index < firstCommand + commandCount; index++)
+	{
+		instanceCount += static_cast<int>(m_drawCommands[index].instanceCount);
+	}
+	RenderStats::CountMultiDraw(commandCount);
+	RenderStats::CountInstances(instanceCount);
+
+	BindPackedMeshes();
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+		(void*)(static_cast<size_t>(firstCommand) * sizeof(DRAW_COMMAND)), commandCount, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DestroyInstancedMeshes()
+ *
+ *  This method is used for freeing the packed meshes and
+ *  the instance and indirect buffers.
+ ***********************************************************/
+void TrackedShapeMeshes::DestroyInstancedMeshes()
+{
+	if (m_packedVertexArray != 0)
+	{
+		glDeleteVertexArrays(1, &m_packedVertexArray);
+		glDeleteBuffers(1, &m_packedVertexBuffer);
+		glDeleteBuffers(1, &m_packedIndexBuffer);
+		m_packedVertexArray = 0;
+		m_packedVertexBuffer = 0;
+		m_packedIndexBuffer = 0;
+	}
+	m_instancedMeshes.clear();
+	m_packedVertices.clear();
+	m_packedIndices.clear();
+	m_bPackedDirty = false;
+
+	if (m_instanceBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_instanceBuffer);
+		m_instanceBuffer = 0;
+	}
+	if (m_indirectBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_indirectBuffer);
+		m_indirectBuffer = 0;
+	}
+	m_drawCommands.clear();
+	m_capture.Destroy();
+}
+
+/***********************************************************
+ *  BakeMesh()
+ *
+ *  This method is used for merging the passed in objects
+ *  into one mesh in world space. The vertices of every
+ *  object's indexed copy are moved by its model matrix, the
+ *  normals by the inverse transpose of it, and the texture
+ *  coordinates are scaled by its UV scale, so the course
+ *  shaders draw the baked mesh with an identity model and
+ *  a UV scale of 1 and get the same result.
+ ***********************************************************/
+int TrackedShapeMeshes::BakeMesh(const std::vector<BAKE_OBJECT>& objects)
+{
+	TRACE_ZONE("BakeMesh");
+
+	// every mesh is captured before the vertex count can be checked
+	size_t vertexCount = 0;
+	for (const BAKE_OBJECT& object : objects)
+	{
+		if (PrepareInstancedMesh(object.meshType, object.variant) == false)
+		{
+			return -1;
+		}
+		vertexCount += m_instancedMeshes[GetMeshKey(object.meshType, object.variant)].vertexCount;
+	}
+	if (m_bakedVertices.size() + vertexCount > BAKED_VERTEX_LIMIT)
+	{
+		return -1;
+	}
+
+	BAKED_MESH baked;
+	baked.firstIndex = static_cast<GLuint>(m_bakedIndices.size());
+	baked.objectCount = static_cast<int>(objects.size());
+	for (const BAKE_OBJECT& object : objects)
+	{
+		const INSTANCED_MESH& mesh = m_instancedMeshes[GetMeshKey(object.meshType, object.variant)];
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(object.model)));
+		GLuint firstVertex = static_cast<GLuint>(m_bakedVertices.size());
+		for (GLsizei index = 0; index < mesh.indexCount; index++)
+		{
+			m_bakedIndices.push_back(firstVertex + m_packedIndices[mesh.firstIndex + index]);
+		}
+		for (GLsizei index = 0; index < mesh.vertexCount; index++)
+		{
+			MeshCapture::MESH_VERTEX vertex = m_packedVertices[mesh.baseVertex + index];
+			vertex.position = glm::vec3(object.model * glm::vec4(vertex.position, 1.0f));
+			vertex.normal = normalMatrix * vertex.normal;
+			vertex.uv *= object.uvScale;
+			m_bakedVertices.push_back(vertex);
+		}
+	}
+	baked.indexCount = static_cast<GLsizei>(m_bakedIndices.size() - baked.firstIndex);
+
+	m_bakedMeshes.push_back(baked);
+	m_bBakedDirty = true;
+	return static_cast<int>(m_bakedMeshes.size()) - 1;
+}
+
+/***********************************************************
+ *  BindBakedMeshes()
+ *
+ *  This method is used for binding the VAO of the baked
+ *  meshes, and for uploading them again whenever meshes
+ *  were baked since the last draw.
+ ***********************************************************/
+void TrackedShapeMeshes::BindBakedMeshes()
+{
+	if (m_bakedVertexArray == 0)
+	{
+		glGenVertexArrays(1, &m_bakedVertexArray);
+		glGenBuffers(1, &m_bakedVertexBuffer);
+		glGenBuffers(1, &m_bakedIndexBuffer);
+		glBindVertexArray(m_bakedVertexArray);
+
+		glBindBuffer(GL_ARRAY_BUFFER, m_bakedVertexBuffer);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_bakedIndexBuffer);
+		GLsizei vertexStride = sizeof(MeshCapture::MESH_VERTEX);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, vertexStride, (void*)offsetof(MeshCapture::MESH_VERTEX, position));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, vertexStride, (void*)offsetof(MeshCapture::MESH_VERTEX, normal));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, vertexStride, (void*)offsetof(MeshCapture::MESH_VERTEX, uv));
+	}
+	else
+	{
+		glBindVertexArray(m_bakedVertexArray);
+	}
+
+	if (m_bBakedDirty == true)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_bakedVertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, m_bakedVertices.size() * sizeof(MeshCapture::MESH_VERTEX), m_bakedVertices.data(), GL_STATIC_DRAW);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_bakedIndices.size() * sizeof(GLuint), m_bakedIndices.data(), GL_STATIC_DRAW);
+		m_bBakedDirty = false;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  DrawBakedMesh()
+ *
+ *  This method is used for drawing every object of a baked
+ *  mesh with one glDrawElements call.
+ ***********************************************************/
+void TrackedShapeMeshes::DrawBakedMesh(int bakedMesh)
+{
+	TRACE_ZONE("DrawBakedMesh");
+	if ((bakedMesh < 0) || (bakedMesh >= static_cast<int>(m_bakedMeshes.size())))
+	{
+		return;
+	}
+
+	const BAKED_MESH& baked = m_bakedMeshes[bakedMesh];
+	RenderStats::CountBakedDraw(baked.objectCount);
+	if (baked.indexCount == 0)
+	{
+		return;
+	}
+
+	BindBakedMeshes();
+	glDrawElements(GL_TRIANGLES, baked.indexCount, GL_UNSIGNED_INT,
+		(void*)(static_cast<size_t>(baked.firstIndex) * sizeof(GLuint)));
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DestroyBakedMeshes()
+ *
+ *  This method is used for freeing the baked meshes.
+ ***********************************************************/
+void TrackedShapeMeshes::DestroyBakedMeshes()
+{
+	if (m_bakedVertexArray != 0)
+	{
+		glDeleteVertexArrays(1, &m_bakedVertexArray);
+		glDeleteBuffers(1, &m_bakedVertexBuffer);
+		glDeleteBuffers(1, &m_bakedIndexBuffer);
+		m_bakedVertexArray = 0;
+		m_bakedVertexBuffer = 0;
+		m_bakedIndexBuffer = 0;
+	}
+	m_bakedMeshes.clear();
+	m_bakedVertices.clear();
+	m_bakedIndices.clear();
+	m_bBakedDirty = false;
+}
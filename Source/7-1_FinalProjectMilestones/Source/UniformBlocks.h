@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformblocks.h
+// ============
+// std140 uniform buffers of the camera and the lights, shared by the programs
+//
+//  The camera and the lights are the same for every program that draws the
+//  scene. Instead of uploading them into each program by name, they are
+//  written into two uniform buffers with one buffer write each, and every
+//  program that declares the blocks reads them from fixed binding points.
+//
+//  The camera changes every frame, so where OpenGL supports it the camera
+//  block is written into a persistently mapped ring buffer instead, and the
+//  binding point is moved to the range of the frame.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RingBuffer.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class UniformBlocks
+{
+public:
+	// binding points of the blocks, programs bind their blocks to these
+	static const GLuint CAMERA_BINDING = 0;
+	static const GLuint LIGHT_BINDING = 1;
+	// lights in the light block, the same as in the course fragment shader
+	static const int TOTAL_LIGHTS = 5;
+
+	// one light, laid out as std140 stores the LightSource struct
+	struct LIGHT_SOURCE
+	{
+		glm::vec3 position;
+		float focalStrength;
+		glm::vec3 ambientColor;
+		float specularIntensity;
+		glm::vec3 diffuseColor;
+		float padding0;
+		glm::vec3 specularColor;
+		float padding1;
+	};
+
+	// constructor
+	UniformBlocks();
+	// destructor
+	~UniformBlocks();
+
+	// free the buffers, the next write creates them again
+	void Destroy();
+
+	// start a frame, the ring buffer region of the last frame is fenced
+	void BeginFrame();
+
+	// write the camera block
+	void SetCamera(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPosition);
+	// write the light block
+	void SetLights(const LIGHT_SOURCE* pLights, int lightCount, bool bUseLighting);
+
+	// bind the blocks of a linked program to the binding points, blocks
+	// the program does not declare are skipped
+	static void BindProgramBlocks(GLuint programID);
+
+	// GLSL declarations of the blocks, to paste into shader sources
+	static const char* GetBlockSource();
+
+private:
+	// std140 layout of the camera block
+	struct CAMERA_BLOCK
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::vec4 viewPosition;
+	};
+	// std140 layout of the light block
+	struct LIGHT_BLOCK
+	{
+		LIGHT_SOURCE lightSources[TOTAL_LIGHTS];
+		GLint bUseLighting;
+		GLint padding[3];
+	};
+
+	// create the buffer of a block and bind it to its binding point
+	static GLuint CreateBlockBuffer(GLuint binding, GLsizeiptr size);
+
+	GLuint m_cameraBuffer;
+	GLuint m_lightBuffer;
+	// per-frame camera blocks, and the binding offset alignment they need
+	RingBuffer m_cameraRing;
+	GLint m_uniformAlignment;
+};
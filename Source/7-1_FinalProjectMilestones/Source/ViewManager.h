@@ -1,62 +1,89 @@
-///////////////////////////////////////////////////////////////////////////////
-// viewmanager.h
-// ============
-// manage the viewing of 3D objects within the viewport
-//
-//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
-//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
-///////////////////////////////////////////////////////////////////////////////
-
-#pragma once
-
-#include "ShaderManager.h"
-#include "camera.h"
-
-// GLFW library
-#include "GLFW/glfw3.h" 
-
-class ViewManager
-{
-public:
-	// constructor
-	ViewManager(
-		ShaderManager* pShaderManager);
-	// destructor
-	~ViewManager();
-
-	// mouse position callback for mouse interaction with the 3D scene
-	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
-
-//*******************************************************************************************************************************************************************************
-	// mouse scroll callback for mouse scroll interaction with the 3D scene - makes movements fast/slow
-	static void Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset);
-
-	// Methods for setting projection types
-	void SetPerspective(); // Default Perspective
-	void SetOrthographic(); // Set Orthographic Projection
-	glm::mat4 GetProjectionMatrix() const; // Gets projection matrix
-
-//*******************************************************************************************************************************************************************************
-private:
-	// pointer to shader manager object
-	ShaderManager* m_pShaderManager;
-	// active OpenGL display window
-	GLFWwindow* m_pWindow;
-
-	// process keyboard events for interaction with the 3D scene
-	void ProcessKeyboardEvents();
-
-//*******************************************************************************************************************************************************************************
-	glm::mat4 projection; // Projection matrix
-	float aspectRatio; // window aspect ratio for 3D->2D conversion
-
-//*******************************************************************************************************************************************************************************
-public:
-	// create the initial OpenGL display window
-	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
-	
-	// prepare the conversion from 3D object display to 2D scene display
-	void PrepareSceneView();
-};
-//*******************************************************************************************************************************************************************************
+///////////////////////////////////////////////////////////////////////////////
+// viewmanager.h
+// ============
+// manage the viewing of 3D objects within the viewport
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "TrackedShaderManager.h"
+#include "OffscreenTarget.h"
+#include "camera.h"
+
+// GLFW library
+#include "GLFW/glfw3.h" 
+
+class ViewManager
+{
+public:
+	// constructor
+	ViewManager(
+		TrackedShaderManager* pShaderManager);
+	// destructor
+	~ViewManager();
+
+	// mouse position callback for mouse interaction with the 3D scene
+	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
+
+//*******************************************************************************************************************************************************************************
+	// mouse scroll callback for mouse scroll interaction with the 3D scene - makes movements fast/slow
+	static void Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset);
+
+	// key, resize and refresh callbacks that mark the scene for redrawing
+	static void Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+	static void Framebuffer_Size_Callback(GLFWwindow* window, int width, int height);
+	static void Window_Refresh_Callback(GLFWwindow* window);
+
+	// Methods for setting projection types
+	void SetPerspective(); // Default Perspective
+	void SetOrthographic(); // Set Orthographic Projection
+	glm::mat4 GetProjectionMatrix() const; // Gets projection matrix
+
+//*******************************************************************************************************************************************************************************
+private:
+	// pointer to shader manager object
+	TrackedShaderManager* m_pShaderManager;
+	// active OpenGL display window
+	GLFWwindow* m_pWindow;
+	// framebuffer rendered into when there is no display
+	OffscreenTarget* m_pOffscreenTarget;
+
+	// process keyboard events for interaction with the 3D scene
+	void ProcessKeyboardEvents();
+
+//*******************************************************************************************************************************************************************************
+	glm::mat4 projection; // Projection matrix
+	float aspectRatio; // window aspect ratio for 3D->2D conversion
+
+//*******************************************************************************************************************************************************************************
+public:
+	// create the initial OpenGL display window
+	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+
+	// create a framebuffer the size of the display window and render into it
+	bool CreateOffscreenTarget();
+	// get the framebuffer rendered into, NULL when rendering to the window
+	OffscreenTarget* GetOffscreenTarget() const { return m_pOffscreenTarget; }
+	
+	// prepare the conversion from 3D object display to 2D scene display
+	void PrepareSceneView();
+
+	// place the camera directly, used by scripted camera playback
+	void SetCameraPose(const glm::vec3& position, const glm::vec3& front, float zoom);
+	// true while the orthographic projection is active
+	bool IsOrthographic() const;
+	// advance the frame time by a fixed step in seconds, 0 uses the real clock
+	void SetFixedTimeStep(float timeStep);
+	// turn the keyboard and mouse camera controls on or off
+	void EnableUserInput(bool bEnable);
+
+	// true when the camera, projection or window changed since the last frame
+	bool IsSceneChanged() const;
+	// restart the frame timing after the loop was idle
+	void ResetFrameTime();
+};
+//*******************************************************************************************************************************************************************************
 //*******************************************************************************************************************************************************************************
\ No newline at end of file
@@ -0,0 +1,328 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmark.cpp
+// ============
+// repeatable scene timing along a scripted camera path
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.h"
+#include "RenderStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+	// frames the GPU may be behind before a frame goes untimed
+	const int GPU_TIMER_FRAMES = 4;
+
+	// get the nearest-rank percentile of the sorted values
+	double Percentile(const std::vector<double>& sortedValues, double percent)
+	{
+		int rank = static_cast<int>(std::ceil(percent / 100.0 * sortedValues.size()));
+		rank = std::max(1, std::min(rank, static_cast<int>(sortedValues.size())));
+		return sortedValues[rank - 1];
+	}
+
+	// get the text as the inside of a JSON string, so a script path
+	// with quotes, backslashes or control characters stays valid JSON
+	std::string EscapeJson(const std::string& text)
+	{
+		const char* const HEX_DIGITS = "0123456789abcdef";
+		std::string escaped;
+		escaped.reserve(text.size());
+		for (char character : text)
+		{
+			unsigned char code = static_cast<unsigned char>(character);
+			if ((character == '"') || (character == '\\'))
+			{
+				escaped += '\\';
+				escaped += character;
+			}
+			else if (code < 0x20)
+			{
+				escaped += "\\u00";
+				escaped += HEX_DIGITS[code >> 4];
+				escaped += HEX_DIGITS[code & 0x0F];
+			}
+			else
+			{
+				escaped += character;
+			}
+		}
+		return escaped;
+	}
+}
+
+/***********************************************************
+ *  Benchmark()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Benchmark::Benchmark(ViewManager* pViewManager, SceneManager* pSceneManager)
+{
+	m_pViewManager = pViewManager;
+	m_pSceneManager = pSceneManager;
+	m_cameraScriptName = "built-in";
+	m_timeStep = 1.0f / 60.0f;
+	m_warmupFrames = 10;
+	m_bTimeGroups = false;
+	m_frameIndex = 0;
+}
+
+/***********************************************************
+ *  LoadCameraScript()
+ *
+ *  This method is used for reading the camera path from
+ *  the passed in script file.
+ ***********************************************************/
+bool Benchmark::LoadCameraScript(const char* filename)
+{
+	if (m_cameraScript.Load(filename) == false)
+	{
+		return false;
+	}
+	m_cameraScriptName = filename;
+
+	return true;
+}
+
+/***********************************************************
+ *  GetFrameCount()
+ *
+ *  This method is used for getting the number of frames
+ *  that covers the camera path, plus the warm-up frames.
+ ***********************************************************/
+int Benchmark::GetFrameCount() const
+{
+	int pathFrames = static_cast<int>(std::floor(m_cameraScript.GetDuration() / m_timeStep)) + 1;
+	return m_warmupFrames + pathFrames;
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for handing the camera over to the
+ *  script and creating the frame GPU timer, and the object
+ *  group timers when they were asked for.
+ ***********************************************************/
+bool Benchmark::Start()
+{
+	m_pViewManager->EnableUserInput(false);
+	m_pViewManager->SetFixedTimeStep(m_timeStep);
+
+	m_frameSamples.clear();
+	m_gpuTimings.clear();
+	m_groupTimings.clear();
+
+	return (m_gpuTimer.Create(GPU_TIMER_FRAMES) &&
+		((m_bTimeGroups == false) || m_pSceneManager->EnableGroupTiming(true)));
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for placing the camera at its pose
+ *  for the frame and starting the CPU and GPU timers. The
+ *  warm-up frames replay the first pose.
+ ***********************************************************/
+void Benchmark::BeginFrame(int frameIndex)
+{
+	m_frameIndex = frameIndex;
+
+	int pathFrame = std::max(0, frameIndex - m_warmupFrames);
+	CAMERA_KEYFRAME pose = m_cameraScript.Sample(pathFrame * m_timeStep);
+
+	m_pViewManager->SetCameraPose(pose.position, pose.front, pose.zoom);
+	// only rebuild the projection when the script switches it
+	if ((pose.bOrthographic == true) && (m_pViewManager->IsOrthographic() == false))
+	{
+		m_pViewManager->SetOrthographic();
+	}
+	else if ((pose.bOrthographic == false) && (m_pViewManager->IsOrthographic() == true))
+	{
+		m_pViewManager->SetPerspective();
+	}
+
+	m_gpuTimer.Collect(m_gpuTimings);
+	if (m_bTimeGroups == true)
+	{
+		m_pSceneManager->CollectGroupTimings(m_groupTimings, false);
+	}
+	m_gpuTimer.Begin(frameIndex);
+	m_frameStart = std::chrono::steady_clock::now();
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for stopping the frame timers and
+ *  keeping the measurements of frames past the warm-up.
+ ***********************************************************/
+void Benchmark::EndFrame()
+{
+	std::chrono::duration<double, std::milli> cpuTime =
+		std::chrono::steady_clock::now() - m_frameStart;
+	m_gpuTimer.End();
+
+	if (m_frameIndex < m_warmupFrames)
+	{
+		return;
+	}
+
+	// called after RenderStats::EndFrame(), so the last frame
+	// statistics belong to the frame that was just submitted
+	FRAME_SAMPLE sample;
+	sample.cpuMilliseconds = cpuTime.count();
+	sample.stats = RenderStats::GetLastFrame();
+	m_frameSamples.push_back(sample);
+}
+
+/***********************************************************
+ *  WriteReport()
+ *
+ *  This method is used for writing the frame time and
+ *  render statistics percentiles as JSON. The group times
+ *  are only written when the groups were timed.
+ ***********************************************************/
+bool Benchmark::WriteReport(const char* filename)
+{
+	m_gpuTimer.Drain(m_gpuTimings);
+	if (m_bTimeGroups == true)
+	{
+		m_pSceneManager->CollectGroupTimings(m_groupTimings, true);
+		m_pSceneManager->EnableGroupTiming(false);
+	}
+
+	std::vector<double> cpuTimes;
+	std::vector<double> drawCalls;
+	std::vector<double> drawnInstances;
+	std::vector<double> uniformUploads;
+	std::vector<double> redundantUploads;
+	std::vector<double> textureBinds;
+	std::vector<double> stateSkipRatios;
+	std::vector<double> materialChanges;
+	std::vector<double> textureChanges;
+	for (const FRAME_SAMPLE& sample : m_frameSamples)
+	{
+		cpuTimes.push_back(sample.cpuMilliseconds);
+		drawCalls.push_back(sample.stats.drawCalls);
+		drawnInstances.push_back(sample.stats.drawnInstances);
+		uniformUploads.push_back(sample.stats.uniformUploads);
+		redundantUploads.push_back(sample.stats.redundantUniformUploads);
+		textureBinds.push_back(sample.stats.textureBinds);
+		stateSkipRatios.push_back(RenderStats::GetStateSkipRatio(sample.stats));
+		materialChanges.push_back(sample.stats.materialChanges);
+		textureChanges.push_back(sample.stats.textureChanges);
+	}
+
+	std::vector<double> gpuTimes;
+	for (const GPU_TIMING& timing : m_gpuTimings)
+	{
+		if (timing.frameIndex >= m_warmupFrames)
+		{
+			gpuTimes.push_back(timing.milliseconds);
+		}
+	}
+
+	std::ofstream file;
+	if (filename != NULL)
+	{
+		file.open(filename);
+		if (!file)
+		{
+			std::cout << "Could not write benchmark report:" << filename << std::endl;
+			return false;
+		}
+	}
+	std::ostream& output = (filename != NULL) ? file : std::cout;
+
+	output << std::fixed << std::setprecision(4);
+	output << "{\n";
+	output << "  \"camera_script\": \"" << EscapeJson(m_cameraScriptName) << "\",\n";
+	output << "  \"timestep_s\": " << m_timeStep << ",\n";
+	output << "  \"warmup_frames\": " << m_warmupFrames << ",\n";
+	output << "  \"group_timing\": " << (m_bTimeGroups ? "true" : "false") << ",\n";
+	output << "  \"frames\": " << m_frameSamples.size() << ",\n";
+	output << "  \"gpu_frames\": " << gpuTimes.size() << ",\n";
+	output << "  \"gpu_frames_dropped\": " << m_gpuTimer.GetDroppedFrames() << ",\n";
+	output << "  \"cpu_frame_ms\": ";
+	WriteSummary(output, cpuTimes);
+	output << ",\n  \"gpu_frame_ms\": ";
+	WriteSummary(output, gpuTimes);
+	if (m_bTimeGroups == true)
+	{
+		output << ",\n  \"gpu_group_ms\": {";
+		for (int group = 0; group < SceneManager::GROUP_COUNT; group++)
+		{
+			std::vector<double> groupTimes;
+			for (const GPU_TIMING& timing : m_groupTimings)
+			{
+				if (timing.frameIndex >= m_warmupFrames)
+				{
+					groupTimes.push_back(timing.sectionMilliseconds[group]);
+				}
+			}
+			output << (group == 0 ? "\n" : ",\n") << "    \""
+				<< EscapeJson(SceneManager::GetGroupName(group)) << "\": ";
+			WriteSummary(output, groupTimes);
+		}
+		output << "\n  }";
+	}
+	output << ",\n  \"draw_calls\": ";
+	WriteSummary(output, drawCalls);
+	output << ",\n  \"drawn_instances\": ";
+	WriteSummary(output, drawnInstances);
+	output << ",\n  \"uniform_uploads\": ";
+	WriteSummary(output, uniformUploads);
+	output << ",\n  \"redundant_uniform_uploads\": ";
+	WriteSummary(output, redundantUploads);
+	output << ",\n  \"texture_binds\": ";
+	WriteSummary(output, textureBinds);
+	output << ",\n  \"state_skip_ratio\": ";
+	WriteSummary(output, stateSkipRatios);
+	output << ",\n  \"material_changes\": ";
+	WriteSummary(output, materialChanges);
+	output << ",\n  \"texture_changes\": ";
+	WriteSummary(output, textureChanges);
+	if (m_frameSamples.empty() == false)
+	{
+		output << ",\n  \"last_frame\": ";
+		RenderStats::WriteJSON(output, m_frameSamples.back().stats);
+	}
+	output << "\n}" << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  WriteSummary()
+ *
+ *  This method is used for writing the p50, p95, p99, max
+ *  and mean of the passed in values as a JSON object.
+ ***********************************************************/
+void Benchmark::WriteSummary(std::ostream& output, std::vector<double> values)
+{
+	if (values.empty())
+	{
+		output << "null";
+		return;
+	}
+
+	std::sort(values.begin(), values.end());
+
+	double total = 0.0;
+	for (double value : values)
+	{
+		total += value;
+	}
+
+	output << "{ \"p50\": " << Percentile(values, 50.0)
+		<< ", \"p95\": " << Percentile(values, 95.0)
+		<< ", \"p99\": " << Percentile(values, 99.0)
+		<< ", \"max\": " << values.back()
+		<< ", \"mean\": " << total / values.size() << " }";
+}
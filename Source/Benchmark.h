@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmark.h
+// ============
+// repeatable scene timing along a scripted camera path
+//
+//  The camera follows a CameraScript with a fixed time step and the keyboard
+//  and mouse switched off, so two runs render exactly the same frames. Frame
+//  times and the render statistics are reported as JSON. The GPU time of
+//  each RenderScene object group is only measured on request, as timing
+//  the groups keeps them apart in the draw order and splits the batches,
+//  so the scene is no longer submitted the way it is normally.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "CameraScript.h"
+#include "GpuTimer.h"
+#include "RenderStats.h"
+#include "SceneManager.h"
+#include "ViewManager.h"
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Benchmark
+{
+public:
+	// constructor
+	Benchmark(ViewManager* pViewManager, SceneManager* pSceneManager);
+
+	// read the camera path from a script file, the built-in path is used otherwise
+	bool LoadCameraScript(const char* filename);
+	// set the simulated time between frames in seconds
+	void SetTimeStep(float timeStep) { m_timeStep = timeStep; }
+	// set the number of frames rendered before measuring starts
+	void SetWarmupFrames(int warmupFrames) { m_warmupFrames = warmupFrames; }
+	// also time the object groups, which changes how the scene is submitted
+	void SetGroupTiming(bool bTimeGroups) { m_bTimeGroups = bTimeGroups; }
+	// get the number of frames needed to play the whole camera path
+	int GetFrameCount() const;
+
+	// take over the camera and create the GPU timers
+	bool Start();
+	// pose the camera for the frame and start timing it
+	void BeginFrame(int frameIndex);
+	// stop timing the frame once all of its commands are submitted
+	void EndFrame();
+	// write the JSON report to the passed in file, or stdout when NULL
+	bool WriteReport(const char* filename);
+
+private:
+	struct FRAME_SAMPLE
+	{
+		double cpuMilliseconds;
+		RenderStats::FRAME_STATS stats;
+	};
+
+	// write the percentile summary of the passed in values
+	void WriteSummary(std::ostream& output, std::vector<double> values);
+
+	ViewManager* m_pViewManager;
+	SceneManager* m_pSceneManager;
+	CameraScript m_cameraScript;
+	std::string m_cameraScriptName;
+	GpuTimer m_gpuTimer;
+
+	float m_timeStep;
+	int m_warmupFrames;
+	bool m_bTimeGroups;
+
+	// frame being timed and the time it started
+	int m_frameIndex;
+	std::chrono::steady_clock::time_point m_frameStart;
+
+	// measurements of the frames after the warm-up
+	std::vector<FRAME_SAMPLE> m_frameSamples;
+	std::vector<GPU_TIMING> m_gpuTimings;
+	std::vector<GPU_TIMING> m_groupTimings;
+};
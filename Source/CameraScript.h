@@ -0,0 +1,50 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerascript.h
+// ============
+// scripted camera keyframes for repeatable, input-free scene playback
+//
+//  Script files hold one keyframe per line, '#' starts a comment:
+//
+//    # time  position    front          zoom  projection
+//    0.0     3 12 15     0 -0.5 -2      80    perspective
+//    2.5     -4 8 10     0.5 -0.4 -2    80    orthographic
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+struct CAMERA_KEYFRAME
+{
+	float time;
+	glm::vec3 position;
+	glm::vec3 front;
+	float zoom;
+	bool bOrthographic;
+};
+
+class CameraScript
+{
+public:
+	// constructor
+	CameraScript();
+
+	// read the keyframes from a script file
+	bool Load(const char* filename);
+	// use the built-in path that orbits the default view
+	void LoadDefault();
+
+	// get the camera pose at the passed in time in seconds
+	CAMERA_KEYFRAME Sample(float time) const;
+	// get the time of the last keyframe
+	float GetDuration() const;
+
+	const std::vector<CAMERA_KEYFRAME>& GetKeyframes() const { return m_keyframes; }
+
+private:
+	// keyframes sorted by time
+	std::vector<CAMERA_KEYFRAME> m_keyframes;
+};
@@ -0,0 +1,405 @@
+///////////////////////////////////////////////////////////////////////////////
+// goldentest.cpp
+// ============
+// check renderer changes against a reference image and performance baseline
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GoldenTest.h"
+#include "PngWriter.h"
+#include "RenderStats.h"
+#include "StateCache.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declaration of global variables and helper functions
+namespace
+{
+	// frames rendered before measuring, and frames measured
+	const int WARMUP_FRAMES = 10;
+	const int MEASURED_FRAMES = 60;
+	// render written for inspection when the image check fails
+	const char* g_ActualImageName = "golden_actual.png";
+
+	// convert an 8-bit sRGB color to CIE L*a*b* (D65 white)
+	void ToLab(const unsigned char* rgb, float lab[3])
+	{
+		static float linear[256];
+		static bool bLinearReady = false;
+		if (bLinearReady == false)
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				float c = i / 255.0f;
+				linear[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			bLinearReady = true;
+		}
+
+		float r = linear[rgb[0]];
+		float g = linear[rgb[1]];
+		float b = linear[rgb[2]];
+		float xyz[3] = {
+			(0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f,
+			(0.2126f * r + 0.7152f * g + 0.0722f * b),
+			(0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f };
+		for (float& t : xyz)
+		{
+			t = (t > 0.008856f) ? std::cbrt(t) : (7.787f * t + 16.0f / 116.0f);
+		}
+
+		lab[0] = 116.0f * xyz[1] - 16.0f;
+		lab[1] = 500.0f * (xyz[0] - xyz[1]);
+		lab[2] = 200.0f * (xyz[1] - xyz[2]);
+	}
+
+	// get the baseline file that sits next to the reference image
+	std::string GetBaselineFile(const std::string& referenceFile)
+	{
+		std::string baseName = referenceFile;
+		size_t extension = baseName.rfind('.');
+		if ((extension != std::string::npos) && (baseName.find_first_of("/\\", extension) == std::string::npos))
+		{
+			baseName.erase(extension);
+		}
+		return baseName + "_perf.json";
+	}
+}
+
+/***********************************************************
+ *  GoldenTest()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GoldenTest::GoldenTest(ViewManager* pViewManager, SceneManager* pSceneManager)
+{
+	m_pViewManager = pViewManager;
+	m_pSceneManager = pSceneManager;
+	m_pSoftwareRasterizer = NULL;
+
+	m_tolerance.maxMeanDeltaE = 1.0f;
+	m_tolerance.pixelDeltaE = 10.0f;
+	m_tolerance.maxChangedPixels = 0.005f;
+	m_tolerance.maxSlowdown = 1.25f;
+
+	m_width = 0;
+	m_height = 0;
+	m_performance = GOLDEN_PERFORMANCE();
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for rendering the default view and
+ *  either checking it against the reference image and the
+ *  performance baseline, or storing it as the new ones.
+ ***********************************************************/
+bool GoldenTest::Run(const std::string& referenceFile, bool bUpdate)
+{
+	if (m_pViewManager->GetOffscreenTarget() == NULL)
+	{
+		std::cout << "The golden image test needs an offscreen render target" << std::endl;
+		return false;
+	}
+
+	RenderFrames();
+
+	std::string baselineFile = GetBaselineFile(referenceFile);
+	std::cout << "GOLDEN: frame " << m_performance.frameMilliseconds << " ms, "
+		<< m_performance.drawCalls << " draw calls, "
+		<< m_performance.uniformUploads << " uniform uploads" << std::endl;
+
+	if (bUpdate == true)
+	{
+		if ((PngWriter::Write(referenceFile.c_str(), m_width, m_height, 3, m_image.data()) == false) ||
+			(SaveBaseline(baselineFile) == false))
+		{
+			std::cout << "GOLDEN: could not write " << referenceFile << " or " << baselineFile << std::endl;
+			return false;
+		}
+		std::cout << "GOLDEN: updated " << referenceFile << " and " << baselineFile << std::endl;
+		return true;
+	}
+
+	bool bImagePassed = CompareImage(referenceFile);
+	bool bPerformancePassed = ComparePerformance(baselineFile);
+	if (bImagePassed == false)
+	{
+		PngWriter::Write(g_ActualImageName, m_width, m_height, 3, m_image.data());
+		std::cout << "GOLDEN: wrote the render to " << g_ActualImageName << std::endl;
+	}
+
+	bool bPassed = bImagePassed && bPerformancePassed;
+	std::cout << "GOLDEN: " << (bPassed ? "PASS" : "FAIL") << std::endl;
+
+	return bPassed;
+}
+
+/***********************************************************
+ *  RenderFrames()
+ *
+ *  This method is used for rendering the scene from the
+ *  default camera and measuring the median frame time,
+ *  including the wait for the GPU, and the render stats.
+ ***********************************************************/
+void GoldenTest::RenderFrames()
+{
+	OffscreenTarget* pTarget = m_pViewManager->GetOffscreenTarget();
+	m_width = pTarget->GetWidth();
+	m_height = pTarget->GetHeight();
+	if (m_pSoftwareRasterizer != NULL)
+	{
+		m_width = m_pSoftwareRasterizer->GetWidth();
+		m_height = m_pSoftwareRasterizer->GetHeight();
+	}
+
+	m_pViewManager->EnableUserInput(false);
+	m_pViewManager->SetFixedTimeStep(1.0f / 60.0f);
+
+	std::vector<double> frameTimes;
+	for (int frame = 0; frame < WARMUP_FRAMES + MEASURED_FRAMES; frame++)
+	{
+		std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+		RenderStats::BeginFrame();
+
+		if (m_pSoftwareRasterizer == NULL)
+		{
+			StateCache::Enable(GL_DEPTH_TEST);
+			StateCache::ClearColor(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		}
+		m_pViewManager->PrepareSceneView();
+		m_pSceneManager->RenderScene();
+		if (m_pSoftwareRasterizer != NULL)
+		{
+			m_pSoftwareRasterizer->Render();
+		}
+		else
+		{
+			glFinish();
+		}
+
+		RenderStats::EndFrame();
+		std::chrono::duration<double, std::milli> frameTime = std::chrono::steady_clock::now() - frameStart;
+		if (frame >= WARMUP_FRAMES)
+		{
+			frameTimes.push_back(frameTime.count());
+		}
+	}
+
+	std::sort(frameTimes.begin(), frameTimes.end());
+	m_performance.frameMilliseconds = frameTimes[frameTimes.size() / 2];
+	m_performance.drawCalls = RenderStats::GetLastFrame().drawCalls;
+	m_performance.uniformUploads = RenderStats::GetLastFrame().uniformUploads;
+
+	// read the last frame and store it top row first
+	std::vector<unsigned char> pixels(static_cast<size_t>(m_width) * m_height * 4);
+	if (m_pSoftwareRasterizer != NULL)
+	{
+		std::copy(m_pSoftwareRasterizer->GetPixels(), m_pSoftwareRasterizer->GetPixels() + pixels.size(), pixels.begin());
+	}
+	else
+	{
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	}
+
+	m_image.resize(static_cast<size_t>(m_width) * m_height * 3);
+	for (int y = 0; y < m_height; y++)
+	{
+		const unsigned char* source = &pixels[static_cast<size_t>(m_height - 1 - y) * m_width * 4];
+		unsigned char* destination = &m_image[static_cast<size_t>(y) * m_width * 3];
+		for (int x = 0; x < m_width; x++)
+		{
+			destination[x * 3 + 0] = source[x * 4 + 0];
+			destination[x * 3 + 1] = source[x * 4 + 1];
+			destination[x * 3 + 2] = source[x * 4 + 2];
+		}
+	}
+}
+
+/***********************************************************
+ *  CompareImage()
+ *
+ *  This method is used for comparing the render with the
+ *  reference image in L*a*b* color space, so the tolerance
+ *  follows what the eye notices rather than raw RGB values.
+ ***********************************************************/
+bool GoldenTest::CompareImage(const std::string& referenceFile)
+{
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+
+	// the flag is process wide and the texture loader threads decode with
+	// it set, so it keeps that value and the rows are flipped back here
+	stbi_set_flip_vertically_on_load(true);
+	unsigned char* reference = stbi_load(referenceFile.c_str(), &width, &height, &colorChannels, 3);
+
+	if (reference == NULL)
+	{
+		std::cout << "GOLDEN: could not load reference image " << referenceFile << std::endl;
+		return false;
+	}
+	// the reference is compared top row first
+	size_t rowBytes = static_cast<size_t>(width) * 3;
+	for (int row = 0; row < height / 2; row++)
+	{
+		std::swap_ranges(reference + row * rowBytes, reference + (row + 1) * rowBytes,
+			reference + (height - 1 - row) * rowBytes);
+	}
+	if ((width != m_width) || (height != m_height))
+	{
+		std::cout << "GOLDEN: reference image is " << width << "x" << height << " but the render is "
+			<< m_width << "x" << m_height << ", seed it with --golden-update" << std::endl;
+		stbi_image_free(reference);
+		return false;
+	}
+
+	double totalDeltaE = 0.0;
+	size_t changedPixels = 0;
+	size_t pixelCount = static_cast<size_t>(width) * height;
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		float renderLab[3];
+		float referenceLab[3];
+		ToLab(&m_image[i * 3], renderLab);
+		ToLab(&reference[i * 3], referenceLab);
+
+		float deltaE = std::sqrt(
+			(renderLab[0] - referenceLab[0]) * (renderLab[0] - referenceLab[0]) +
+			(renderLab[1] - referenceLab[1]) * (renderLab[1] - referenceLab[1]) +
+			(renderLab[2] - referenceLab[2]) * (renderLab[2] - referenceLab[2]));
+		totalDeltaE += deltaE;
+		if (deltaE > m_tolerance.pixelDeltaE)
+		{
+			changedPixels++;
+		}
+	}
+	stbi_image_free(reference);
+
+	double meanDeltaE = totalDeltaE / pixelCount;
+	double changedShare = static_cast<double>(changedPixels) / pixelCount;
+	bool bPassed = (meanDeltaE <= m_tolerance.maxMeanDeltaE) && (changedShare <= m_tolerance.maxChangedPixels);
+
+	std::cout << "GOLDEN: image mean dE " << meanDeltaE << " (limit " << m_tolerance.maxMeanDeltaE << "), "
+		<< changedShare * 100.0 << "% pixels over dE " << m_tolerance.pixelDeltaE
+		<< " (limit " << m_tolerance.maxChangedPixels * 100.0 << "%) "
+		<< (bPassed ? "ok" : "FAILED") << std::endl;
+
+	return bPassed;
+}
+
+/***********************************************************
+ *  ComparePerformance()
+ *
+ *  This method is used for failing when the frame time
+ *  grew past the allowed slowdown, or when the frame sends
+ *  more draw calls or uniform uploads than the baseline.
+ ***********************************************************/
+bool GoldenTest::ComparePerformance(const std::string& baselineFile)
+{
+	GOLDEN_PERFORMANCE baseline;
+	if (LoadBaseline(baselineFile, baseline) == false)
+	{
+		std::cout << "GOLDEN: no performance baseline in " << baselineFile
+			<< ", seed it with --golden-update" << std::endl;
+		return false;
+	}
+
+	double frameLimit = baseline.frameMilliseconds * m_tolerance.maxSlowdown;
+	bool bFrameTime = (m_performance.frameMilliseconds <= frameLimit);
+	bool bDrawCalls = (m_performance.drawCalls <= baseline.drawCalls);
+	bool bUploads = (m_performance.uniformUploads <= baseline.uniformUploads);
+
+	std::cout << "GOLDEN: frame " << m_performance.frameMilliseconds << " ms (limit " << frameLimit << ") "
+		<< (bFrameTime ? "ok" : "FAILED") << std::endl;
+	std::cout << "GOLDEN: draw calls " << m_performance.drawCalls << " (baseline " << baseline.drawCalls << ") "
+		<< (bDrawCalls ? "ok" : "FAILED") << std::endl;
+	std::cout << "GOLDEN: uniform uploads " << m_performance.uniformUploads
+		<< " (baseline " << baseline.uniformUploads << ") " << (bUploads ? "ok" : "FAILED") << std::endl;
+
+	return bFrameTime && bDrawCalls && bUploads;
+}
+
+/***********************************************************
+ *  LoadBaseline()
+ *
+ *  This method is used for reading the baseline values
+ *  written by SaveBaseline().
+ ***********************************************************/
+bool GoldenTest::LoadBaseline(const std::string& baselineFile, GOLDEN_PERFORMANCE& baseline)
+{
+	std::ifstream file(baselineFile);
+	if (!file)
+	{
+		return false;
+	}
+	std::stringstream contents;
+	contents << file.rdbuf();
+	std::string text = contents.str();
+
+	// read the number that follows "key": in the flat JSON object
+	auto readValue = [&text](const char* key, double& value) {
+		size_t position = text.find(std::string("\"") + key + "\"");
+		if (position == std::string::npos)
+		{
+			return false;
+		}
+		position = text.find(':', position);
+		if (position == std::string::npos)
+		{
+			return false;
+		}
+		value = std::strtod(text.c_str() + position + 1, NULL);
+		return true;
+	};
+
+	double frameMilliseconds = 0.0;
+	double drawCalls = 0.0;
+	double uniformUploads = 0.0;
+	if ((readValue("frame_ms", frameMilliseconds) == false) ||
+		(readValue("draw_calls", drawCalls) == false) ||
+		(readValue("uniform_uploads", uniformUploads) == false))
+	{
+		return false;
+	}
+
+	baseline.frameMilliseconds = frameMilliseconds;
+	baseline.drawCalls = static_cast<int>(drawCalls);
+	baseline.uniformUploads = static_cast<int>(uniformUploads);
+
+	return true;
+}
+
+/***********************************************************
+ *  SaveBaseline()
+ *
+ *  This method is used for writing the measurements of
+ *  this run as the new baseline.
+ ***********************************************************/
+bool GoldenTest::SaveBaseline(const std::string& baselineFile)
+{
+	std::ofstream file(baselineFile);
+	if (!file)
+	{
+		return false;
+	}
+
+	file << "{\n"
+		<< "  \"width\": " << m_width << ",\n"
+		<< "  \"height\": " << m_height << ",\n"
+		<< "  \"frame_ms\": " << m_performance.frameMilliseconds << ",\n"
+		<< "  \"draw_calls\": " << m_performance.drawCalls << ",\n"
+		<< "  \"uniform_uploads\": " << m_performance.uniformUploads << "\n"
+		<< "}" << std::endl;
+
+	return true;
+}
@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+// gputimer.h
+// ============
+// measure GPU frame time with timestamp queries that never stall the CPU
+//
+//  Each frame takes one slot of a small query ring. A slot is only read back
+//  once OpenGL reports its result as available, which is normally a few
+//  frames later, so the frame loop never waits on the GPU.
+//
+//  A frame can be split into consecutive sections with NextSection(). Every
+//  section boundary is a single GL_TIMESTAMP, so sections cost one query
+//  each and, unlike GL_TIME_ELAPSED, never conflict with an outer timer.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+struct GPU_TIMING
+{
+	// frame number passed to Begin()
+	int frameIndex;
+	// GPU time between Begin() and End()
+	double milliseconds;
+	// GPU time of each section, in section order
+	std::vector<double> sectionMilliseconds;
+};
+
+class GpuTimer
+{
+public:
+	// constructor
+	GpuTimer();
+	// destructor
+	~GpuTimer();
+
+	// create the query objects for the passed in number of frames in flight
+	bool Create(int ringSize, int sectionCount = 1);
+	// free the query objects
+	void Destroy();
+	// true between Create() and Destroy()
+	bool IsCreated() const { return m_slots.empty() == false; }
+
+	// mark the start and end of the GPU work of a frame, Begin() starts section 0
+	void Begin(int frameIndex);
+	void End();
+	// end the current section and start the passed in one, skipped sections time 0
+	void NextSection(int section);
+
+	// add the timings of finished frames to the list, without waiting
+	void Collect(std::vector<GPU_TIMING>& timings);
+	// wait for every frame still in flight and add its timing to the list
+	void Drain(std::vector<GPU_TIMING>& timings);
+
+	// number of frames not timed because the ring was full
+	int GetDroppedFrames() const { return m_droppedFrames; }
+
+private:
+	struct QUERY_SLOT
+	{
+		// one timestamp per section start plus one for the end of the frame
+		std::vector<GLuint> queries;
+		int frameIndex;
+		bool bPending;
+	};
+
+	// read back a finished slot and make it free again
+	void ReadSlot(QUERY_SLOT& slot, std::vector<GPU_TIMING>& timings);
+
+	std::vector<QUERY_SLOT> m_slots;
+	int m_sectionCount;
+	// slot used by the next Begin(), slots are reused in order
+	int m_nextSlot;
+	// slot between Begin() and End(), -1 when not timing
+	int m_activeSlot;
+	// timestamps written into the active slot so far
+	int m_writtenQueries;
+	int m_droppedFrames;
+};
@@ -0,0 +1,40 @@
+///////////////////////////////////////////////////////////////////////////////
+// offscreentarget.h
+// ============
+// render the 3D scene into a framebuffer object instead of a display window
+//
+//  Used by the headless run modes, where the OpenGL context has no default
+//  framebuffer (EGL surfaceless or OSMesa on machines without a display).
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+class OffscreenTarget
+{
+public:
+	// constructor
+	OffscreenTarget();
+	// destructor
+	~OffscreenTarget();
+
+	// create the color and depth attachments at the passed in size
+	bool Create(int width, int height);
+	// free the framebuffer and its attachments
+	void Destroy();
+	// make the framebuffer the current render target
+	void Bind();
+
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+
+private:
+	// OpenGL framebuffer object and its attachments
+	GLuint m_framebufferID;
+	GLuint m_colorBufferID;
+	GLuint m_depthBufferID;
+	// size of the attachments in pixels
+	int m_width;
+	int m_height;
+};
@@ -0,0 +1,258 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderstats.cpp
+// ============
+// per-frame counters for the work the scene sends to OpenGL
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderStats.h"
+
+// declaration of global variables
+namespace
+{
+	// counters of the frame being rendered
+	RenderStats::FRAME_STATS g_CurrentFrame = {};
+	// counters of the last completed frame
+	RenderStats::FRAME_STATS g_LastFrame = {};
+
+	// display names of the mesh types
+	const char* g_MeshTypeNames[RenderStats::MESH_TYPE_COUNT] = {
+		"box", "cone", "cylinder", "plane", "prism",
+		"pyramid4", "sphere", "tapered_cylinder", "torus" };
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This function is used for clearing the counters before
+ *  the next frame is rendered.
+ ***********************************************************/
+void RenderStats::BeginFrame()
+{
+	g_CurrentFrame = FRAME_STATS();
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This function is used for keeping the counters of the
+ *  frame that was just rendered.
+ ***********************************************************/
+void RenderStats::EndFrame()
+{
+	g_LastFrame = g_CurrentFrame;
+}
+
+/***********************************************************
+ *  GetLastFrame()
+ *
+ *  This function is used for getting the counters of the
+ *  last completed frame.
+ ***********************************************************/
+const RenderStats::FRAME_STATS& RenderStats::GetLastFrame()
+{
+	return(g_LastFrame);
+}
+
+/***********************************************************
+ *  WriteJSON()
+ *
+ *  This function is used for writing the passed in counters
+ *  as a single line JSON object.
+ ***********************************************************/
+void RenderStats::WriteJSON(std::ostream& output, const FRAME_STATS& stats)
+{
+	output << "{ \"draw_calls\": " << stats.drawCalls
+		<< ", \"drawn_instances\": " << stats.drawnInstances
+		<< ", \"multi_draw_commands\": " << stats.multiDrawCommands
+		<< ", \"baked_objects\": " << stats.bakedObjects
+		<< ", \"uniform_uploads\": " << stats.uniformUploads
+		<< ", \"redundant_uniform_uploads\": " << stats.redundantUniformUploads
+		<< ", \"uniform_block_writes\": " << stats.uniformBlockWrites
+		<< ", \"ring_buffer_waits\": " << stats.ringBufferWaits
+		<< ", \"active_texture_changes\": " << stats.activeTextureChanges
+		<< ", \"texture_binds\": " << stats.textureBinds
+		<< ", \"state_changes\": " << stats.stateChanges
+		<< ", \"skipped_state_changes\": " << stats.skippedStateChanges
+		<< ", \"state_skip_ratio\": " << GetStateSkipRatio(stats)
+		<< ", \"material_changes\": " << stats.materialChanges
+		<< ", \"texture_changes\": " << stats.textureChanges
+		<< ", \"mesh_draws\": {";
+	for (int meshType = 0; meshType < MESH_TYPE_COUNT; meshType++)
+	{
+		output << (meshType == 0 ? " \"" : ", \"") << g_MeshTypeNames[meshType]
+			<< "\": " << stats.meshDraws[meshType];
+	}
+	output << " } }";
+}
+
+/***********************************************************
+ *  GetStateSkipRatio()
+ *
+ *  This function is used for getting the share of the state
+ *  changes the state cache dropped, 0 when there were none.
+ ***********************************************************/
+double RenderStats::GetStateSkipRatio(const FRAME_STATS& stats)
+{
+	if (stats.stateChanges == 0)
+	{
+		return 0.0;
+	}
+	return static_cast<double>(stats.skippedStateChanges) / stats.stateChanges;
+}
+
+/***********************************************************
+ *  GetMeshTypeName()
+ *
+ *  This function is used for getting the display name of
+ *  the passed in mesh type.
+ ***********************************************************/
+const char* RenderStats::GetMeshTypeName(int meshType)
+{
+	if ((meshType < 0) || (meshType >= MESH_TYPE_COUNT))
+	{
+		return "";
+	}
+	return g_MeshTypeNames[meshType];
+}
+
+/***********************************************************
+ *  CountDrawCall()
+ *
+ *  This function is used for counting one mesh draw.
+ ***********************************************************/
+void RenderStats::CountDrawCall(MESH_TYPE meshType)
+{
+	g_CurrentFrame.drawCalls++;
+	g_CurrentFrame.meshDraws[meshType]++;
+}
+
+/***********************************************************
+ *  CountInstances()
+ *
+ *  This function is used for counting the objects one
+ *  instanced draw call drew.
+ ***********************************************************/
+void RenderStats::CountInstances(int instanceCount)
+{
+	g_CurrentFrame.drawnInstances += instanceCount;
+}
+
+/***********************************************************
+ *  CountMultiDraw()
+ *
+ *  This function is used for counting one multi-draw call
+ *  and the draw commands it ran.
+ ***********************************************************/
+void RenderStats::CountMultiDraw(int commandCount)
+{
+	g_CurrentFrame.drawCalls++;
+	g_CurrentFrame.multiDrawCommands += commandCount;
+}
+
+/***********************************************************
+ *  CountBakedDraw()
+ *
+ *  This function is used for counting one draw of a baked
+ *  mesh and the objects merged into it.
+ ***********************************************************/
+void RenderStats::CountBakedDraw(int objectCount)
+{
+	g_CurrentFrame.drawCalls++;
+	g_CurrentFrame.bakedObjects += objectCount;
+}
+
+/***********************************************************
+ *  CountUniformUpload()
+ *
+ *  This function is used for counting one uniform upload
+ *  and whether it repeated the value already set.
+ ***********************************************************/
+void RenderStats::CountUniformUpload(bool bRedundant)
+{
+	g_CurrentFrame.uniformUploads++;
+	if (bRedundant == true)
+	{
+		g_CurrentFrame.redundantUniformUploads++;
+	}
+}
+
+/***********************************************************
+ *  CountUniformBlockWrite()
+ *
+ *  This function is used for counting one write of a
+ *  uniform block buffer.
+ ***********************************************************/
+void RenderStats::CountUniformBlockWrite()
+{
+	g_CurrentFrame.uniformBlockWrites++;
+}
+
+/***********************************************************
+ *  CountRingBufferWait()
+ *
+ *  This function is used for counting one wait for the GPU
+ *  to finish reading a ring buffer region.
+ ***********************************************************/
+void RenderStats::CountRingBufferWait()
+{
+	g_CurrentFrame.ringBufferWaits++;
+}
+
+/***********************************************************
+ *  CountActiveTexture()
+ *
+ *  This function is used for counting one texture unit
+ *  switch.
+ ***********************************************************/
+void RenderStats::CountActiveTexture()
+{
+	g_CurrentFrame.activeTextureChanges++;
+}
+
+/***********************************************************
+ *  CountTextureBind()
+ *
+ *  This function is used for counting one texture bind.
+ ***********************************************************/
+void RenderStats::CountTextureBind()
+{
+	g_CurrentFrame.textureBinds++;
+}
+
+/***********************************************************
+ *  CountStateChange()
+ *
+ *  This function is used for counting one state change
+ *  asked of the state cache and whether it was dropped.
+ ***********************************************************/
+void RenderStats::CountStateChange(bool bSkipped)
+{
+	g_CurrentFrame.stateChanges++;
+	if (bSkipped == true)
+	{
+		g_CurrentFrame.skippedStateChanges++;
+	}
+}
+
+/***********************************************************
+ *  CountMaterialChange()
+ *
+ *  This function is used for counting one switch to a
+ *  different material between two draws.
+ ***********************************************************/
+void RenderStats::CountMaterialChange()
+{
+	g_CurrentFrame.materialChanges++;
+}
+
+/***********************************************************
+ *  CountTextureChange()
+ *
+ *  This function is used for counting one switch to a
+ *  different texture, or between texture and flat color,
+ *  between two draws.
+ ***********************************************************/
+void RenderStats::CountTextureChange()
+{
+	g_CurrentFrame.textureChanges++;
+}
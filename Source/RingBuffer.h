@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+// ringbuffer.h
+// ============
+// persistently mapped buffer for data the renderer writes every frame
+//
+//  The buffer is split into one region per frame in flight. It is created
+//  with glBufferStorage and stays mapped, so a frame's data is written with
+//  a plain memcpy instead of a glBufferSubData call. Every region is fenced
+//  when its frame ends and is only written again once the GPU has passed
+//  that fence, so the CPU can fill frame N+1 while the GPU reads frame N.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+class RingBuffer
+{
+public:
+	// constructor
+	RingBuffer();
+	// destructor
+	~RingBuffer();
+
+	// true when OpenGL can create persistently mapped buffers
+	static bool IsSupported();
+
+	// create and map the buffer, frameBytes for each of frameCount frames
+	bool Create(GLsizeiptr frameBytes, int frameCount = 3);
+	// unmap and free the buffer, waiting for the frames still in flight
+	void Destroy();
+	// true between Create() and Destroy()
+	bool IsCreated() const { return m_bufferID != 0; }
+	// get the OpenGL buffer, for binding the allocated ranges
+	GLuint GetBuffer() const { return m_bufferID; }
+
+	// fence the region of the frame that ended and move to the next one,
+	// waiting while the GPU still reads it
+	void BeginFrame();
+	// reserve size bytes in the region of this frame, offset receives
+	// their position in the buffer, NULL when the region is full
+	void* Allocate(GLsizeiptr size, GLsizeiptr alignment, GLintptr& offset);
+
+private:
+	GLuint m_bufferID;
+	unsigned char* m_pMapped;
+	GLsizeiptr m_frameBytes;
+	// region being written, and the bytes of it already allocated
+	int m_frame;
+	GLsizeiptr m_frameUsed;
+	// fence of every region, 0 when nothing was written since its last wait
+	std::vector<GLsync> m_fences;
+};
@@ -8,6 +8,9 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "Trace.h"
+#include "RenderStats.h"
+#include "StateCache.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -16,14 +19,56 @@
 
 #include <glm/gtx/transform.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <tuple>
+
 // declaration of global variables
 namespace
 {
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
-	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
-	const char* g_UseLightingName = "bUseLighting";
+	// uniform names, hashed by the compiler
+	constexpr UNIFORM_NAME g_ModelName("model");
+	constexpr UNIFORM_NAME g_ColorValueName("objectColor");
+	constexpr UNIFORM_NAME g_TextureValueName("objectTexture");
+	constexpr UNIFORM_NAME g_UseTextureName("bUseTexture");
+	constexpr UNIFORM_NAME g_UseLightingName("bUseLighting");
+	constexpr UNIFORM_NAME g_UVScaleName("UVscale");
+	constexpr UNIFORM_NAME g_AmbientColorName("material.ambientColor");
+	constexpr UNIFORM_NAME g_AmbientStrengthName("material.ambientStrength");
+	constexpr UNIFORM_NAME g_DiffuseColorName("material.diffuseColor");
+	constexpr UNIFORM_NAME g_SpecularColorName("material.specularColor");
+	constexpr UNIFORM_NAME g_ShininessName("material.shininess");
+
+	// texture units the course program and the software rasterizer sample,
+	// one per texture slot
+	const int COURSE_TEXTURE_UNITS = 16;
+	// texture image bytes RenderScene uploads per frame while textures load
+	const size_t TEXTURE_UPLOAD_BUDGET = 8 << 20;
+
+	// frames a group timing may be behind before a frame goes untimed
+	const int GROUP_TIMER_FRAMES = 4;
+	// display names of the RenderScene object groups
+	const char* g_GroupNames[SceneManager::GROUP_COUNT] = {
+		"floor", "vase", "jug", "trash_can", "weights", "console", "light_cubes" };
+
+	// distance between the props of the stress scene grid
+	const float STRESS_SPACING = 8.0f;
+	// seed of the random stress scene layout, so runs can be compared
+	const unsigned int STRESS_SEED = 330;
+	// floor point under each prop of the scene, indexed from GROUP_VASE
+	const glm::vec3 g_PropAnchors[] = {
+		glm::vec3(0.0f, 0.0f, -8.4f),    // vase
+		glm::vec3(-5.0f, 0.0f, -12.4f),  // jug
+		glm::vec3(4.0f, 0.0f, -12.4f),   // trash can
+		glm::vec3(6.0f, 0.0f, -6.4f),    // weights
+		glm::vec3(10.0f, 0.0f, -12.4f) }; // console
+	const int PROP_COUNT = sizeof(g_PropAnchors) / sizeof(g_PropAnchors[0]);
+	// center of the floor plane the layout is spread around
+	const glm::vec3 g_FloorCenter = glm::vec3(2.5f, 0.0f, -12.0f);
 }
 
 /***********************************************************
@@ -31,10 +76,22 @@ namespace
  *
  *  The constructor for the class
  ***********************************************************/
-SceneManager::SceneManager(ShaderManager *pShaderManager)
+SceneManager::SceneManager(TrackedShaderManager *pShaderManager)
 {
 	m_pShaderManager = pShaderManager;
-	m_basicMeshes = new ShapeMeshes();
+	m_basicMeshes = new TrackedShapeMeshes();
+	m_lastGroupTiming.frameIndex = -1;
+	m_lastGroupTiming.milliseconds = 0.0;
+	m_renderedFrames = 0;
+	m_instanceTransform = glm::mat4(1.0f);
+	m_stressFloorTransform = glm::mat4(1.0f);
+	m_materialShift = 0;
+	m_uploadedUVScale = glm::vec2(1.0f, 1.0f);
+	m_bSortDraws = true;
+	m_submitMode = SUBMIT_DRAWS;
+	m_objectTableBuffer = 0;
+	m_bObjectTableDirty = true;
+	m_bAllowBindless = true;
 }
 
 /***********************************************************
@@ -45,97 +102,181 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
 SceneManager::~SceneManager()
 {
 	m_pShaderManager = NULL;
+	DestroyGLTextures();
+	if (m_objectTableBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_objectTableBuffer);
+		m_objectTableBuffer = 0;
+	}
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
 }
 
 /***********************************************************
- *  CreateGLTexture()
+ *  EnableGroupTiming()
  *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
+ *  This method is used for starting or stopping the GPU
+ *  timing of the RenderScene object groups. The timings are
+ *  read back a few frames late, so they never stall. While
+ *  timing, the draws and batches are kept apart by group,
+ *  so the submission differs from an untimed frame.
  ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
+bool SceneManager::EnableGroupTiming(bool bEnable)
 {
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
-
-	// if the image was successfully read from the image file
-	if (image)
+	m_groupTimings.clear();
+	if (bEnable == false)
 	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+		m_groupTimer.Destroy();
+		SortDrawList();
+		return true;
+	}
+
+	// the sort keeps the draws of each group together while timing
+	bool bReturn = m_groupTimer.Create(GROUP_TIMER_FRAMES, GROUP_COUNT);
+	SortDrawList();
+	return bReturn;
+}
+
+/***********************************************************
+ *  CollectGroupTimings()
+ *
+ *  This method is used for moving the finished per-group
+ *  timings into the passed in list.
+ ***********************************************************/
+void SceneManager::CollectGroupTimings(std::vector<GPU_TIMING>& timings, bool bWait)
+{
+	m_groupTimer.Collect(m_groupTimings);
+	if (bWait == true)
+	{
+		m_groupTimer.Drain(m_groupTimings);
+	}
+
+	timings.insert(timings.end(), m_groupTimings.begin(), m_groupTimings.end());
+	m_groupTimings.clear();
+}
+
+/***********************************************************
+ *  GetGroupName()
+ *
+ *  This method is used for getting the display name of
+ *  the passed in object group.
+ ***********************************************************/
+const char* SceneManager::GetGroupName(int group)
+{
+	if ((group < 0) || (group >= GROUP_COUNT))
+	{
+		return "";
+	}
+	return g_GroupNames[group];
+}
+
+/***********************************************************
+ *  SetStressScene()
+ *
+ *  This method is used for replacing the scene with the
+ *  passed in number of prop copies, placed on a grid or at
+ *  random. Every copy gets its own position, turn, size and
+ *  material set, so the per-object work of RenderScene can
+ *  be measured at large object counts. 0 copies goes back
+ *  to the normal scene.
+ ***********************************************************/
+void SceneManager::SetStressScene(int copies, bool bRandomLayout)
+{
+	m_stressCopies.clear();
+	if (copies <= 0)
+	{
+		BuildDrawList();
+		return;
+	}
+
+	// the layout is a square of cells around the floor center
+	int gridSize = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(copies))));
+	float halfExtent = gridSize * STRESS_SPACING * 0.5f;
+	std::mt19937 random(STRESS_SEED);
+	std::uniform_real_distribution<float> position(-halfExtent, halfExtent);
+	std::uniform_real_distribution<float> turn(0.0f, 360.0f);
+	std::uniform_real_distribution<float> size(0.6f, 1.4f);
+
+	m_stressCopies.resize(copies);
+	for (int i = 0; i < copies; i++)
+	{
+		STRESS_COPY& copy = m_stressCopies[i];
+		glm::vec3 location;
+		float degrees = 0.0f;
+		float scale = 1.0f;
+
+		if (bRandomLayout == true)
+		{
+			copy.prop = GROUP_VASE + static_cast<int>(random() % PROP_COUNT);
+			location = g_FloorCenter + glm::vec3(position(random), 0.0f, position(random));
+			degrees = turn(random);
+			scale = size(random);
+		}
 		else
 		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
+			copy.prop = GROUP_VASE + (i % PROP_COUNT);
+			location = g_FloorCenter + glm::vec3(
+				((i % gridSize) + 0.5f) * STRESS_SPACING - halfExtent,
+				0.0f,
+				((i / gridSize) + 0.5f) * STRESS_SPACING - halfExtent);
+			degrees = 90.0f * ((i / PROP_COUNT) % 4);
 		}
 
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
+		// move the prop from its place in the scene to the copy location
+		copy.transform = glm::translate(location) *
+			glm::rotate(glm::radians(degrees), glm::vec3(0.0f, 1.0f, 0.0f)) *
+			glm::scale(glm::vec3(scale)) *
+			glm::translate(-g_PropAnchors[copy.prop - GROUP_VASE]);
+		copy.materialShift = i / PROP_COUNT;
+	}
 
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+	// keep the copies of each prop together for the group timing
+	std::stable_sort(m_stressCopies.begin(), m_stressCopies.end(),
+		[](const STRESS_COPY& a, const STRESS_COPY& b) { return a.prop < b.prop; });
 
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+	// the floor plane is 24 by 16 units, stretch it under every copy
+	float floorExtent = halfExtent + STRESS_SPACING;
+	m_stressFloorTransform = glm::translate(g_FloorCenter) *
+		glm::scale(glm::vec3(std::max(1.0f, floorExtent / 12.0f), 1.0f, std::max(1.0f, floorExtent / 8.0f))) *
+		glm::translate(-g_FloorCenter);
 
-		return true;
-	}
+	BuildDrawList();
+}
 
-	std::cout << "Could not load image:" << filename << std::endl;
+/***********************************************************
+ *  CreateGLTexture()
+ *
+ *  This method is used for creating a texture for an image
+ *  file in the next available texture slot in memory. The
+ *  texture holds a placeholder until the texture loader has
+ *  decoded the image in the background and RenderScene has
+ *  uploaded it, configured with the texture mapping
+ *  parameters and mipmaps.
+ ***********************************************************/
+bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
+{
+	// register the texture and associate it with the special tag string
+	m_textures.Add(filename, tag);
 
-	// Error loading the image
-	return false;
+	return true;
 }
 
 /***********************************************************
  *  BindGLTextures()
  *
  *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
+ *  OpenGL texture memory slots.  The course program samples
+ *  up to 16 slots, the texture arrays hold the rest. A slot
+ *  gets a new texture when the budget reduces or reloads
+ *  it, so SetDrawState binds it again before drawing.
  ***********************************************************/
 void SceneManager::BindGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	for (int i = 0; (i < m_textures.GetCount()) && (i < COURSE_TEXTURE_UNITS); i++)
 	{
 		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
+		StateCache::ActiveTexture(i);
+		StateCache::BindTexture2D(m_textures.GetTexture(i));
 	}
 }
 
@@ -143,14 +284,14 @@ void SceneManager::BindGLTextures()
  *  DestroyGLTextures()
  *
  *  This method is used for freeing the memory in all the
- *  used texture memory slots.
+ *  used texture memory slots. The bindless handles and
+ *  texture arrays made from the textures go first.
  ***********************************************************/
 void SceneManager::DestroyGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		glGenTextures(1, &m_textureIDs[i].ID);
-	}
+	m_textureHandles.Destroy();
+	m_textureArrays.Destroy();
+	m_textures.Destroy();
 }
 
 /***********************************************************
@@ -161,22 +302,13 @@ void SceneManager::DestroyGLTextures()
  ***********************************************************/
 int SceneManager::FindTextureID(std::string tag)
 {
-	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
+	int textureSlot = m_textures.FindSlot(tag);
+	if (textureSlot < 0)
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
-		}
-		else
-			index++;
+		return(-1);
 	}
 
-	return(textureID);
+	return(static_cast<int>(m_textures.GetTexture(textureSlot)));
 }
 
 /***********************************************************
@@ -187,22 +319,7 @@ int SceneManager::FindTextureID(std::string tag)
  ***********************************************************/
 int SceneManager::FindTextureSlot(std::string tag)
 {
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
-	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureSlot = index;
-			bFound = true;
-		}
-		else
-			index++;
-	}
-
-	return(textureSlot);
+	return(m_textures.FindSlot(tag));
 }
 
 /***********************************************************
@@ -243,8 +360,9 @@ bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 /***********************************************************
  *  SetTransformations()
  *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
+ *  This method is used for setting the transform of the
+ *  next recorded draw using the passed in transformation
+ *  values.
  ***********************************************************/
 void SceneManager::SetTransformations(
 	glm::vec3 scaleXYZ,
@@ -253,6 +371,7 @@ void SceneManager::SetTransformations(
 	float ZrotationDegrees,
 	glm::vec3 positionXYZ)
 {
+	TRACE_ZONE("SetTransformations");
 	// variables for this method
 	glm::mat4 modelView;
 	glm::mat4 scale;
@@ -270,19 +389,16 @@ void SceneManager::SetTransformations(
 	// set the translation value in the transform buffer
 	translation = glm::translate(positionXYZ);
 
-	modelView = translation * rotationX * rotationY * rotationZ * scale;
+	modelView = m_instanceTransform * translation * rotationX * rotationY * rotationZ * scale;
 
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
-	}
+	m_recordState.model = modelView;
 }
 
 /***********************************************************
  *  SetShaderColor()
  *
  *  This method is used for setting the passed in color
- *  into the shader for the next draw command
+ *  for the next recorded draw
  ***********************************************************/
 void SceneManager::SetShaderColor(
 	float redColorValue,
@@ -290,6 +406,7 @@ void SceneManager::SetShaderColor(
 	float blueColorValue,
 	float alphaValue)
 {
+	TRACE_ZONE("SetShaderColor");
 	// variables for this method
 	glm::vec4 currentColor;
 
@@ -298,71 +415,538 @@ void SceneManager::SetShaderColor(
 	currentColor.b = blueColorValue;
 	currentColor.a = alphaValue;
 
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
-	}
+	m_recordState.textureSlot = -1;
+	m_recordState.color = currentColor;
 }
 
 /***********************************************************
  *  SetShaderTexture()
  *
- *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
+ *  This method is used for setting the texture slot of the
+ *  passed in tag for the next recorded draw.
  ***********************************************************/
 void SceneManager::SetShaderTexture(
 	std::string textureTag)
 {
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
-
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
-	}
+	TRACE_ZONE("SetShaderTexture");
+	m_recordState.textureSlot = FindTextureSlot(textureTag);
 }
 
 /***********************************************************
  *  SetTextureUVScale()
  *
  *  This method is used for setting the texture UV scale
- *  values into the shader.
+ *  values for the next recorded draw.
  ***********************************************************/
 void SceneManager::SetTextureUVScale(float u, float v)
 {
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
-	}
+	TRACE_ZONE("SetTextureUVScale");
+	m_recordState.uvScale = glm::vec2(u, v);
 }
 
 /***********************************************************
  *  SetShaderMaterial()
  *
- *  This method is used for passing the material values
- *  into the shader.
+ *  This method is used for setting the material of the
+ *  passed in tag for the next recorded draw. An unknown tag
+ *  keeps the material of the draw before.
  ***********************************************************/
 void SceneManager::SetShaderMaterial(
 	std::string materialTag)
 {
-	if (m_objectMaterials.size() > 0)
+	TRACE_ZONE("SetShaderMaterial");
+	int material = FindMaterialIndex(materialTag);
+	if (material >= 0)
+	{
+		m_recordState.material = ShiftMaterial(material);
+	}
+}
+
+/***********************************************************
+ *  FindMaterialIndex()
+ *
+ *  This method is used for finding the position of a
+ *  defined material in the material list, -1 when there is
+ *  no material with the passed in tag.
+ ***********************************************************/
+int SceneManager::FindMaterialIndex(std::string tag)
+{
+	for (int index = 0; index < static_cast<int>(m_objectMaterials.size()); index++)
+	{
+		if (m_objectMaterials[index].tag.compare(tag) == 0)
+		{
+			return(index);
+		}
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  ShiftMaterial()
+ *
+ *  This method is used for swapping the passed in material
+ *  for the one m_materialShift lit materials later, so the
+ *  copies of the stress scene differ from each other. Unlit
+ *  materials such as "void" are kept, they paint the holes
+ *  black.
+ ***********************************************************/
+int SceneManager::ShiftMaterial(int material) const
+{
+	if ((m_materialShift == 0) || (m_objectMaterials[material].ambientStrength <= 0.0f))
+	{
+		return(material);
+	}
+
+	int litCount = 0;
+	int current = 0;
+	for (int index = 0; index < static_cast<int>(m_objectMaterials.size()); index++)
+	{
+		if (m_objectMaterials[index].ambientStrength > 0.0f)
+		{
+			if (index == material)
+			{
+				current = litCount;
+			}
+			litCount++;
+		}
+	}
+
+	int target = (current + m_materialShift) % litCount;
+	for (int index = 0; index < static_cast<int>(m_objectMaterials.size()); index++)
+	{
+		if ((m_objectMaterials[index].ambientStrength > 0.0f) && (target-- == 0))
+		{
+			return(index);
+		}
+	}
+
+	return(material);
+}
+
+/***********************************************************
+ *  BuildDrawList()
+ *
+ *  This method is used for running the scene description
+ *  once with the meshes reporting to a recorder, which
+ *  turns every Draw*Mesh call into a DRAW_ITEM holding the
+ *  transform, material and texture set before it.
+ *  RenderScene then only walks the finished list.
+ ***********************************************************/
+void SceneManager::BuildDrawList()
+{
+	TRACE_ZONE("BuildDrawList");
+	m_drawItems.clear();
+
+	m_recordState.model = glm::mat4(1.0f);
+	m_recordState.color = glm::vec4(1.0f);
+	m_recordState.uvScale = glm::vec2(1.0f, 1.0f);
+	m_recordState.material = -1;
+	m_recordState.textureSlot = -1;
+	m_recordState.group = GROUP_FLOOR;
+
+	m_basicMeshes->SetDrawRecorder([this](RenderStats::MESH_TYPE meshType, int variant)
+	{
+		m_recordState.mesh = meshType;
+		m_recordState.variant = variant;
+		m_drawItems.push_back(m_recordState);
+	});
+
+	if (m_stressCopies.empty() == false)
+	{
+		RecordStressScene();
+	}
+	else
+	{
+		RecordFloor();
+		m_recordState.group = GROUP_VASE;
+		RecordVase();
+		m_recordState.group = GROUP_JUG;
+		RecordJug();
+		m_recordState.group = GROUP_TRASH_CAN;
+		RecordTrashCan();
+		m_recordState.group = GROUP_WEIGHTS;
+		RecordWeights();
+		m_recordState.group = GROUP_CONSOLE;
+		RecordConsole();
+		m_recordState.group = GROUP_LIGHT_CUBES;
+		RecordLightCubes();
+	}
+
+	m_basicMeshes->SetDrawRecorder(nullptr);
+	m_bObjectTableDirty = true;
+	SortDrawList();
+}
+
+/***********************************************************
+ *  SortDrawList()
+ *
+ *  This method is used for ordering the draw list so draws
+ *  that share shader state follow each other. Every draw
+ *  gets a 64-bit key, from the most to the least important
+ *  bits:
+ *
+ *    63..60  object group, only while group timing is on
+ *    59      shader path, flat color or texture
+ *    58..47  texture slot
+ *    46..39  material
+ *    38..35  mesh type
+ *    34..32  mesh variant
+ *    31..0   position in the list
+ *
+ *  The low bits keep equal draws in authoring order and
+ *  give RenderScene the draw to submit. Without sorting the
+ *  keys only hold the position.
+ ***********************************************************/
+void SceneManager::SortDrawList()
+{
+	TRACE_ZONE("SortDrawList");
+	m_drawOrder.resize(m_drawItems.size());
+	for (uint32_t index = 0; index < m_drawOrder.size(); index++)
+	{
+		const DRAW_ITEM& item = m_drawItems[index];
+		uint64_t sortKey = index;
+		if (m_bSortDraws == true)
+		{
+			uint64_t group = m_groupTimer.IsCreated() ? static_cast<uint64_t>(item.group) : 0;
+			uint64_t bTextured = (item.textureSlot >= 0) ? 1 : 0;
+			uint64_t texture = static_cast<uint64_t>(item.textureSlot + 1) & 0xFFF;
+			uint64_t material = static_cast<uint64_t>(item.material + 1) & 0xFF;
+			sortKey |= (group << 60) | (bTextured << 59) | (texture << 47) | (material << 39) |
+				(static_cast<uint64_t>(item.mesh) << 35) | (static_cast<uint64_t>(item.variant & 7) << 32);
+		}
+		m_drawOrder[index] = sortKey;
+	}
+
+	std::sort(m_drawOrder.begin(), m_drawOrder.end());
+
+	if (m_submitMode == SUBMIT_BAKED)
+	{
+		BuildBakedBatches();
+	}
+	else if (m_submitMode != SUBMIT_DRAWS)
+	{
+		BuildInstanceBatches();
+	}
+}
+
+/***********************************************************
+ *  BuildInstanceBatches()
+ *
+ *  This method is used for grouping the draw list into the
+ *  runs one instanced draw call can cover. Draws of the same
+ *  mesh variant become one batch, whatever their transform,
+ *  color, material and texture, as those are read from the
+ *  object table. Only with bindless textures does the
+ *  texture split batches. The object indices of all batches
+ *  are uploaded into one buffer, each batch drawing its own
+ *  range of it. For the indirect mode every batch also
+ *  becomes a multi-draw command.
+ ***********************************************************/
+void SceneManager::BuildInstanceBatches()
+{
+	TRACE_ZONE("BuildInstanceBatches");
+	m_instanceBatches.clear();
+
+	// the instanced order leaves out the material and texture, which no
+	// longer split a run, but keeps the groups apart while they are timed.
+	// A bindless handle is only sampled safely when every invocation of a
+	// draw uses the same one, so with handles the textures split runs again
+	bool bTimeGroups = m_groupTimer.IsCreated();
+	bool bSplitTextures = m_textureHandles.IsBuilt();
+	std::vector<uint32_t> order(m_drawItems.size());
+	for (uint32_t index = 0; index < order.size(); index++)
+	{
+		order[index] = index;
+	}
+	std::stable_sort(order.begin(), order.end(), [this, bTimeGroups, bSplitTextures](uint32_t a, uint32_t b)
 	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
+		const DRAW_ITEM& itemA = m_drawItems[a];
+		const DRAW_ITEM& itemB = m_drawItems[b];
+		int groupA = bTimeGroups ? itemA.group : 0;
+		int groupB = bTimeGroups ? itemB.group : 0;
+		if (groupA != groupB)
+		{
+			return groupA < groupB;
+		}
+		if (bSplitTextures && (itemA.textureSlot != itemB.textureSlot))
+		{
+			return itemA.textureSlot < itemB.textureSlot;
+		}
+		if (itemA.mesh != itemB.mesh)
+		{
+			return itemA.mesh < itemB.mesh;
+		}
+		return itemA.variant < itemB.variant;
+	});
 
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
+	if (m_bObjectTableDirty == true)
+	{
+		UploadObjectTable();
+	}
+
+	// each instance only holds the index of its draw item in the object table
+	std::vector<GLuint> instances;
+	instances.reserve(order.size());
+	int batchTexture = -1;
+	for (uint32_t index : order)
+	{
+		const DRAW_ITEM& item = m_drawItems[index];
+		int group = bTimeGroups ? item.group : 0;
+		if ((m_instanceBatches.empty() == true) ||
+			(m_instanceBatches.back().mesh != item.mesh) ||
+			(m_instanceBatches.back().variant != item.variant) ||
+			(m_instanceBatches.back().group != group) ||
+			(bSplitTextures && (batchTexture != item.textureSlot)))
+		{
+			batchTexture = item.textureSlot;
+			INSTANCE_BATCH batch;
+			batch.mesh = item.mesh;
+			batch.variant = item.variant;
+			batch.group = group;
+			batch.firstInstance = static_cast<int>(instances.size());
+			batch.instanceCount = 0;
+			m_instanceBatches.push_back(batch);
+			m_basicMeshes->PrepareInstancedMesh(item.mesh, item.variant);
+		}
+
+		instances.push_back(index);
+		m_instanceBatches.back().instanceCount++;
+	}
+
+	m_basicMeshes->SetInstances(instances);
+
+	if (m_submitMode == SUBMIT_INDIRECT)
+	{
+		std::vector<TrackedShapeMeshes::DRAW_COMMAND> commands(m_instanceBatches.size());
+		for (size_t index = 0; index < m_instanceBatches.size(); index++)
 		{
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+			const INSTANCE_BATCH& batch = m_instanceBatches[index];
+			m_basicMeshes->GetDrawCommand(batch.mesh, batch.variant, batch.firstInstance, batch.instanceCount, commands[index]);
 		}
+		m_basicMeshes->SetDrawCommands(commands);
 	}
 }
+
+/***********************************************************
+ *  BuildBakedBatches()
+ *
+ *  This method is used for merging the draw list into as
+ *  few meshes as the shader state allows. The scene never
+ *  moves an object after the draw list is recorded, so all
+ *  draws are static: the draws that share material,
+ *  texture and, for flat color, color are moved into world
+ *  space and baked into one mesh, and RenderScene draws
+ *  each with one call and no per-object uniforms. The
+ *  groups stay apart while they are timed. When the meshes
+ *  would not fit under the vertex limit nothing is baked,
+ *  and RenderScene draws the objects one by one.
+ ***********************************************************/
+bool SceneManager::BuildBakedBatches()
+{
+	TRACE_ZONE("BuildBakedBatches");
+	m_bakedBatches.clear();
+	m_basicMeshes->DestroyBakedMeshes();
+
+	bool bTimeGroups = m_groupTimer.IsCreated();
+	std::vector<uint32_t> order(m_drawItems.size());
+	for (uint32_t index = 0; index < order.size(); index++)
+	{
+		order[index] = index;
+	}
+	// the color only tells flat color draws apart, a textured draw ignores it
+	auto batchKey = [this, bTimeGroups](uint32_t index)
+	{
+		const DRAW_ITEM& item = m_drawItems[index];
+		glm::vec4 color = (item.textureSlot < 0) ? item.color : glm::vec4(0.0f);
+		return std::make_tuple(bTimeGroups ? item.group : 0, item.textureSlot, item.material,
+			color.r, color.g, color.b, color.a);
+	};
+	std::stable_sort(order.begin(), order.end(), [&batchKey](uint32_t a, uint32_t b)
+	{
+		return batchKey(a) < batchKey(b);
+	});
+
+	std::vector<TrackedShapeMeshes::BAKE_OBJECT> objects;
+	for (size_t first = 0; first < order.size();)
+	{
+		size_t last = first;
+		objects.clear();
+		while ((last < order.size()) && (batchKey(order[last]) == batchKey(order[first])))
+		{
+			const DRAW_ITEM& item = m_drawItems[order[last]];
+			TrackedShapeMeshes::BAKE_OBJECT object;
+			object.meshType = item.mesh;
+			object.variant = item.variant;
+			object.model = item.model;
+			object.uvScale = item.uvScale;
+			objects.push_back(object);
+			last++;
+		}
+
+		const DRAW_ITEM& item = m_drawItems[order[first]];
+		BAKED_BATCH batch;
+		batch.material = item.material;
+		batch.textureSlot = item.textureSlot;
+		batch.color = item.color;
+		batch.group = bTimeGroups ? item.group : 0;
+		batch.bakedMesh = m_basicMeshes->BakeMesh(objects);
+		if (batch.bakedMesh < 0)
+		{
+			std::cout << "The draw list is too large to bake, drawing the objects one by one" << std::endl;
+			m_bakedBatches.clear();
+			m_basicMeshes->DestroyBakedMeshes();
+			return false;
+		}
+		m_bakedBatches.push_back(batch);
+		first = last;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  UploadObjectTable()
+ *
+ *  This method is used for uploading the transform, color,
+ *  UV scale, material and texture slot of every draw item
+ *  into the object table, in draw list order. The table
+ *  only changes when the draw list is built again, so a
+ *  static scene uploads it once.
+ ***********************************************************/
+void SceneManager::UploadObjectTable()
+{
+	static_assert(sizeof(SceneProgram::OBJECT_DATA) == 96, "OBJECT_DATA must match the std430 layout");
+	std::vector<SceneProgram::OBJECT_DATA> objects(m_drawItems.size());
+	for (size_t index = 0; index < m_drawItems.size(); index++)
+	{
+		const DRAW_ITEM& item = m_drawItems[index];
+		objects[index].model = item.model;
+		objects[index].color = item.color;
+		objects[index].uvScale = item.uvScale;
+		// draws before the first material use the first one
+		objects[index].material = std::max(item.material, 0);
+		objects[index].texture = item.textureSlot;
+	}
+
+	if (m_objectTableBuffer == 0)
+	{
+		glGenBuffers(1, &m_objectTableBuffer);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectTableBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, objects.size() * sizeof(SceneProgram::OBJECT_DATA), objects.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	m_bObjectTableDirty = false;
+}
+
+/***********************************************************
+ *  SetSortedSubmission()
+ *
+ *  This method is used for choosing between submitting the
+ *  draws sorted by shader state or in authoring order.
+ ***********************************************************/
+void SceneManager::SetSortedSubmission(bool bSorted)
+{
+	m_bSortDraws = bSorted;
+	SortDrawList();
+}
+
+/***********************************************************
+ *  SetSubmissionMode()
+ *
+ *  This method is used for choosing how RenderScene sends
+ *  the draw list to OpenGL. The instanced and indirect
+ *  modes draw with their own program, which gets the object
+ *  materials once here. Both read the objects from a storage
+ *  buffer and sample the textures through bindless handles
+ *  where the driver has ARB_bindless_texture, or else packed
+ *  into arrays. That needs OpenGL 4.3, and both wait here
+ *  until the textures are fully loaded. The textures with
+ *  bindless handles, or the arrays in place of the loaded
+ *  textures, count against the texture budget. The baked
+ *  mode keeps the course program and fails when the draw
+ *  list is too large to bake.
+ ***********************************************************/
+bool SceneManager::SetSubmissionMode(SUBMIT_MODE submitMode)
+{
+	if ((submitMode == SUBMIT_INSTANCED) || (submitMode == SUBMIT_INDIRECT))
+	{
+		if (GLEW_VERSION_4_3 == GL_FALSE)
+		{
+			std::cout << "Instanced and indirect submission need OpenGL 4.3" << std::endl;
+			return false;
+		}
+
+		// the handles have to go before any texture is reloaded
+		m_textureHandles.Destroy();
+		m_textureArrays.Destroy();
+		m_textures.SetPinned(false);
+		m_textures.SetReservedBytes(0);
+		m_textures.Finish();
+		std::vector<GLuint> textures;
+		for (int slot = 0; slot < m_textures.GetCount(); slot++)
+		{
+			textures.push_back(m_textures.GetTexture(slot));
+		}
+
+		bool bBindless = (m_bAllowBindless == true) && (TextureHandles::IsSupported() == true);
+		if ((bBindless == true) &&
+			((m_textureHandles.Build(textures) == false) || (m_sceneProgram.Create(true) == false)))
+		{
+			std::cout << "Bindless textures failed, falling back to texture arrays" << std::endl;
+			m_textureHandles.Destroy();
+			bBindless = false;
+		}
+		if ((bBindless == false) &&
+			((m_sceneProgram.Create(false) == false) ||
+			(m_textureArrays.Build(textures, SceneProgram::TOTAL_TEXTURE_ARRAYS) == false)))
+		{
+			return false;
+		}
+		// resident handles keep their textures as they are and in the budget,
+		// the arrays are copies, so they are budgeted in place of the loaded
+		// textures, which nothing draws any more
+		m_textures.SetPinned(bBindless);
+		if (bBindless == false)
+		{
+			m_textures.EvictAll();
+			m_textures.SetReservedBytes(m_textureArrays.GetBytes());
+		}
+	}
+	else
+	{
+		m_textureHandles.Destroy();
+		m_textureArrays.Destroy();
+		m_textures.SetPinned(false);
+		m_textures.SetReservedBytes(0);
+	}
+
+	if (submitMode != SUBMIT_DRAWS)
+	{
+		GLuint previousProgram = m_sceneProgram.Use();
+		int materialCount = std::min(static_cast<int>(m_objectMaterials.size()), static_cast<int>(SceneProgram::TOTAL_MATERIALS));
+		char name[64];
+		for (int index = 0; index < materialCount; index++)
+		{
+			const OBJECT_MATERIAL& material = m_objectMaterials[index];
+			snprintf(name, sizeof(name), "materials[%d].ambientColor", index);
+			m_sceneProgram.SetVec3(m_sceneProgram.GetLocation(name), material.ambientColor);
+			snprintf(name, sizeof(name), "materials[%d].ambientStrength", index);
+			m_sceneProgram.SetFloat(m_sceneProgram.GetLocation(name), material.ambientStrength);
+			snprintf(name, sizeof(name), "materials[%d].diffuseColor", index);
+			m_sceneProgram.SetVec3(m_sceneProgram.GetLocation(name), material.diffuseColor);
+			snprintf(name, sizeof(name), "materials[%d].specularColor", index);
+			m_sceneProgram.SetVec3(m_sceneProgram.GetLocation(name), material.specularColor);
+		}
+		StateCache::UseProgram(previousProgram);
+	}
+
+	m_submitMode = submitMode;
+	m_instanceBatches.clear();
+	m_bakedBatches.clear();
+	SortDrawList();
+	return (submitMode != SUBMIT_BAKED) || (m_drawItems.empty() == true) || (m_bakedBatches.empty() == false);
+}
 //**************************************************************************************************************************************************
 //*********************************************************************************************************************************************************************************************
 //**************************************************************************************************************************************************
@@ -487,6 +1071,8 @@ void SceneManager::LoadSceneTextures()
 {
 	bool bReturn = false;
 
+	DestroyGLTextures(); // Free the textures of an earlier scene load
+
 	//▀█▀ ▄▀█ █▄▄ █░░ █▀▀
 	//░█░ █▀█ █▄█ █▄▄ ██▄
 	bReturn = CreateGLTexture(
@@ -619,7 +1205,8 @@ void SceneManager::DefineObjectMaterials()
 void SceneManager::SetupSceneLights()
 {
 	// Enable or disable lighting based on the flag (uncomment to change to default lights).
-	m_pShaderManager->setBoolValue(g_UseLightingName, true); // Mute this line to switch to default lighting.
+	bool bUseLighting = true; // Set to false to switch to default lighting.
+	m_pShaderManager->setBoolValue(g_UseLightingName, bUseLighting);
 
 	// Store the positions of the lights
 	lightPositions[0] = glm::vec3(-100.0f, 40.0f, 50.0f); // Red Box Light - Positioned to illuminate left side
@@ -627,46 +1214,39 @@ void SceneManager::SetupSceneLights()
 	lightPositions[2] = glm::vec3(100.0f, 20.0f, 10.0f); // Blue Box Light - Positioned TV-style lighting
 	lightPositions[3] = glm::vec3(20.0f, 50.0f, -100.0f); // Yellow Box Light - Positioned to simulate sunlight
 
-	// Configure lighting for Red Box (Left Object)
-	m_pShaderManager->setVec3Value("lightSources[0].position", lightPositions[0]); // Set light position
-	m_pShaderManager->setVec3Value("lightSources[0].ambientColor", 0.0f, 0.0f, 0.0f); // Set ambient color
-	m_pShaderManager->setVec3Value("lightSources[0].diffuseColor", 0.0f, 0.0f, 0.0f); // Set diffuse color
-	m_pShaderManager->setVec3Value("lightSources[0].specularColor", 0.0f, 0.0f, 0.0f); // Set specular color
-	m_pShaderManager->setFloatValue("lightSources[0].focalStrength", 50.0f); // Set focal strength
-	m_pShaderManager->setFloatValue("lightSources[0].specularIntensity", 0.4f); // Set specular intensity
-
-	// Configure lighting for Green Box (Middle Object)
-	m_pShaderManager->setVec3Value("lightSources[1].position", lightPositions[1]); // Set light position
-	m_pShaderManager->setVec3Value("lightSources[1].ambientColor", 0.0f, 0.0f, 0.1f); // Set ambient color
-	m_pShaderManager->setVec3Value("lightSources[1].diffuseColor", 0.0f, 0.0f, 0.0f); // Set diffuse color
-	m_pShaderManager->setVec3Value("lightSources[1].specularColor", 0.0f, 0.0f, 0.0f); // Set specular color
-	m_pShaderManager->setFloatValue("lightSources[1].focalStrength", 30.0f); // Set focal strength
-	m_pShaderManager->setFloatValue("lightSources[1].specularIntensity", 0.1f); // Set specular intensity
-
-	// Configure lighting for Blue Box (TV Light)
-	m_pShaderManager->setVec3Value("lightSources[2].position", lightPositions[2]); // Set light position
-	m_pShaderManager->setVec3Value("lightSources[2].ambientColor", 0.0f, 0.0f, 0.3f); // Set ambient color
-	m_pShaderManager->setVec3Value("lightSources[2].diffuseColor", 0.0f, 0.0f, 0.2f); // Set diffuse color
-	m_pShaderManager->setVec3Value("lightSources[2].specularColor", 0.0f, 0.0f, 2.0f); // Set specular color
-	m_pShaderManager->setFloatValue("lightSources[2].focalStrength", 100.0f); // Set focal strength
-	m_pShaderManager->setFloatValue("lightSources[2].specularIntensity", 1.0f); // Set specular intensity
-
-	// Configure lighting for Yellow Box (Sunlight)
-	m_pShaderManager->setVec3Value("lightSources[3].position", lightPositions[3]); // Set light position
-	m_pShaderManager->setVec3Value("lightSources[3].ambientColor", 0.0f, 0.0f, 0.0f); // Set ambient color
-	m_pShaderManager->setVec3Value("lightSources[3].diffuseColor", 0.0f, 0.0f, 0.0f); // Set diffuse color
-	m_pShaderManager->setVec3Value("lightSources[3].specularColor", 0.0f, 0.0f, 0.0f); // Set specular color
-	m_pShaderManager->setFloatValue("lightSources[3].focalStrength", 12.0f); // Set focal strength
-	m_pShaderManager->setFloatValue("lightSources[3].specularIntensity", 0.2f); // Set specular intensity
-
-	// Configure additional light source
-	m_pShaderManager->setVec3Value("lightSources[4].position", glm::vec3(-30.0f, 40.0f, 30.0f)); // Set position for extra light
-	m_pShaderManager->setVec3Value("lightSources[4].ambientColor", 0.0f, 0.0f, 0.0f); // Set ambient color for extra light
-	m_pShaderManager->setVec3Value("lightSources[4].diffuseColor", 0.0f, 0.0f, 0.0f); // Set diffuse color for extra light
-	m_pShaderManager->setVec3Value("lightSources[4].specularColor", 0.3f, 0.3f, 0.3f); // Set specular color for extra light
-	m_pShaderManager->setFloatValue("lightSources[4].focalStrength", 30.0f); // Set focal strength for extra light
-	m_pShaderManager->setFloatValue("lightSources[4].specularIntensity", 0.3f); // Set specular intensity for extra light
+	// position, focal strength, ambient color, specular intensity, diffuse color, padding, specular color, padding
+	const UniformBlocks::LIGHT_SOURCE lights[UniformBlocks::TOTAL_LIGHTS] = {
+		// Red Box (Left Object)
+		{ lightPositions[0], 50.0f, glm::vec3(0.0f, 0.0f, 0.0f), 0.4f, glm::vec3(0.0f, 0.0f, 0.0f), 0.0f, glm::vec3(0.0f, 0.0f, 0.0f), 0.0f },
+		// Green Box (Middle Object)
+		{ lightPositions[1], 30.0f, glm::vec3(0.0f, 0.0f, 0.1f), 0.1f, glm::vec3(0.0f, 0.0f, 0.0f), 0.0f, glm::vec3(0.0f, 0.0f, 0.0f), 0.0f },
+		// Blue Box (TV Light)
+		{ lightPositions[2], 100.0f, glm::vec3(0.0f, 0.0f, 0.3f), 1.0f, glm::vec3(0.0f, 0.0f, 0.2f), 0.0f, glm::vec3(0.0f, 0.0f, 2.0f), 0.0f },
+		// Yellow Box (Sunlight)
+		{ lightPositions[3], 12.0f, glm::vec3(0.0f, 0.0f, 0.0f), 0.2f, glm::vec3(0.0f, 0.0f, 0.0f), 0.0f, glm::vec3(0.0f, 0.0f, 0.0f), 0.0f },
+		// Additional light source
+		{ glm::vec3(-30.0f, 40.0f, 30.0f), 30.0f, glm::vec3(0.0f, 0.0f, 0.0f), 0.3f, glm::vec3(0.0f, 0.0f, 0.0f), 0.0f, glm::vec3(0.3f, 0.3f, 0.3f), 0.0f } };
+
+	// The course shaders take the lights as plain uniforms, one field at a time
+	char name[64];
+	for (int i = 0; i < UniformBlocks::TOTAL_LIGHTS; i++)
+	{
+		snprintf(name, sizeof(name), "lightSources[%d].position", i);
+		m_pShaderManager->setVec3Value(name, lights[i].position); // Set light position
+		snprintf(name, sizeof(name), "lightSources[%d].ambientColor", i);
+		m_pShaderManager->setVec3Value(name, lights[i].ambientColor); // Set ambient color
+		snprintf(name, sizeof(name), "lightSources[%d].diffuseColor", i);
+		m_pShaderManager->setVec3Value(name, lights[i].diffuseColor); // Set diffuse color
+		snprintf(name, sizeof(name), "lightSources[%d].specularColor", i);
+		m_pShaderManager->setVec3Value(name, lights[i].specularColor); // Set specular color
+		snprintf(name, sizeof(name), "lightSources[%d].focalStrength", i);
+		m_pShaderManager->setFloatValue(name, lights[i].focalStrength); // Set focal strength
+		snprintf(name, sizeof(name), "lightSources[%d].specularIntensity", i);
+		m_pShaderManager->setFloatValue(name, lights[i].specularIntensity); // Set specular intensity
+	}
 
+	// Every other program reads the whole light block, written at once
+	m_pShaderManager->GetUniformBlocks().SetLights(lights, UniformBlocks::TOTAL_LIGHTS, bUseLighting);
 }
 //**********************************************************************************
 //█▀█ █▀█ █▀▀ █▀█ ▄▀█ █▀█ █▀▀   █▀ █▀▀ █▀▀ █▄░█ █▀▀
@@ -689,13 +1269,194 @@ void SceneManager::PrepareScene()
 	m_basicMeshes->LoadSphereMesh();
 	m_basicMeshes->LoadTaperedCylinderMesh();
 	m_basicMeshes->LoadTorusMesh();
+
+	BuildDrawList(); // Record the draws RenderScene walks every frame
 }
 //**********************************************************************************
 //█▀█ █▀▀ █▄░█ █▀▄ █▀▀ █▀█   █▀ █▀▀ █▀▀ █▄░█ █▀▀
 //█▀▄ ██▄ █░▀█ █▄▀ ██▄ █▀▄   ▄█ █▄▄ ██▄ █░▀█ ██▄
 //**********************************************************************************
-//RenderScene() - used for rendering the 3D scene by transforming and drawing the basic 3D shapes
+//RenderScene() - used for rendering the 3D scene by submitting the draw list that PrepareScene() built
 void SceneManager::RenderScene()
+{
+	// bring in the next decoded texture images, the rest draw their placeholder,
+	// then evict or reduce the textures over the budget
+	m_textures.Update(TEXTURE_UPLOAD_BUDGET);
+
+	// read back the group timings that have finished, then time this frame
+	size_t pendingTimings = m_groupTimings.size();
+	m_groupTimer.Collect(m_groupTimings);
+	if (m_groupTimings.size() > pendingTimings)
+	{
+		m_lastGroupTiming = m_groupTimings.back();
+	}
+	m_groupTimer.Begin(m_renderedFrames++); // Time the following draws as the floor
+
+	if (m_submitMode == SUBMIT_INSTANCED)
+	{
+		RenderInstanced(); // Draw each batch with one instanced draw call
+		m_groupTimer.End();
+		return;
+	}
+	if (m_submitMode == SUBMIT_INDIRECT)
+	{
+		RenderIndirect(); // Draw every batch with one multi-draw call
+		m_groupTimer.End();
+		return;
+	}
+	// a draw list too large to bake is drawn object by object
+	if ((m_submitMode == SUBMIT_BAKED) && (m_bakedBatches.empty() == false))
+	{
+		RenderBaked(); // Draw each baked mesh with one draw call
+		m_groupTimer.End();
+		return;
+	}
+
+	// nothing is known about the shader state at the start of a frame
+	int currentMaterial = -2;
+	int currentTexture = -2;
+	glm::vec4 currentColor(-1.0f);
+
+	for (uint64_t sortKey : m_drawOrder)
+	{
+		const DRAW_ITEM& item = m_drawItems[static_cast<uint32_t>(sortKey)];
+		m_groupTimer.NextSection(item.group); // Time the following draws as the item group
+
+		m_pShaderManager->setMat4Value(g_ModelName, item.model); // Set transform
+		SetDrawState(item.material, item.textureSlot, item.color, currentMaterial, currentTexture, currentColor); // Set material, texture and color
+		if (item.uvScale != m_uploadedUVScale)
+		{
+			m_pShaderManager->setVec2Value(g_UVScaleName, item.uvScale); // Set UV scale
+			m_uploadedUVScale = item.uvScale;
+		}
+
+		m_basicMeshes->DrawMesh(item.mesh, item.variant); // Draw Shape
+	}
+
+	m_groupTimer.End(); // End the light cubes timing
+}
+//SetDrawState() - used for uploading the material, texture and color of the next draw, skipping what the last draw already set
+void SceneManager::SetDrawState(int material, int textureSlot, const glm::vec4& color,
+	int& currentMaterial, int& currentTexture, glm::vec4& currentColor)
+{
+	// the course program only has a unit for the first texture slots
+	if (textureSlot >= COURSE_TEXTURE_UNITS)
+	{
+		textureSlot = -1;
+	}
+	if ((material >= 0) && (material != currentMaterial))
+	{
+		const OBJECT_MATERIAL& objectMaterial = m_objectMaterials[material]; // Set material
+		m_pShaderManager->setVec3Value(g_AmbientColorName, objectMaterial.ambientColor);
+		m_pShaderManager->setFloatValue(g_AmbientStrengthName, objectMaterial.ambientStrength);
+		m_pShaderManager->setVec3Value(g_DiffuseColorName, objectMaterial.diffuseColor);
+		m_pShaderManager->setVec3Value(g_SpecularColorName, objectMaterial.specularColor);
+		m_pShaderManager->setFloatValue(g_ShininessName, objectMaterial.shininess);
+		RenderStats::CountMaterialChange();
+		currentMaterial = material;
+	}
+	if (textureSlot != currentTexture)
+	{
+		// switching between texture and flat color is a change of shader path
+		if (((textureSlot < 0) != (currentTexture < 0)) || (currentTexture == -2))
+		{
+			m_pShaderManager->setIntValue(g_UseTextureName, textureSlot >= 0);
+		}
+		if (textureSlot >= 0)
+		{
+			StateCache::ActiveTexture(textureSlot); // Bind the current texture of the slot, marking it used
+			StateCache::BindTexture2D(m_textures.Use(textureSlot));
+			m_pShaderManager->setSampler2DValue(g_TextureValueName, textureSlot); // Set texture
+		}
+		RenderStats::CountTextureChange();
+		currentTexture = textureSlot;
+	}
+	if ((textureSlot < 0) && (color != currentColor))
+	{
+		m_pShaderManager->setVec4Value(g_ColorValueName, color); // Set color
+		currentColor = color;
+	}
+}
+//RenderBaked() - used for submitting the baked meshes, one course program draw call per batch
+void SceneManager::RenderBaked()
+{
+	// the baked vertices are already in world space and hold the UV scale
+	m_pShaderManager->setMat4Value(g_ModelName, glm::mat4(1.0f)); // Set transform
+	if (m_uploadedUVScale != glm::vec2(1.0f, 1.0f))
+	{
+		m_uploadedUVScale = glm::vec2(1.0f, 1.0f);
+		m_pShaderManager->setVec2Value(g_UVScaleName, m_uploadedUVScale); // Set UV scale
+	}
+
+	int currentMaterial = -2;
+	int currentTexture = -2;
+	glm::vec4 currentColor(-1.0f);
+	for (const BAKED_BATCH& batch : m_bakedBatches)
+	{
+		m_groupTimer.NextSection(batch.group); // Time the following draws as the batch group
+
+		SetDrawState(batch.material, batch.textureSlot, batch.color, currentMaterial, currentTexture, currentColor); // Set material, texture and color
+		m_basicMeshes->DrawBakedMesh(batch.bakedMesh); // Draw the merged shapes
+	}
+}
+//RenderInstanced() - used for submitting the draw list as one instanced draw per batch
+void SceneManager::RenderInstanced()
+{
+	GLuint previousProgram = m_sceneProgram.Use();
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SceneProgram::TEXTURE_TABLE_BINDING,
+		m_textureHandles.IsBuilt() ? m_textureHandles.GetHandleTable() : m_textureArrays.GetLayerTable());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SceneProgram::OBJECT_TABLE_BINDING, m_objectTableBuffer);
+	m_textureArrays.Bind(); // Bind the texture arrays once, bindless handles need no binds
+
+	for (const INSTANCE_BATCH& batch : m_instanceBatches)
+	{
+		m_groupTimer.NextSection(batch.group); // Time the following draws as the batch group
+		m_basicMeshes->DrawMeshInstanced(batch.mesh, batch.variant, batch.firstInstance, batch.instanceCount); // Draw Shapes
+	}
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SceneProgram::TEXTURE_TABLE_BINDING, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SceneProgram::OBJECT_TABLE_BINDING, 0);
+	StateCache::UseProgram(previousProgram);
+}
+//RenderIndirect() - used for submitting the draw list as multi-draw calls, split only where the timed group changes
+void SceneManager::RenderIndirect()
+{
+	GLuint previousProgram = m_sceneProgram.Use();
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SceneProgram::TEXTURE_TABLE_BINDING,
+		m_textureHandles.IsBuilt() ? m_textureHandles.GetHandleTable() : m_textureArrays.GetLayerTable());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SceneProgram::OBJECT_TABLE_BINDING, m_objectTableBuffer);
+	m_textureArrays.Bind(); // Bind the texture arrays once, bindless handles need no binds
+
+	int batchCount = static_cast<int>(m_instanceBatches.size());
+	int firstCommand = 0;
+	while (firstCommand < batchCount)
+	{
+		int group = m_instanceBatches[firstCommand].group;
+		int commandCount = 1;
+		while ((firstCommand + commandCount < batchCount) && (m_instanceBatches[firstCommand + commandCount].group == group))
+		{
+			commandCount++;
+		}
+
+		m_groupTimer.NextSection(group); // Time the following draws as the batch group
+		m_basicMeshes->DrawMeshesIndirect(firstCommand, commandCount); // Draw Shapes
+		firstCommand += commandCount;
+	}
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SceneProgram::TEXTURE_TABLE_BINDING, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SceneProgram::OBJECT_TABLE_BINDING, 0);
+	StateCache::UseProgram(previousProgram);
+}
+
+
+
+
+//**************************************************************************************************************************************************
+//█ ▀█▀ █▀▀ █▀▄▀█   █▀█   ▄▄   █▀▀ █░░ █▀█ █▀█ █▀█
+//█ ░█░ ██▄ █░▀░█   █▄█   ░░   █▀░ █▄▄ █▄█ █▄█ █▀▄
+//**********************************************************************************
+//RecordFloor() - used for recording the draws of the floor plane
+void SceneManager::RecordFloor()
 {
 	// Declare the variables for the transformations
 	glm::vec3 scaleXYZ;
@@ -703,15 +1464,7 @@ void SceneManager::RenderScene()
 	float YrotationDegrees = 0.0f;
 	float ZrotationDegrees = 0.0f;
 	glm::vec3 positionXYZ;
-//**************************************************************************************************************************************************
-//**************************************************************************************************************************************************
 
-
-
-//**************************************************************************************************************************************************
-//**************************************************************************************************************************************************
-//█ ▀█▀ █▀▀ █▀▄▀█   █▀█   ▄▄   █▀▀ █░░ █▀█ █▀█ █▀█
-//█ ░█░ ██▄ █░▀░█   █▄█   ░░   █▀░ █▄▄ █▄█ █▄█ █▀▄
 	// Create floor plane
 	scaleXYZ = glm::vec3(12.0f, 1.0f, 8.0f); // Scale shape
 	positionXYZ = glm::vec3(2.5f, 0.0f, -12.0f); // Position shape
@@ -719,7 +1472,8 @@ void SceneManager::RenderScene()
 	SetShaderTexture("metal_table"); // Set material
 	SetShaderMaterial("dull"); // Set texture
 	m_basicMeshes->DrawPlaneMesh(); // Draw Shape
-//**************************************************************************************************************************************************
+}
+
 
 
 
@@ -727,6 +1481,16 @@ void SceneManager::RenderScene()
 //█ ▀█▀ █▀▀ █▀▄▀█   ▄█   ▄▄   █▀ █▀▄▀█ ▄▀█ █░░ █░░   █░█ ▄▀█ █▀ █▀▀
 //█ ░█░ ██▄ █░▀░█   ░█   ░░   ▄█ █░▀░█ █▀█ █▄▄ █▄▄   ▀▄▀ █▀█ ▄█ ██▄
 //**********************************************************************************
+//RecordVase() - used for recording the draws of the small vase
+void SceneManager::RecordVase()
+{
+	// Declare the variables for the transformations
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 0.0f;
+	float YrotationDegrees = 0.0f;
+	float ZrotationDegrees = 0.0f;
+	glm::vec3 positionXYZ;
+
 	// Create Sphere - Vase Body
 	scaleXYZ = glm::vec3(2.0f, 2.0f, 2.0f); // Scale shape
 	positionXYZ = glm::vec3(0.0f, 2.0f, -8.4f); // Position shape
@@ -768,7 +1532,8 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("porcelaine"); // Set material
 	SetShaderTexture("blue_vase3"); // Set texture
 	m_basicMeshes->DrawTorusMesh(); // Draw Shape
-//**************************************************************************************************************************************************
+}
+
 
 
 
@@ -776,6 +1541,16 @@ void SceneManager::RenderScene()
 //█ ▀█▀ █▀▀ █▀▄▀█   ▀█   ▄▄   █░█░█ ▄▀█ ▀█▀ █▀▀ █▀█   ░░█ █░█ █▀▀
 //█ ░█░ ██▄ █░▀░█   █▄   ░░   ▀▄▀▄▀ █▀█ ░█░ ██▄ █▀▄   █▄█ █▄█ █▄█
 //**********************************************************************************
+//RecordJug() - used for recording the draws of the water jug
+void SceneManager::RecordJug()
+{
+	// Declare the variables for the transformations
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 0.0f;
+	float YrotationDegrees = 0.0f;
+	float ZrotationDegrees = 0.0f;
+	glm::vec3 positionXYZ;
+
 	// Create Cylinder - Jug Body
 	scaleXYZ = glm::vec3(2.5f, 5.0f, 2.5f); // Scale shape
 	XrotationDegrees = 180.0f; // Rotate Shape
@@ -823,7 +1598,8 @@ void SceneManager::RenderScene()
 	SetShaderColor(0.1, 0.1, 0.1, 1); //Set color
 	//SetShaderTexture("matte_rubber"); // Set texture
 	m_basicMeshes->DrawTorusMesh(); // Draw Shape
-//**************************************************************************************************************************************************
+}
+
 
 
 
@@ -831,6 +1607,16 @@ void SceneManager::RenderScene()
 //█ ▀█▀ █▀▀ █▀▄▀█  3  ▄▄   ▀█▀ █▀█ ▄▀█ █▀ █░█   █▀▀ ▄▀█ █▄░█
 //█ ░█░ ██▄ █░▀░█     ░░   ░█░ █▀▄ █▀█ ▄█ █▀█   █▄▄ █▀█ █░▀█
 //**********************************************************************************
+//RecordTrashCan() - used for recording the draws of the trash can
+void SceneManager::RecordTrashCan()
+{
+	// Declare the variables for the transformations
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 0.0f;
+	float YrotationDegrees = 0.0f;
+	float ZrotationDegrees = 0.0f;
+	glm::vec3 positionXYZ;
+
 	// Create Tapered Cylinder - Trash can body
 	scaleXYZ = glm::vec3(3.5f, 5.4f, 3.5f); // Scale shape
 	XrotationDegrees = 180.0f; // Rotate Shape
@@ -870,7 +1656,8 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("shiny"); // Set material
 	SetShaderColor(0.1, 0.1, 0.1, 1); //Set color
 	m_basicMeshes->DrawTorusMesh(); // Draw Shape
-//**************************************************************************************************************************************************
+}
+
 
 
 
@@ -878,6 +1665,16 @@ void SceneManager::RenderScene()
 //█ ▀█▀ █▀▀ █▀▄▀█   █░█   ▄▄   █▀ █▀▄▀█ ▄▀█ █░░ █░░   █░█░█ █▀▀ █ █▀▀ █░█ ▀█▀
 //█ ░█░ ██▄ █░▀░█   ▀▀█   ░░   ▄█ █░▀░█ █▀█ █▄▄ █▄▄   ▀▄▀▄▀ ██▄ █ █▄█ █▀█ ░█░
 //**********************************************************************************
+//RecordWeights() - used for recording the draws of the small weights
+void SceneManager::RecordWeights()
+{
+	// Declare the variables for the transformations
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 90.0f; // Rotation left by the trash can in the original scene
+	float YrotationDegrees = 0.0f;
+	float ZrotationDegrees = 0.0f;
+	glm::vec3 positionXYZ;
+
 	// Create Cylinder - Weight Handle Bar
 	scaleXYZ = glm::vec3(0.6f, 5.0f, 0.6f); // Scale shape
 	ZrotationDegrees = -90.0f; // Rotate Shape
@@ -944,7 +1741,8 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("dull"); // Set material
 	SetShaderTexture("pink_matte2"); // Set texture
 	m_basicMeshes->DrawPrismMesh(); // Draw Shape
-//**************************************************************************************************************************************************
+}
+
 
 
 
@@ -952,7 +1750,15 @@ void SceneManager::RenderScene()
 //█ ▀█▀ █▀▀ █▀▄▀█   █▀   ▄▄  3 █▀▄ █▀
 //█ ░█░ ██▄ █░▀░█   ▄█   ░░    █▄▀ ▄█
 //**********************************************************************************
-	
+//RecordConsole() - used for recording the draws of the 3DS console
+void SceneManager::RecordConsole()
+{
+	// Declare the variables for the transformations
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 180.0f; // Rotation left by the weights in the original scene
+	float YrotationDegrees = 0.0f;
+	float ZrotationDegrees = 90.0f; // Rotation left by the weights in the original scene
+	glm::vec3 positionXYZ;
 
 	//█▄▄ █▀█ ▀█▀ ▀█▀ █▀█ █▀▄▀█   █▀ █▀▀ █▀█ █▀▀ █▀▀ █▄░█
 	//█▄█ █▄█ ░█░ ░█░ █▄█ █░▀░█   ▄█ █▄▄ █▀▄ ██▄ ██▄ █░▀█
@@ -1121,19 +1927,25 @@ void SceneManager::RenderScene()
 	SetShaderColor(0.5, 0.5, 0.5, 1); //Set color
 	//SetShaderTexture("ruby9"); // Set texture
 	m_basicMeshes->DrawCylinderMesh(); // Draw Shape
-//**************************************************************************************************************************************************
-//**************************************************************************************************************************************************
-	
-
+}
 
 
 
 
-//**************************************************************************************************************************************************
 //**************************************************************************************************************************************************
 //█░░ █ █▀▀ █░█ ▀█▀   █▄▄ █▀█ ▀▄▀ █▀▀ █▀
 //█▄▄ █ █▄█ █▀█ ░█░   █▄█ █▄█ █░█ ██▄ ▄█
 //**********************************************************************************
+//RecordLightCubes() - used for recording the draws of the cubes that mark the light sources
+void SceneManager::RecordLightCubes()
+{
+	// Declare the variables for the transformations
+	glm::vec3 scaleXYZ;
+	float XrotationDegrees = 90.0f; // Rotation left by the console in the original scene
+	float YrotationDegrees = 90.0f; // Rotation left by the console in the original scene
+	float ZrotationDegrees = 90.0f; // Rotation left by the console in the original scene
+	glm::vec3 positionXYZ;
+
 // Visible color cubes tied to the light sources
 	glm::vec3 cubeColors[4] = {
 		glm::vec3(1.0f, 0.0f, 0.0f),  // Red
@@ -1151,15 +1963,54 @@ void SceneManager::RenderScene()
 		SetShaderColor(cubeColors[i].r, cubeColors[i].g, cubeColors[i].b, 1.0f); // Cube color
 		m_basicMeshes->DrawBoxMesh(); // Draw Light Cubes
 	}
-//**************************************************************************************************************************************************
-//**************************************************************************************************************************************************
-
+}
 
 
 
 
 //**************************************************************************************************************************************************
-//**************************************************************************************************************************************************
+//█▀ ▀█▀ █▀█ █▀▀ █▀ █▀   █▀ █▀▀ █▀▀ █▄░█ █▀▀
+//▄█ ░█░ █▀▄ ██▄ ▄█ ▄█   ▄█ █▄▄ ██▄ █░▀█ ██▄
+//**********************************************************************************
+//RecordStressScene() - used for recording the copies of the props laid out by SetStressScene()
+void SceneManager::RecordStressScene()
+{
+	// Floor stretched under the whole layout
+	m_instanceTransform = m_stressFloorTransform;
+	RecordFloor();
+
+	// The copies are sorted by prop, so each group is timed in one section
+	for (const STRESS_COPY& copy : m_stressCopies)
+	{
+		m_recordState.group = copy.prop; // Time the draws as the prop
+		m_instanceTransform = copy.transform; // Place the prop
+		m_materialShift = copy.materialShift; // Vary the prop materials
+
+		switch (copy.prop)
+		{
+		case GROUP_VASE:
+			RecordVase();
+			break;
+		case GROUP_JUG:
+			RecordJug();
+			break;
+		case GROUP_TRASH_CAN:
+			RecordTrashCan();
+			break;
+		case GROUP_WEIGHTS:
+			RecordWeights();
+			break;
+		default:
+			RecordConsole();
+			break;
+		}
+	}
+
+	// Light cubes stay where the lights are
+	m_instanceTransform = glm::mat4(1.0f);
+	m_materialShift = 0;
+	m_recordState.group = GROUP_LIGHT_CUBES; // Time the draws as the light cubes
+	RecordLightCubes();
 } //end
 //█▀▀ █▄░█ █▀▄   █▀ █▀▀ █▀▀ █▄░█ █▀▀   █▀▄▀█ ▄▀█ █▄░█ ▄▀█ █▀▀ █▀▀ █▀█
 //██▄ █░▀█ █▄▀   ▄█ █▄▄ ██▄ █░▀█ ██▄   █░▀░█ █▀█ █░▀█ █▀█ █▄█ ██▄ █▀▄
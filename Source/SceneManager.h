@@ -9,8 +9,13 @@
 
 #pragma once
 
-#include "ShaderManager.h"
-#include "ShapeMeshes.h"
+#include "TrackedShaderManager.h"
+#include "TrackedShapeMeshes.h"
+#include "GpuTimer.h"
+#include "SceneProgram.h"
+#include "TextureArrays.h"
+#include "TextureHandles.h"
+#include "TextureResidency.h"
 
 #include <string>
 #include <vector>
@@ -25,16 +30,10 @@ class SceneManager
 {
 public:
 	// constructor
-	SceneManager(ShaderManager *pShaderManager);
+	SceneManager(TrackedShaderManager *pShaderManager);
 	// destructor
 	~SceneManager();
 
-	struct TEXTURE_INFO
-	{
-		std::string tag;
-		uint32_t ID;
-	};
-
 	struct OBJECT_MATERIAL
 	{
 		float ambientStrength;
@@ -45,21 +44,129 @@ public:
 		std::string tag;
 	};
 
+	// object groups of RenderScene that are timed on the GPU, in draw order
+	enum RENDER_GROUP
+	{
+		GROUP_FLOOR,
+		GROUP_VASE,
+		GROUP_JUG,
+		GROUP_TRASH_CAN,
+		GROUP_WEIGHTS,
+		GROUP_CONSOLE,
+		GROUP_LIGHT_CUBES,
+		GROUP_COUNT
+	};
+
+	// how RenderScene sends the draw list to OpenGL
+	enum SUBMIT_MODE
+	{
+		// one course program draw call per draw item
+		SUBMIT_DRAWS,
+		// one instanced draw call per run of items sharing mesh and texture
+		SUBMIT_INSTANCED,
+		// the instanced runs as the commands of one multi-draw call
+		SUBMIT_INDIRECT,
+		// one course program draw call per world-space mesh merged from
+		// the draws sharing material, texture and color
+		SUBMIT_BAKED
+	};
+
+	// one recorded draw of the scene, PrepareScene builds the list once
+	struct DRAW_ITEM
+	{
+		glm::mat4 model;
+		// flat color, used when textureSlot is -1
+		glm::vec4 color;
+		glm::vec2 uvScale;
+		RenderStats::MESH_TYPE mesh;
+		// top, bottom and sides flags of cylinder meshes as bits 0..2
+		int variant;
+		// index into the object materials, -1 before the first material
+		int material;
+		int textureSlot;
+		// RENDER_GROUP the draw is timed in
+		int group;
+	};
+
 private:
+	// run of draw items that one instanced draw call covers
+	struct INSTANCE_BATCH
+	{
+		RenderStats::MESH_TYPE mesh;
+		int variant;
+		int group;
+		int firstInstance;
+		int instanceCount;
+	};
+
+	// merged draws that one baked mesh covers, with the shader state they share
+	struct BAKED_BATCH
+	{
+		int material;
+		int textureSlot;
+		glm::vec4 color;
+		int group;
+		int bakedMesh;
+	};
+
+	// copy of a prop in the stress scene, prop is its GROUP_VASE..GROUP_CONSOLE group
+	struct STRESS_COPY
+	{
+		glm::mat4 transform;
+		int prop;
+		int materialShift;
+	};
+
 //*******************************************************************************************************************************************************************************
 	glm::vec3 lightPositions[4];  // Stores Light Positions for color cubes
 //*******************************************************************************************************************************************************************************
 	
 	// pointer to shader manager object
-	ShaderManager* m_pShaderManager;
+	TrackedShaderManager* m_pShaderManager;
 	// pointer to basic shapes object
-	ShapeMeshes* m_basicMeshes;
-	// total number of loaded textures
-	int m_loadedTextures;
-	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
+	TrackedShapeMeshes* m_basicMeshes;
+	// loaded textures, indexed by texture slot, loaded in the background
+	// and kept inside the texture memory budget
+	TextureResidency m_textures;
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// GPU timestamps at the object group boundaries of RenderScene
+	GpuTimer m_groupTimer;
+	// finished group timings not yet collected, and the newest one
+	std::vector<GPU_TIMING> m_groupTimings;
+	GPU_TIMING m_lastGroupTiming;
+	// number of RenderScene calls, used as the timing frame index
+	int m_renderedFrames;
+	// prop copies drawn in place of the scene, empty for the normal scene
+	std::vector<STRESS_COPY> m_stressCopies;
+	glm::mat4 m_stressFloorTransform;
+	// placement applied on top of every SetTransformations call
+	glm::mat4 m_instanceTransform;
+	// number of lit materials each SetShaderMaterial call moves ahead
+	int m_materialShift;
+	// draws RenderScene walks every frame, and the draw being recorded
+	std::vector<DRAW_ITEM> m_drawItems;
+	DRAW_ITEM m_recordState;
+	// sort keys of the draw list in submission order, the low 32 bits index m_drawItems
+	std::vector<uint64_t> m_drawOrder;
+	// true to submit the draws sorted by shader state instead of authoring order
+	bool m_bSortDraws;
+	// UV scale last set into the shader
+	glm::vec2 m_uploadedUVScale;
+	// submission mode, and the program and batches of the instanced and indirect modes
+	SUBMIT_MODE m_submitMode;
+	SceneProgram m_sceneProgram;
+	std::vector<INSTANCE_BATCH> m_instanceBatches;
+	// the textures as array layers or bindless handles, sampled by the program of the instanced and indirect modes
+	TextureArrays m_textureArrays;
+	TextureHandles m_textureHandles;
+	// false to always sample the texture arrays
+	bool m_bAllowBindless;
+	// OBJECT_DATA of every draw item, uploaded again after the draw list changed
+	GLuint m_objectTableBuffer;
+	bool m_bObjectTableDirty;
+	// merged meshes of the baked mode
+	std::vector<BAKED_BATCH> m_bakedBatches;
 
 	// load texture images and convert to OpenGL texture data
 	bool CreateGLTexture(const char* filename, std::string tag);
@@ -72,9 +179,42 @@ private:
 	int FindTextureSlot(std::string tag);
 	// find a defined material by tag
 	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	int FindMaterialIndex(std::string tag);
+	// swap a material index for the one m_materialShift lit materials later
+	int ShiftMaterial(int material) const;
+
+	// record the draws of the scene into the draw list
+	void BuildDrawList();
+	// order the draw list by shader state
+	void SortDrawList();
+	// group the draw list into instanced draws and upload the instances
+	void BuildInstanceBatches();
+	// upload the per-object values of the draw list into the object table
+	void UploadObjectTable();
+	// merge the draw list into world-space meshes, false when they are too large
+	bool BuildBakedBatches();
+	// upload the material, texture and color of a draw when they changed
+	void SetDrawState(int material, int textureSlot, const glm::vec4& color,
+		int& currentMaterial, int& currentTexture, glm::vec4& currentColor);
+	// submit the draw list as instanced draws with the scene program
+	void RenderInstanced();
+	// submit the draw list as multi-draw calls, one per timed group or one for the frame
+	void RenderIndirect();
+	// submit the baked meshes with the course program
+	void RenderBaked();
+	// record the object groups of the scene
+	void RecordFloor();
+	void RecordVase();
+	void RecordJug();
+	void RecordTrashCan();
+	void RecordWeights();
+	void RecordConsole();
+	void RecordLightCubes();
+	// record the prop copies of the stress scene
+	void RecordStressScene();
 	
 	// set the transformation values 
-	// into the transform buffer
+	// of the next recorded draw
 	void SetTransformations(
 		glm::vec3 scaleXYZ,
 		float XrotationDegrees,
@@ -82,22 +222,22 @@ private:
 		float ZrotationDegrees,
 		glm::vec3 positionXYZ);
 
-	// set the color values into the shader
+	// set the color values of the next recorded draw
 	void SetShaderColor(
 		float redColorValue,
 		float greenColorValue,
 		float blueColorValue,
 		float alphaValue);
 
-	// set the texture data into the shader
+	// set the texture of the next recorded draw
 	void SetShaderTexture(
 		std::string textureTag);
 
-	// set the UV scale for the texture mapping
+	// set the UV scale for the texture mapping of the next recorded draw
 	void SetTextureUVScale(
 		float u, float v);
 
-	// set the object material into the shader
+	// set the object material of the next recorded draw
 	void SetShaderMaterial(
 		std::string materialTag);
 
@@ -108,6 +248,37 @@ public:
 	void LoadSceneTextures(); // Load Textures
 	void DefineObjectMaterials(); // Set Materials
 	void SetupSceneLights(); //Set Lights
+
+	// time the GPU work of each object group in RenderScene
+	bool EnableGroupTiming(bool bEnable);
+	// move out the finished group timings, bWait also waits for the frames in flight
+	void CollectGroupTimings(std::vector<GPU_TIMING>& timings, bool bWait);
+	// get the newest finished group timing, empty sections before the first
+	const GPU_TIMING& GetLastGroupTiming() const { return m_lastGroupTiming; }
+	// get the display name of an object group
+	static const char* GetGroupName(int group);
+	// draw copies of the props on a grid or at random, 0 draws the normal scene
+	void SetStressScene(int copies, bool bRandomLayout);
+	// submit the draws sorted by shader state, false keeps the authoring order
+	void SetSortedSubmission(bool bSorted);
+	// choose how the draw list is submitted, false when the mode is not supported
+	bool SetSubmissionMode(SUBMIT_MODE submitMode);
+	// upload the textures block compressed where supported, call before PrepareScene
+	void SetTextureCompression(bool bCompress) { m_textures.SetCompression(bCompress); }
+	// bytes of texture memory the scene textures may take, 0 for no limit
+	void SetTextureBudget(size_t budgetBytes) { m_textures.SetBudget(budgetBytes); }
+	// sample bindless texture handles where supported, call before SetSubmissionMode
+	void SetBindlessTextures(bool bAllow) { m_bAllowBindless = bAllow; }
+	// wait until every texture image is uploaded, so no placeholder gets drawn
+	void FinishTextureLoads() { m_textures.Finish(); }
+	// true while texture images are still being decoded or uploaded
+	bool IsLoadingTextures() const { return m_textures.GetPendingCount() > 0; }
+	// draw the meshes with the software rasterizer, NULL draws with OpenGL again
+	void SetSoftwareRasterizer(SoftwareRasterizer* pRasterizer)
+	{
+		m_basicMeshes->SetSoftwareRasterizer(pRasterizer);
+		m_textures.SetSoftwareRasterizer(pRasterizer);
+	}
 };
 //*******************************************************************************************************************************************************************************
 //*******************************************************************************************************************************************************************************
\ No newline at end of file
@@ -0,0 +1,321 @@
+///////////////////////////////////////////////////////////////////////////////
+// sceneprogram.cpp
+// ============
+// shader programs of the scene that are built into the application
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneProgram.h"
+#include "RenderStats.h"
+#include "StateCache.h"
+#include "UniformBlocks.h"
+
+#include <cstdio>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// the object index of an instance follows the three ShapeMeshes vertex
+	// attributes and picks its values, texture slot included, out of the
+	// object table
+	const char* g_SceneVertexShader =
+		"layout (location = 0) in vec3 inVertexPosition;\n"
+		"layout (location = 1) in vec3 inVertexNormal;\n"
+		"layout (location = 2) in vec2 inTextureCoordinate;\n"
+		"layout (location = 3) in uint instanceObject;\n"
+		"struct ObjectData\n"
+		"{\n"
+		"	mat4 model;\n"
+		"	vec4 color;\n"
+		"	vec2 uvScale;\n"
+		"	int material;\n"
+		"	int texture;\n"
+		"};\n"
+		"layout (std430, binding = 1) readonly buffer ObjectTable\n"
+		"{\n"
+		"	ObjectData objects[];\n"
+		"};\n"
+		"out vec3 fragmentPosition;\n"
+		"out vec3 fragmentVertexNormal;\n"
+		"out vec2 fragmentTextureCoordinate;\n"
+		"flat out vec4 fragmentObjectColor;\n"
+		"flat out int fragmentMaterial;\n"
+		"flat out int fragmentTexture;\n"
+		"void main()\n"
+		"{\n"
+		"	ObjectData object = objects[instanceObject];\n"
+		"	vec4 worldPosition = object.model * vec4(inVertexPosition, 1.0);\n"
+		"	gl_Position = projection * view * worldPosition;\n"
+		"	fragmentPosition = vec3(worldPosition);\n"
+		"	fragmentVertexNormal = mat3(transpose(inverse(object.model))) * inVertexNormal;\n"
+		"	fragmentTextureCoordinate = inTextureCoordinate * object.uvScale;\n"
+		"	fragmentObjectColor = object.color;\n"
+		"	fragmentMaterial = object.material;\n"
+		"	fragmentTexture = object.texture;\n"
+		"}\n";
+
+	// the lighting of the course fragmentShader.glsl, with the
+	// material picked from a table instead of set per draw, the
+	// lights read from the light block and the texture sampled from
+	// the array and layer the layer table gives for its slot. Objects
+	// of one draw can use different arrays, so the derivatives are
+	// taken before branching on the array. With BINDLESS set the
+	// slot picks a texture handle out of the handle table instead
+	const char* g_SceneFragmentShader =
+		"#define TOTAL_LIGHTS 5\n"
+		"#define TOTAL_MATERIALS 16\n"
+		"#define TOTAL_TEXTURE_ARRAYS 4\n"
+		"struct Material\n"
+		"{\n"
+		"	vec3 ambientColor;\n"
+		"	float ambientStrength;\n"
+		"	vec3 diffuseColor;\n"
+		"	vec3 specularColor;\n"
+		"};\n"
+		"in vec3 fragmentPosition;\n"
+		"in vec3 fragmentVertexNormal;\n"
+		"in vec2 fragmentTextureCoordinate;\n"
+		"flat in vec4 fragmentObjectColor;\n"
+		"flat in int fragmentMaterial;\n"
+		"flat in int fragmentTexture;\n"
+		"out vec4 outFragmentColor;\n"
+		"#ifdef BINDLESS\n"
+		"layout (std430, binding = 0) readonly buffer HandleTable\n"
+		"{\n"
+		"	uvec2 textureHandles[];\n"
+		"};\n"
+		"#else\n"
+		"layout (std430, binding = 0) readonly buffer LayerTable\n"
+		"{\n"
+		"	ivec2 textureLayers[];\n"
+		"};\n"
+		"uniform sampler2DArray textureArrays[TOTAL_TEXTURE_ARRAYS];\n"
+		"#endif\n"
+		"uniform Material materials[TOTAL_MATERIALS];\n"
+		"vec4 SampleTexture(int slot, vec2 dx, vec2 dy)\n"
+		"{\n"
+		"#ifdef BINDLESS\n"
+		"	return textureGrad(sampler2D(textureHandles[slot]), fragmentTextureCoordinate, dx, dy);\n"
+		"#else\n"
+		"	ivec2 layer = textureLayers[slot];\n"
+		"	vec3 coordinate = vec3(fragmentTextureCoordinate, float(layer.y));\n"
+		"	switch (layer.x)\n"
+		"	{\n"
+		"	case 0: return textureGrad(textureArrays[0], coordinate, dx, dy);\n"
+		"	case 1: return textureGrad(textureArrays[1], coordinate, dx, dy);\n"
+		"	case 2: return textureGrad(textureArrays[2], coordinate, dx, dy);\n"
+		"	case 3: return textureGrad(textureArrays[3], coordinate, dx, dy);\n"
+		"	}\n"
+		"	return fragmentObjectColor;\n"
+		"#endif\n"
+		"}\n"
+		"void main()\n"
+		"{\n"
+		"	vec2 dx = dFdx(fragmentTextureCoordinate);\n"
+		"	vec2 dy = dFdy(fragmentTextureCoordinate);\n"
+		"	vec4 objectColor = fragmentObjectColor;\n"
+		"	bool bTextured = (fragmentTexture >= 0);\n"
+		"	if (bTextured)\n"
+		"	{\n"
+		"		objectColor = SampleTexture(fragmentTexture, dx, dy);\n"
+		"	}\n"
+		"	if (!bUseLighting)\n"
+		"	{\n"
+		"		outFragmentColor = objectColor;\n"
+		"		return;\n"
+		"	}\n"
+		"	Material material = materials[clamp(fragmentMaterial, 0, TOTAL_MATERIALS - 1)];\n"
+		"	vec3 lightNormal = normalize(fragmentVertexNormal);\n"
+		"	vec3 viewDirection = normalize(viewPosition.xyz - fragmentPosition);\n"
+		"	vec3 phongResult = vec3(0.0);\n"
+		"	for (int i = 0; i < TOTAL_LIGHTS; i++)\n"
+		"	{\n"
+		"		vec3 lightDirection = normalize(lightSources[i].position - fragmentPosition);\n"
+		"		float impact = max(dot(lightNormal, lightDirection), 0.0);\n"
+		"		vec3 reflectDirection = reflect(-lightDirection, lightNormal);\n"
+		"		float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0), lightSources[i].focalStrength);\n"
+		"		phongResult += material.ambientStrength * material.ambientColor + lightSources[i].ambientColor;\n"
+		"		phongResult += impact * lightSources[i].diffuseColor * material.diffuseColor;\n"
+		"		phongResult += lightSources[i].specularIntensity * specularComponent *\n"
+		"			material.specularColor * lightSources[i].specularColor;\n"
+		"	}\n"
+		"	if (bTextured)\n"
+		"	{\n"
+		"		outFragmentColor = vec4(phongResult * objectColor.rgb, 1.0);\n"
+		"	}\n"
+		"	else\n"
+		"	{\n"
+		"		outFragmentColor = vec4(phongResult * objectColor.rgb, objectColor.a);\n"
+		"	}\n"
+		"}\n";
+
+	// version lines of the program, storage buffers are core in 4.3
+	const char* g_SceneHeader =
+		"#version 430 core\n";
+	const char* g_BindlessHeader =
+		"#version 430 core\n"
+		"#extension GL_ARB_bindless_texture : require\n"
+		"#define BINDLESS\n";
+
+	// compile one stage from its version lines, the uniform blocks and
+	// its body, 0 when it does not compile
+	GLuint CompileShader(GLenum stage, const char* header, const char* body)
+	{
+		const char* sources[] = { header, UniformBlocks::GetBlockSource(), body };
+		GLuint shader = glCreateShader(stage);
+		glShaderSource(shader, 3, sources, NULL);
+		glCompileShader(shader);
+
+		GLint compiled = GL_FALSE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+		if (compiled == GL_FALSE)
+		{
+			char log[1024];
+			glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+			std::cout << "Could not compile the scene program: " << log << std::endl;
+			glDeleteShader(shader);
+			return 0;
+		}
+		return shader;
+	}
+}
+
+/***********************************************************
+ *  SceneProgram()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneProgram::SceneProgram()
+{
+	m_programID = 0;
+}
+
+/***********************************************************
+ *  ~SceneProgram()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneProgram::~SceneProgram()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for compiling and linking the
+ *  program, sampling texture handles or texture arrays, and
+ *  for pointing its camera and light blocks at the shared
+ *  buffers and its texture arrays at their units.
+ ***********************************************************/
+bool SceneProgram::Create(bool bBindless)
+{
+	Destroy();
+
+	const char* header = (bBindless == true) ? g_BindlessHeader : g_SceneHeader;
+	GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, header, g_SceneVertexShader);
+	GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, header, g_SceneFragmentShader);
+	if ((vertexShader == 0) || (fragmentShader == 0))
+	{
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+		return false;
+	}
+
+	m_programID = glCreateProgram();
+	glAttachShader(m_programID, vertexShader);
+	glAttachShader(m_programID, fragmentShader);
+	glLinkProgram(m_programID);
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(m_programID, GL_LINK_STATUS, &linked);
+	if (linked == GL_FALSE)
+	{
+		char log[1024];
+		glGetProgramInfoLog(m_programID, sizeof(log), NULL, log);
+		std::cout << "Could not link the scene program: " << log << std::endl;
+		Destroy();
+		return false;
+	}
+
+	// the blocks keep their binding for the life of the program
+	UniformBlocks::BindProgramBlocks(m_programID);
+
+	// texture array N is sampled from texture unit N
+	for (int index = 0; (index < TOTAL_TEXTURE_ARRAYS) && (bBindless == false); index++)
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "textureArrays[%d]", index);
+		glProgramUniform1i(m_programID, GetLocation(name), index);
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the program.
+ ***********************************************************/
+void SceneProgram::Destroy()
+{
+	if (m_programID != 0)
+	{
+		glDeleteProgram(m_programID);
+		m_programID = 0;
+	}
+	m_locations.clear();
+}
+
+/***********************************************************
+ *  Use()
+ *
+ *  This method is used for making the program current. The
+ *  program that was current is returned so the caller can
+ *  switch back to it.
+ ***********************************************************/
+GLuint SceneProgram::Use()
+{
+	GLuint previousProgram = StateCache::GetProgram();
+	StateCache::UseProgram(m_programID);
+	return previousProgram;
+}
+
+/***********************************************************
+ *  GetLocation()
+ *
+ *  This method is used for finding the location of a
+ *  uniform. Every name is only looked up in OpenGL once.
+ ***********************************************************/
+GLint SceneProgram::GetLocation(const UNIFORM_NAME& name)
+{
+	std::unordered_map<uint64_t, GLint>::const_iterator found = m_locations.find(name.hash);
+	if (found != m_locations.end())
+	{
+		return found->second;
+	}
+
+	GLint location = glGetUniformLocation(m_programID, name.name);
+	m_locations.emplace(name.hash, location);
+	return location;
+}
+
+void SceneProgram::SetInt(GLint location, int value)
+{
+	RenderStats::CountUniformUpload(false);
+	glUniform1i(location, value);
+}
+
+void SceneProgram::SetFloat(GLint location, float value)
+{
+	RenderStats::CountUniformUpload(false);
+	glUniform1f(location, value);
+}
+
+void SceneProgram::SetVec3(GLint location, const glm::vec3& value)
+{
+	RenderStats::CountUniformUpload(false);
+	glUniform3fv(location, 1, &value[0]);
+}
@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////////////
+// sceneprogram.h
+// ============
+// shader programs of the scene that are built into the application
+//
+//  The course shaders in Utilities/shaders draw one object per draw call,
+//  with its transform, color and material in plain uniforms. The program
+//  here lights the scene the same way, but takes the per-object values from
+//  a storage buffer indexed per instance, so one draw call can cover many
+//  objects, and one multi-draw call can cover many meshes. Each object
+//  names its texture slot, which the layer table of TextureArrays turns
+//  into an array and layer, or the handle table of TextureHandles into a
+//  bindless texture. The camera and the lights come from the shared
+//  UniformBlocks buffers.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "TrackedShaderManager.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+
+class SceneProgram
+{
+public:
+	// materials the program can index
+	static const int TOTAL_MATERIALS = 16;
+	// texture arrays the program can sample, array N on texture unit N
+	static const int TOTAL_TEXTURE_ARRAYS = 4;
+	// storage buffer binding of the texture table, the array and layer
+	// or the bindless handle of each texture slot
+	static const GLuint TEXTURE_TABLE_BINDING = 0;
+	// storage buffer binding of the object table
+	static const GLuint OBJECT_TABLE_BINDING = 1;
+
+	// one object of the object table, laid out as std430 stores ObjectData
+	struct OBJECT_DATA
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+		glm::vec2 uvScale;
+		GLint material;
+		// texture slot, -1 for flat color
+		GLint texture;
+	};
+
+	// constructor
+	SceneProgram();
+	// destructor
+	~SceneProgram();
+
+	// compile and link the program, bBindless samples texture handles
+	// instead of texture arrays
+	bool Create(bool bBindless);
+	// free the program
+	void Destroy();
+	// true between Create() and Destroy()
+	bool IsCreated() const { return m_programID != 0; }
+
+	// make the program current, returns the program that was current
+	GLuint Use();
+	// find a uniform location once, -1 when the program has no such uniform
+	GLint GetLocation(const UNIFORM_NAME& name);
+
+	// upload a value into a uniform location of the current program
+	void SetInt(GLint location, int value);
+	void SetFloat(GLint location, float value);
+	void SetVec3(GLint location, const glm::vec3& value);
+
+private:
+	GLuint m_programID;
+	// locations looked up so far, by name hash
+	std::unordered_map<uint64_t, GLint> m_locations;
+};
@@ -0,0 +1,252 @@
+///////////////////////////////////////////////////////////////////////////////
+// statecache.cpp
+// ============
+// shadow copy of the OpenGL state the scene changes, to drop redundant calls
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StateCache.h"
+#include "RenderStats.h"
+
+#include <array>
+#include <utility>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// marks a value OpenGL was never asked to set through the cache
+	const GLint UNKNOWN = -1;
+
+	// texture bound on each tracked unit
+	typedef std::array<GLint, StateCache::TRACKED_TEXTURE_UNITS> UNIT_BINDINGS;
+
+	// bindings of every tracked unit set to UNKNOWN
+	UNIT_BINDINGS UnknownBindings()
+	{
+		UNIT_BINDINGS bindings;
+		bindings.fill(UNKNOWN);
+		return bindings;
+	}
+
+	GLint g_Program = UNKNOWN;
+	GLint g_ActiveUnit = UNKNOWN;
+	// unknown from the start as well, the textures may be bound by
+	// other code before the first Reset()
+	UNIT_BINDINGS g_UnitTextures = UnknownBindings();
+	UNIT_BINDINGS g_UnitTextureArrays = UnknownBindings();
+	// capabilities and whether they are enabled, a handful at most
+	std::vector<std::pair<GLenum, bool>> g_Capabilities;
+	bool g_bClearColorKnown = false;
+	glm::vec4 g_ClearColor;
+
+	// true, after counting it, when the state already holds the value
+	bool SkipChange(bool bUnchanged)
+	{
+		RenderStats::CountStateChange(bUnchanged);
+		return bUnchanged;
+	}
+
+	// find the shadow flag of a capability, added as unknown on first use
+	std::pair<GLenum, bool>* FindCapability(GLenum capability, bool& bKnown)
+	{
+		for (std::pair<GLenum, bool>& entry : g_Capabilities)
+		{
+			if (entry.first == capability)
+			{
+				bKnown = true;
+				return &entry;
+			}
+		}
+		g_Capabilities.push_back(std::make_pair(capability, false));
+		bKnown = false;
+		return &g_Capabilities.back();
+	}
+
+	void SetCapability(GLenum capability, bool bEnable)
+	{
+		bool bKnown = false;
+		std::pair<GLenum, bool>* entry = FindCapability(capability, bKnown);
+		if (SkipChange(bKnown && (entry->second == bEnable)))
+		{
+			return;
+		}
+
+		if (bEnable)
+		{
+			glEnable(capability);
+		}
+		else
+		{
+			glDisable(capability);
+		}
+		entry->second = bEnable;
+	}
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This function is used for forgetting the shadow state,
+ *  so the next call of every kind is passed on to OpenGL.
+ ***********************************************************/
+void StateCache::Reset()
+{
+	g_Program = UNKNOWN;
+	g_ActiveUnit = UNKNOWN;
+	g_UnitTextures = UnknownBindings();
+	g_UnitTextureArrays = UnknownBindings();
+	g_Capabilities.clear();
+	g_bClearColorKnown = false;
+}
+
+/***********************************************************
+ *  UseProgram()
+ *
+ *  This function is used for making the passed in program
+ *  current, unless it already is.
+ ***********************************************************/
+void StateCache::UseProgram(GLuint program)
+{
+	if (SkipChange(g_Program == static_cast<GLint>(program)))
+	{
+		return;
+	}
+	glUseProgram(program);
+	g_Program = static_cast<GLint>(program);
+}
+
+/***********************************************************
+ *  GetProgram()
+ *
+ *  This function is used for getting the current program.
+ *  OpenGL is only asked while the program is unknown.
+ ***********************************************************/
+GLuint StateCache::GetProgram()
+{
+	if (g_Program == UNKNOWN)
+	{
+		glGetIntegerv(GL_CURRENT_PROGRAM, &g_Program);
+	}
+	return static_cast<GLuint>(g_Program);
+}
+
+/***********************************************************
+ *  ActiveTexture()
+ *
+ *  This function is used for switching the texture unit
+ *  the following binds go to.
+ ***********************************************************/
+void StateCache::ActiveTexture(GLuint unit)
+{
+	if (SkipChange(g_ActiveUnit == static_cast<GLint>(unit)))
+	{
+		return;
+	}
+	glActiveTexture(GL_TEXTURE0 + unit);
+	RenderStats::CountActiveTexture();
+	g_ActiveUnit = static_cast<GLint>(unit);
+}
+
+/***********************************************************
+ *  BindTexture2D()
+ *
+ *  This function is used for binding a 2D texture on the
+ *  active texture unit, unless it is already bound there.
+ ***********************************************************/
+void StateCache::BindTexture2D(GLuint texture)
+{
+	bool bTracked = (g_ActiveUnit >= 0) && (g_ActiveUnit < TRACKED_TEXTURE_UNITS);
+	if (SkipChange(bTracked && (g_UnitTextures[g_ActiveUnit] == static_cast<GLint>(texture))))
+	{
+		return;
+	}
+	glBindTexture(GL_TEXTURE_2D, texture);
+	RenderStats::CountTextureBind();
+	if (bTracked)
+	{
+		g_UnitTextures[g_ActiveUnit] = static_cast<GLint>(texture);
+	}
+}
+
+/***********************************************************
+ *  BindTextureArray()
+ *
+ *  This function is used for binding a 2D array texture on
+ *  the active texture unit, unless it is already bound
+ *  there. The unit keeps its 2D binding next to it.
+ ***********************************************************/
+void StateCache::BindTextureArray(GLuint texture)
+{
+	bool bTracked = (g_ActiveUnit >= 0) && (g_ActiveUnit < TRACKED_TEXTURE_UNITS);
+	if (SkipChange(bTracked && (g_UnitTextureArrays[g_ActiveUnit] == static_cast<GLint>(texture))))
+	{
+		return;
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	RenderStats::CountTextureBind();
+	if (bTracked)
+	{
+		g_UnitTextureArrays[g_ActiveUnit] = static_cast<GLint>(texture);
+	}
+}
+
+/***********************************************************
+ *  ForgetTexture()
+ *
+ *  This function is used for dropping a deleted texture
+ *  from the units it was bound to. OpenGL unbinds it, and
+ *  the name may come back for a new texture.
+ ***********************************************************/
+void StateCache::ForgetTexture(GLuint texture)
+{
+	for (int unit = 0; unit < TRACKED_TEXTURE_UNITS; unit++)
+	{
+		if (g_UnitTextures[unit] == static_cast<GLint>(texture))
+		{
+			g_UnitTextures[unit] = 0;
+		}
+		if (g_UnitTextureArrays[unit] == static_cast<GLint>(texture))
+		{
+			g_UnitTextureArrays[unit] = 0;
+		}
+	}
+}
+
+/***********************************************************
+ *  Enable()
+ *
+ *  This function is used for enabling an OpenGL capability,
+ *  unless it is already known to be enabled.
+ ***********************************************************/
+void StateCache::Enable(GLenum capability)
+{
+	SetCapability(capability, true);
+}
+
+/***********************************************************
+ *  Disable()
+ *
+ *  This function is used for disabling an OpenGL capability,
+ *  unless it is already known to be disabled.
+ ***********************************************************/
+void StateCache::Disable(GLenum capability)
+{
+	SetCapability(capability, false);
+}
+
+/***********************************************************
+ *  ClearColor()
+ *
+ *  This function is used for setting the color glClear
+ *  fills the color buffer with, unless it is already set.
+ ***********************************************************/
+void StateCache::ClearColor(const glm::vec4& color)
+{
+	if (SkipChange(g_bClearColorKnown && (g_ClearColor == color)))
+	{
+		return;
+	}
+	glClearColor(color.r, color.g, color.b, color.a);
+	g_ClearColor = color;
+	g_bClearColorKnown = true;
+}
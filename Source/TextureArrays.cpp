@@ -0,0 +1,382 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearrays.cpp
+// ============
+// pack the scene textures into layers of a few 2D array textures
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureArrays.h"
+#include "StateCache.h"
+#include "TextureCompressor.h"
+#include "TextureLoader.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// declaration of global variables and helper functions
+namespace
+{
+	// layers an array may hold when OpenGL does not say, the 3.0 minimum
+	const GLint DEFAULT_ARRAY_LAYERS = 256;
+
+	// size, format and compression of a texture, read from OpenGL
+	struct SOURCE_TEXTURE
+	{
+		GLint internalFormat;
+		GLint width;
+		GLint height;
+		GLint bCompressed;
+	};
+
+	// resize RGBA pixels with bilinear filtering, the edges are clamped
+	void Resample(const std::vector<unsigned char>& source, int width, int height,
+		std::vector<unsigned char>& destination, int newWidth, int newHeight)
+	{
+		destination.resize(static_cast<size_t>(newWidth) * newHeight * 4);
+		for (int y = 0; y < newHeight; y++)
+		{
+			float sourceY = std::max((y + 0.5f) * height / newHeight - 0.5f, 0.0f);
+			int y0 = std::min(static_cast<int>(sourceY), height - 1);
+			int y1 = std::min(y0 + 1, height - 1);
+			float fractionY = sourceY - y0;
+			for (int x = 0; x < newWidth; x++)
+			{
+				float sourceX = std::max((x + 0.5f) * width / newWidth - 0.5f, 0.0f);
+				int x0 = std::min(static_cast<int>(sourceX), width - 1);
+				int x1 = std::min(x0 + 1, width - 1);
+				float fractionX = sourceX - x0;
+				for (int c = 0; c < 4; c++)
+				{
+					float top = source[(static_cast<size_t>(y0) * width + x0) * 4 + c] * (1.0f - fractionX) +
+						source[(static_cast<size_t>(y0) * width + x1) * 4 + c] * fractionX;
+					float bottom = source[(static_cast<size_t>(y1) * width + x0) * 4 + c] * (1.0f - fractionX) +
+						source[(static_cast<size_t>(y1) * width + x1) * 4 + c] * fractionX;
+					destination[(static_cast<size_t>(y) * newWidth + x) * 4 + c] =
+						static_cast<unsigned char>(top * (1.0f - fractionY) + bottom * fractionY + 0.5f);
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  TextureArrays()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureArrays::TextureArrays()
+{
+	m_layerTableBuffer = 0;
+	m_bytes = 0;
+}
+
+/***********************************************************
+ *  ~TextureArrays()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureArrays::~TextureArrays()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for packing the passed in textures
+ *  into array textures, one or more per texture format.
+ *  Each array takes the size most of its textures share,
+ *  textures of that size are copied on the GPU and the rest
+ *  are resampled on the CPU. Uncompressed arrays get their
+ *  mipmaps generated, compressed layers bring their own.
+ *  The array and layer of each texture slot are uploaded
+ *  into the layer table, two ints per slot. The textures
+ *  have to be fully loaded, they are read, not referenced.
+ ***********************************************************/
+bool TextureArrays::Build(const std::vector<GLuint>& textures, int maxArrays)
+{
+	TRACE_ZONE("BuildTextureArrays");
+	Destroy();
+
+	std::vector<SOURCE_TEXTURE> sources(textures.size());
+	StateCache::ActiveTexture(TextureLoader::UPLOAD_TEXTURE_UNIT);
+	for (size_t slot = 0; slot < textures.size(); slot++)
+	{
+		StateCache::BindTexture2D(textures[slot]);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &sources[slot].internalFormat);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &sources[slot].width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &sources[slot].height);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &sources[slot].bCompressed);
+	}
+
+	GLint maxLayers = DEFAULT_ARRAY_LAYERS;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+
+	// the formats in the order the slots first use them
+	std::vector<GLint> formats;
+	for (const SOURCE_TEXTURE& source : sources)
+	{
+		if (std::find(formats.begin(), formats.end(), source.internalFormat) == formats.end())
+		{
+			formats.push_back(source.internalFormat);
+		}
+	}
+
+	std::vector<GLint> layerTable(textures.size() * 2, -1);
+	for (GLint format : formats)
+	{
+		std::vector<int> slots;
+		for (size_t slot = 0; slot < sources.size(); slot++)
+		{
+			if (sources[slot].internalFormat == format)
+			{
+				slots.push_back(static_cast<int>(slot));
+			}
+		}
+
+		// the size most of the textures share, the larger one on a tie
+		int width = 0;
+		int height = 0;
+		int bestCount = 0;
+		for (int slot : slots)
+		{
+			int count = 0;
+			for (int other : slots)
+			{
+				if ((sources[other].width == sources[slot].width) && (sources[other].height == sources[slot].height))
+				{
+					count++;
+				}
+			}
+			if ((count > bestCount) ||
+				((count == bestCount) && (sources[slot].width * sources[slot].height > width * height)))
+			{
+				bestCount = count;
+				width = sources[slot].width;
+				height = sources[slot].height;
+			}
+		}
+
+		for (size_t first = 0; first < slots.size(); first += static_cast<size_t>(maxLayers))
+		{
+			if (static_cast<int>(m_arrays.size()) >= maxArrays)
+			{
+				std::cout << "The scene textures need more than " << maxArrays << " texture arrays" << std::endl;
+				Destroy();
+				return false;
+			}
+
+			TEXTURE_ARRAY textureArray;
+			textureArray.internalFormat = static_cast<GLenum>(format);
+			textureArray.width = width;
+			textureArray.height = height;
+			textureArray.levels = static_cast<int>(std::floor(std::log2(std::max(width, height)))) + 1;
+			textureArray.layers = static_cast<int>(std::min(slots.size() - first, static_cast<size_t>(maxLayers)));
+			glGenTextures(1, &textureArray.texture);
+			StateCache::BindTextureArray(textureArray.texture);
+			glTexStorage3D(GL_TEXTURE_2D_ARRAY, textureArray.levels, textureArray.internalFormat,
+				width, height, textureArray.layers);
+			// the same wrapping and filtering as the scene textures
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			m_arrays.push_back(textureArray);
+
+			bool bCompressed = (sources[slots[first]].bCompressed == GL_TRUE);
+			for (int layer = 0; layer < textureArray.layers; layer++)
+			{
+				int slot = slots[first + layer];
+				if ((sources[slot].width == width) && (sources[slot].height == height))
+				{
+					CopyLayer(textures[slot], textureArray, layer);
+				}
+				else if (ResampleLayer(textures[slot], textureArray, layer) == false)
+				{
+					std::cout << "Could not resample texture slot " << slot << " into a texture array" << std::endl;
+					Destroy();
+					return false;
+				}
+				layerTable[slot * 2] = static_cast<GLint>(m_arrays.size()) - 1;
+				layerTable[slot * 2 + 1] = layer;
+			}
+
+			if (bCompressed == false)
+			{
+				StateCache::BindTextureArray(textureArray.texture);
+				glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+			}
+		}
+	}
+
+	// an empty storage buffer cannot be bound, so there is always one entry
+	if (layerTable.empty() == true)
+	{
+		layerTable.assign(2, -1);
+	}
+	glGenBuffers(1, &m_layerTableBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_layerTableBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, layerTable.size() * sizeof(GLint), layerTable.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	for (const TEXTURE_ARRAY& textureArray : m_arrays)
+	{
+		m_bytes += MeasureArray(textureArray);
+	}
+	std::cout << "INFO: Packed " << textures.size() << " textures into " << m_arrays.size() << " texture arrays, "
+		<< (m_bytes >> 20) << " MB" << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the arrays and the
+ *  layer table.
+ ***********************************************************/
+void TextureArrays::Destroy()
+{
+	for (TEXTURE_ARRAY& textureArray : m_arrays)
+	{
+		StateCache::ForgetTexture(textureArray.texture);
+		glDeleteTextures(1, &textureArray.texture);
+	}
+	m_arrays.clear();
+	m_bytes = 0;
+
+	if (m_layerTableBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_layerTableBuffer);
+		m_layerTableBuffer = 0;
+	}
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for binding array N on texture unit
+ *  N. Once bound the calls of the next frames are skipped.
+ ***********************************************************/
+void TextureArrays::Bind()
+{
+	for (size_t index = 0; index < m_arrays.size(); index++)
+	{
+		StateCache::ActiveTexture(static_cast<GLuint>(index));
+		StateCache::BindTextureArray(m_arrays[index].texture);
+	}
+}
+
+/***********************************************************
+ *  CopyLayer()
+ *
+ *  This method is used for copying a texture of the array
+ *  size into a layer on the GPU. Compressed textures bring
+ *  every mip level, uncompressed ones only the first, the
+ *  rest is generated for the whole array.
+ ***********************************************************/
+void TextureArrays::CopyLayer(GLuint texture, const TEXTURE_ARRAY& textureArray, int layer)
+{
+	GLint compressed = GL_FALSE;
+	StateCache::ActiveTexture(TextureLoader::UPLOAD_TEXTURE_UNIT);
+	StateCache::BindTexture2D(texture);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+
+	int levels = (compressed == GL_TRUE) ? textureArray.levels : 1;
+	int width = textureArray.width;
+	int height = textureArray.height;
+	for (int level = 0; level < levels; level++)
+	{
+		glCopyImageSubData(texture, GL_TEXTURE_2D, level, 0, 0, 0,
+			textureArray.texture, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1);
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+}
+
+/***********************************************************
+ *  ResampleLayer()
+ *
+ *  This method is used for reading a texture of another
+ *  size back, resizing it to the array size and writing it
+ *  into a layer. Layers of compressed arrays are compressed
+ *  again with their whole mip chain, which only works for
+ *  the formats the texture compressor writes.
+ ***********************************************************/
+bool TextureArrays::ResampleLayer(GLuint texture, const TEXTURE_ARRAY& textureArray, int layer)
+{
+	TRACE_ZONE("ResampleTextureLayer");
+	GLint width = 0;
+	GLint height = 0;
+	StateCache::ActiveTexture(TextureLoader::UPLOAD_TEXTURE_UNIT);
+	StateCache::BindTexture2D(texture);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+	if ((width <= 0) || (height <= 0))
+	{
+		return false;
+	}
+
+	std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 4);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	std::vector<unsigned char> resampled;
+	Resample(pixels, width, height, resampled, textureArray.width, textureArray.height);
+
+	StateCache::BindTextureArray(textureArray.texture);
+	GLint compressed = GL_FALSE;
+	glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_COMPRESSED, &compressed);
+	if (compressed == GL_FALSE)
+	{
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, textureArray.width, textureArray.height, 1,
+			GL_RGBA, GL_UNSIGNED_BYTE, resampled.data());
+		return true;
+	}
+
+	TextureCompressor::COMPRESSED_IMAGE image;
+	if (TextureCompressor::Compress(resampled.data(), textureArray.width, textureArray.height, 4,
+		textureArray.internalFormat, image) == false)
+	{
+		return false;
+	}
+	for (int level = 0; (level < textureArray.levels) && (level < static_cast<int>(image.levels.size())); level++)
+	{
+		const TextureCompressor::MIP_LEVEL& mip = image.levels[level];
+		glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, mip.width, mip.height, 1,
+			image.format, static_cast<GLsizei>(mip.size), image.data.data() + mip.offset);
+	}
+	return true;
+}
+
+/***********************************************************
+ *  MeasureArray()
+ *
+ *  This method is used for adding up the GPU bytes of every
+ *  mip level of an array, all layers included. Uncompressed
+ *  texels are counted as four bytes.
+ ***********************************************************/
+size_t TextureArrays::MeasureArray(const TEXTURE_ARRAY& textureArray)
+{
+	StateCache::ActiveTexture(TextureLoader::UPLOAD_TEXTURE_UNIT);
+	StateCache::BindTextureArray(textureArray.texture);
+
+	GLint compressed = GL_FALSE;
+	glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_COMPRESSED, &compressed);
+
+	size_t bytes = 0;
+	for (int level = 0; level < textureArray.levels; level++)
+	{
+		if (compressed == GL_TRUE)
+		{
+			GLint levelSize = 0;
+			glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &levelSize);
+			bytes += static_cast<size_t>(levelSize);
+		}
+		else
+		{
+			bytes += static_cast<size_t>(std::max(1, textureArray.width >> level)) *
+				std::max(1, textureArray.height >> level) * textureArray.layers * 4;
+		}
+	}
+
+	return bytes;
+}
@@ -0,0 +1,67 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearrays.h
+// ============
+// pack the scene textures into layers of a few 2D array textures
+//
+//  The course program samples one texture unit per texture, which limits
+//  the scene to the units it has and needs a sampler change whenever the
+//  texture changes. Here every texture becomes a layer of an array texture
+//  of its format, with textures of another size resampled to the size most
+//  of them share. A layer table gives the array and layer of each texture
+//  slot, so a program can pick the texture per object out of one or two
+//  arrays that stay bound for the whole frame.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <vector>
+
+class TextureArrays
+{
+public:
+	// constructor
+	TextureArrays();
+	// destructor
+	~TextureArrays();
+
+	// pack the textures, indexed by texture slot, into at most maxArrays arrays
+	bool Build(const std::vector<GLuint>& textures, int maxArrays);
+	// free the arrays and the layer table
+	void Destroy();
+	// bind array N on texture unit N
+	void Bind();
+
+	// number of arrays the textures are packed into
+	int GetArrayCount() const { return static_cast<int>(m_arrays.size()); }
+	// storage buffer with the array index and layer of each texture slot
+	GLuint GetLayerTable() const { return m_layerTableBuffer; }
+	// GPU bytes of all arrays with their mip levels
+	size_t GetBytes() const { return m_bytes; }
+
+private:
+	// one array texture, all layers share its format, size and mip levels
+	struct TEXTURE_ARRAY
+	{
+		GLuint texture;
+		GLenum internalFormat;
+		int width;
+		int height;
+		int levels;
+		int layers;
+	};
+
+	// copy every mip level of a texture of the array size into a layer
+	void CopyLayer(GLuint texture, const TEXTURE_ARRAY& textureArray, int layer);
+	// resample a texture of another size into a layer, false when the
+	// format cannot be written from the CPU
+	bool ResampleLayer(GLuint texture, const TEXTURE_ARRAY& textureArray, int layer);
+	// GPU bytes of every mip level of an array
+	static size_t MeasureArray(const TEXTURE_ARRAY& textureArray);
+
+	std::vector<TEXTURE_ARRAY> m_arrays;
+	GLuint m_layerTableBuffer;
+	size_t m_bytes;
+};
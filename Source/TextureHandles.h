@@ -0,0 +1,44 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturehandles.h
+// ============
+// bindless handles of the scene textures, in a storage buffer table
+//
+//  With ARB_bindless_texture a shader can sample a texture from its 64-bit
+//  handle instead of a texture unit. The handles of every texture slot are
+//  made resident once and stored in a handle table, so drawing with a
+//  texture needs neither a bind nor a sampler uniform. A texture with a
+//  handle can no longer change its image or parameters, so the textures
+//  have to be fully loaded first.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+class TextureHandles
+{
+public:
+	// constructor
+	TextureHandles();
+	// destructor
+	~TextureHandles();
+
+	// true when the driver supports bindless textures
+	static bool IsSupported();
+
+	// make the handles of the textures, indexed by texture slot, resident
+	bool Build(const std::vector<GLuint>& textures);
+	// make the handles non-resident and free the handle table
+	void Destroy();
+	// true between Build() and Destroy()
+	bool IsBuilt() const { return m_handleTableBuffer != 0; }
+
+	// storage buffer with the 64-bit handle of each texture slot
+	GLuint GetHandleTable() const { return m_handleTableBuffer; }
+
+private:
+	std::vector<GLuint64> m_handles;
+	GLuint m_handleTableBuffer;
+};
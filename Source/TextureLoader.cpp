@@ -0,0 +1,486 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.cpp
+// ============
+// decode texture images on worker threads and upload them a few per frame
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureLoader.h"
+#include "StateCache.h"
+#include "Trace.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// decoding threads used when the core count is unknown, and the most used
+	const int DEFAULT_DECODER_THREADS = 2;
+	const int MAX_DECODER_THREADS = 8;
+	// mid grey, drawn until the image arrives
+	const unsigned char g_PlaceholderTexel[4] = { 128, 128, 128, 255 };
+}
+
+/***********************************************************
+ *  TextureLoader()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureLoader::TextureLoader()
+{
+	m_bStopDecoders = false;
+	m_pendingImages = 0;
+	m_lastSerial = 0;
+	m_uploadBuffer = 0;
+	m_bCompress = true;
+	m_compressedFormat = 0;
+}
+
+/***********************************************************
+ *  ~TextureLoader()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureLoader::~TextureLoader()
+{
+	{
+		// images nobody waits for any more are not decoded
+		std::lock_guard<std::mutex> lock(m_jobsMutex);
+		m_jobs.clear();
+	}
+	StopDecoders();
+
+	for (LOAD_JOB& job : m_decodedJobs)
+	{
+		stbi_image_free(job.pixels);
+	}
+	if (m_uploadBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_uploadBuffer);
+	}
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for giving the texture a one texel
+ *  placeholder, with repeat wrapping and linear filtering,
+ *  and queueing its image file for the decoding threads.
+ *  Loading a texture again outdates its earlier load.
+ ***********************************************************/
+void TextureLoader::Load(const char* filename, GLuint texture)
+{
+	StateCache::ActiveTexture(UPLOAD_TEXTURE_UNIT);
+	StateCache::BindTexture2D(texture);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, g_PlaceholderTexel);
+
+	if (m_decoders.empty() == true)
+	{
+		if (m_pendingImages == 0)
+		{
+			m_compressedFormat = (m_bCompress == true) ? TextureCompressor::ChooseFormat() : 0;
+		}
+		int decoderThreads = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+		if (decoderThreads < 1)
+		{
+			decoderThreads = DEFAULT_DECODER_THREADS;
+		}
+		StartDecoders(std::min(decoderThreads, MAX_DECODER_THREADS));
+	}
+
+	LOAD_JOB job;
+	job.filename = filename;
+	job.texture = texture;
+	job.serial = ++m_lastSerial;
+	job.pixels = NULL;
+	job.width = 0;
+	job.height = 0;
+	job.channels = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_jobsMutex);
+		m_jobs.push_back(std::move(job));
+	}
+	m_jobsChanged.notify_all();
+	m_pendingImages++;
+	m_loadSerials[texture] = m_lastSerial;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for uploading the images decoded so
+ *  far, until the passed in number of bytes was uploaded.
+ *  The first image is always uploaded, however large, so
+ *  every call makes progress. Images of cancelled or
+ *  outdated loads are dropped. The decoding threads stop
+ *  once the last image is in.
+ ***********************************************************/
+void TextureLoader::Update(size_t byteBudget)
+{
+	if (m_pendingImages == 0)
+	{
+		return;
+	}
+
+	size_t uploadedBytes = 0;
+	while (uploadedBytes < byteBudget)
+	{
+		LOAD_JOB job;
+		{
+			std::lock_guard<std::mutex> lock(m_jobsMutex);
+			if (m_decodedJobs.empty() == true)
+			{
+				break;
+			}
+			job = std::move(m_decodedJobs.front());
+			m_decodedJobs.pop_front();
+		}
+		m_pendingImages--;
+
+		std::unordered_map<GLuint, uint64_t>::iterator serial = m_loadSerials.find(job.texture);
+		if ((serial == m_loadSerials.end()) || (serial->second != job.serial))
+		{
+			stbi_image_free(job.pixels);
+			continue;
+		}
+		m_loadSerials.erase(serial);
+
+		if (job.compressed.levels.empty() == false)
+		{
+			uploadedBytes += UploadCompressed(job);
+		}
+		else
+		{
+			uploadedBytes += Upload(job);
+		}
+		m_uploadedTextures.push_back(job.texture);
+	}
+
+	if (m_pendingImages == 0)
+	{
+		StopDecoders();
+	}
+}
+
+/***********************************************************
+ *  Finish()
+ *
+ *  This method is used for waiting until every queued image
+ *  is decoded and uploaded, for renders that must not show
+ *  a placeholder.
+ ***********************************************************/
+void TextureLoader::Finish()
+{
+	TRACE_ZONE("FinishTextureLoads");
+	while (m_pendingImages > 0)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_jobsMutex);
+			m_jobsChanged.wait(lock, [this]() { return m_decodedJobs.empty() == false; });
+		}
+		Update(static_cast<size_t>(-1));
+	}
+}
+
+/***********************************************************
+ *  Cancel()
+ *
+ *  This method is used for dropping the queued image of a
+ *  texture that is about to be deleted. An image a thread
+ *  is decoding right now is dropped when it arrives.
+ ***********************************************************/
+void TextureLoader::Cancel(GLuint texture)
+{
+	if (m_loadSerials.erase(texture) == 0)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_jobsMutex);
+		size_t queuedJobs = m_jobs.size();
+		m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(),
+			[texture](const LOAD_JOB& job) { return job.texture == texture; }), m_jobs.end());
+		m_pendingImages -= static_cast<int>(queuedJobs - m_jobs.size());
+	}
+
+	if (m_pendingImages == 0)
+	{
+		StopDecoders();
+	}
+}
+
+/***********************************************************
+ *  TakeUploaded()
+ *
+ *  This method is used for moving out the textures whose
+ *  image was uploaded since the last call, including those
+ *  whose file could not be read and keep the placeholder.
+ ***********************************************************/
+void TextureLoader::TakeUploaded(std::vector<GLuint>& textures)
+{
+	textures.insert(textures.end(), m_uploadedTextures.begin(), m_uploadedTextures.end());
+	m_uploadedTextures.clear();
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for copying a decoded image into the
+ *  pixel buffer, specifying its texture from there and
+ *  generating the mipmaps. The number of uploaded bytes is
+ *  returned.
+ ***********************************************************/
+size_t TextureLoader::Upload(LOAD_JOB& job)
+{
+	TRACE_ZONE("UploadTexture");
+	if (job.pixels == NULL)
+	{
+		std::cout << "Could not load image:" << job.filename << std::endl;
+		return 0;
+	}
+
+	GLenum format = GL_RGB;
+	GLint internalFormat = GL_RGB8;
+	// if the loaded image is in RGBA format - it supports transparency
+	if (job.channels == 4)
+	{
+		format = GL_RGBA;
+		internalFormat = GL_RGBA8;
+	}
+	else if (job.channels != 3)
+	{
+		std::cout << "Not implemented to handle image with " << job.channels << " channels" << std::endl;
+		stbi_image_free(job.pixels);
+		return 0;
+	}
+	std::cout << "Successfully loaded image:" << job.filename << ", width:" << job.width << ", height:" << job.height << ", channels:" << job.channels << std::endl;
+
+	size_t bytes = static_cast<size_t>(job.width) * job.height * job.channels;
+	bool bFilled = FillUploadBuffer(job.pixels, bytes);
+	stbi_image_free(job.pixels);
+	job.pixels = NULL;
+	if (bFilled == false)
+	{
+		std::cout << "Could not upload image:" << job.filename << std::endl;
+		return 0;
+	}
+
+	StateCache::ActiveTexture(UPLOAD_TEXTURE_UNIT);
+	StateCache::BindTexture2D(job.texture);
+	// rows of RGB images are not padded to 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, job.width, job.height, 0, format, GL_UNSIGNED_BYTE, NULL);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	// generate the texture mipmaps for mapping textures to lower resolutions
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	return bytes;
+}
+
+/***********************************************************
+ *  UploadCompressed()
+ *
+ *  This method is used for copying a compressed image into
+ *  the pixel buffer and specifying every mip level of its
+ *  texture from there, so no mipmaps are generated. The
+ *  number of uploaded bytes is returned.
+ ***********************************************************/
+size_t TextureLoader::UploadCompressed(LOAD_JOB& job)
+{
+	TRACE_ZONE("UploadCompressedTexture");
+	const TextureCompressor::COMPRESSED_IMAGE& image = job.compressed;
+	if (FillUploadBuffer(image.data.data(), image.data.size()) == false)
+	{
+		std::cout << "Could not upload image:" << job.filename << std::endl;
+		return 0;
+	}
+	std::cout << "Successfully loaded image:" << job.filename << ", width:" << image.width << ", height:" << image.height
+		<< ", format:" << TextureCompressor::GetFormatName(image.format) << ", levels:" << image.levels.size() << std::endl;
+
+	StateCache::ActiveTexture(UPLOAD_TEXTURE_UNIT);
+	StateCache::BindTexture2D(job.texture);
+	for (size_t level = 0; level < image.levels.size(); level++)
+	{
+		const TextureCompressor::MIP_LEVEL& mip = image.levels[level];
+		glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), image.format, mip.width, mip.height, 0,
+			static_cast<GLsizei>(mip.size), reinterpret_cast<const void*>(mip.offset));
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.levels.size()) - 1);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	size_t bytes = image.data.size();
+	job.compressed = TextureCompressor::COMPRESSED_IMAGE();
+	return bytes;
+}
+
+/***********************************************************
+ *  FillUploadBuffer()
+ *
+ *  This method is used for copying the bytes of an upload
+ *  into the pixel buffer. The buffer gets a fresh store each
+ *  time, so the copy never waits for the last upload. The
+ *  buffer stays bound for the texture calls that read it.
+ ***********************************************************/
+bool TextureLoader::FillUploadBuffer(const unsigned char* data, size_t bytes)
+{
+	if (m_uploadBuffer == 0)
+	{
+		glGenBuffers(1, &m_uploadBuffer);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(bytes), NULL, GL_STREAM_DRAW);
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes),
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	bool bFilled = false;
+	if (mapped != NULL)
+	{
+		std::memcpy(mapped, data, bytes);
+		// the store can be lost while mapped, then the copy has to be dropped
+		bFilled = (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE);
+	}
+	if (bFilled == false)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	return bFilled;
+}
+
+/***********************************************************
+ *  StartDecoders()
+ *
+ *  This method is used for starting the image decoding
+ *  threads.
+ ***********************************************************/
+void TextureLoader::StartDecoders(int threadCount)
+{
+	// indicate to always flip images vertically when loaded, set
+	// before the threads start as stb_image keeps it in a global
+	stbi_set_flip_vertically_on_load(true);
+
+	m_bStopDecoders = false;
+	for (int i = 0; i < threadCount; i++)
+	{
+		m_decoders.emplace_back(&TextureLoader::DecodeJobs, this);
+	}
+}
+
+/***********************************************************
+ *  StopDecoders()
+ *
+ *  This method is used for letting the decoding threads
+ *  finish the queued files and waiting for them to exit.
+ ***********************************************************/
+void TextureLoader::StopDecoders()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_jobsMutex);
+		m_bStopDecoders = true;
+	}
+	m_jobsChanged.notify_all();
+
+	for (std::thread& decoder : m_decoders)
+	{
+		decoder.join();
+	}
+	m_decoders.clear();
+}
+
+/***********************************************************
+ *  DecodeJobs()
+ *
+ *  This method is used by each decoding thread for reading
+ *  the queued image files until it is stopped.
+ ***********************************************************/
+void TextureLoader::DecodeJobs()
+{
+	while (true)
+	{
+		LOAD_JOB job;
+		{
+			std::unique_lock<std::mutex> lock(m_jobsMutex);
+			m_jobsChanged.wait(lock, [this]() { return (m_jobs.empty() == false) || m_bStopDecoders; });
+			if (m_jobs.empty() == true)
+			{
+				return;
+			}
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+
+		if (m_compressedFormat != 0)
+		{
+			DecodeCompressed(job);
+		}
+		else
+		{
+			TRACE_ZONE("DecodeTexture");
+			job.pixels = stbi_load(job.filename.c_str(), &job.width, &job.height, &job.channels, 0);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_jobsMutex);
+			m_decodedJobs.push_back(std::move(job));
+		}
+		m_jobsChanged.notify_all();
+	}
+}
+
+/***********************************************************
+ *  DecodeCompressed()
+ *
+ *  This method is used by the decoding threads for reading
+ *  the compressed image of a job from its KTX2 cache. When
+ *  there is no usable cache the image is decoded and
+ *  compressed, and the cache is written for the next run.
+ *  Images that cannot be compressed keep their pixels and
+ *  are uploaded uncompressed.
+ ***********************************************************/
+void TextureLoader::DecodeCompressed(LOAD_JOB& job)
+{
+	std::string cachePath = TextureCompressor::GetCachePath(job.filename, m_compressedFormat);
+	{
+		TRACE_ZONE("ReadTextureCache");
+		if (TextureCompressor::ReadCache(cachePath, job.filename, m_compressedFormat, job.compressed) == true)
+		{
+			return;
+		}
+	}
+
+	{
+		TRACE_ZONE("DecodeTexture");
+		job.pixels = stbi_load(job.filename.c_str(), &job.width, &job.height, &job.channels, 0);
+	}
+	if (job.pixels == NULL)
+	{
+		return;
+	}
+
+	TRACE_ZONE("CompressTexture");
+	if (TextureCompressor::Compress(job.pixels, job.width, job.height, job.channels,
+		m_compressedFormat, job.compressed) == false)
+	{
+		return;
+	}
+	stbi_image_free(job.pixels);
+	job.pixels = NULL;
+
+	if (TextureCompressor::WriteCache(cachePath, job.compressed) == false)
+	{
+		std::cout << "Could not write texture cache:" << cachePath << std::endl;
+	}
+}
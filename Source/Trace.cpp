@@ -0,0 +1,142 @@
+///////////////////////////////////////////////////////////////////////////////
+// trace.cpp
+// ============
+// scoped CPU timing zones exported as a chrome://tracing / Perfetto file
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Trace.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> Trace::g_bEnabled(false);
+
+// declaration of global variables
+namespace
+{
+	// zones kept per thread, older zones are kept when the limit is reached
+	const size_t MAX_ZONES_PER_THREAD = 1 << 20;
+
+	struct TRACE_EVENT
+	{
+		const char* name;
+		std::chrono::steady_clock::time_point start;
+		std::chrono::steady_clock::time_point end;
+	};
+
+	struct THREAD_EVENTS
+	{
+		int threadID;
+		std::vector<TRACE_EVENT> events;
+		size_t droppedEvents;
+	};
+
+	// time that the trace timestamps are measured from
+	const std::chrono::steady_clock::time_point g_TraceStart = std::chrono::steady_clock::now();
+
+	// recordings of every thread that recorded a zone, guarded by the mutex
+	std::mutex g_ThreadsMutex;
+	std::vector<std::unique_ptr<THREAD_EVENTS>> g_Threads;
+
+	// get the recording of the calling thread, creating it on first use
+	THREAD_EVENTS* GetThreadEvents()
+	{
+		thread_local THREAD_EVENTS* pThreadEvents = nullptr;
+		if (pThreadEvents == nullptr)
+		{
+			std::lock_guard<std::mutex> lock(g_ThreadsMutex);
+			g_Threads.emplace_back(new THREAD_EVENTS());
+			pThreadEvents = g_Threads.back().get();
+			pThreadEvents->threadID = static_cast<int>(g_Threads.size());
+			pThreadEvents->droppedEvents = 0;
+			pThreadEvents->events.reserve(4096);
+		}
+		return pThreadEvents;
+	}
+
+	// get the microseconds between the trace start and the passed in time
+	double ToMicroseconds(std::chrono::steady_clock::time_point time)
+	{
+		return std::chrono::duration<double, std::micro>(time - g_TraceStart).count();
+	}
+}
+
+/***********************************************************
+ *  SetEnabled()
+ *
+ *  This function is used for switching the recording of
+ *  zones on or off.
+ ***********************************************************/
+void Trace::SetEnabled(bool bEnable)
+{
+	g_bEnabled = bEnable;
+}
+
+/***********************************************************
+ *  Record()
+ *
+ *  This function is used for adding a finished zone to the
+ *  recording of the calling thread.
+ ***********************************************************/
+void Trace::Record(const char* name, std::chrono::steady_clock::time_point start,
+	std::chrono::steady_clock::time_point end)
+{
+	THREAD_EVENTS* pThreadEvents = GetThreadEvents();
+	if (pThreadEvents->events.size() >= MAX_ZONES_PER_THREAD)
+	{
+		pThreadEvents->droppedEvents++;
+		return;
+	}
+	pThreadEvents->events.push_back({ name, start, end });
+}
+
+/***********************************************************
+ *  WriteChromeTrace()
+ *
+ *  This function is used for writing the recorded zones as
+ *  complete ("X") events in the Chrome trace event format,
+ *  which chrome://tracing and ui.perfetto.dev can open.
+ ***********************************************************/
+bool Trace::WriteChromeTrace(const char* filename)
+{
+	std::ofstream file(filename);
+	if (!file)
+	{
+		std::cout << "Could not write trace file:" << filename << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(g_ThreadsMutex);
+
+	size_t eventCount = 0;
+	size_t droppedEvents = 0;
+	file << std::fixed << std::setprecision(3);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	for (const std::unique_ptr<THREAD_EVENTS>& pThreadEvents : g_Threads)
+	{
+		for (const TRACE_EVENT& event : pThreadEvents->events)
+		{
+			file << (eventCount == 0 ? "\n" : ",\n")
+				<< "{\"name\":\"" << event.name
+				<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << pThreadEvents->threadID
+				<< ",\"ts\":" << ToMicroseconds(event.start)
+				<< ",\"dur\":" << ToMicroseconds(event.end) - ToMicroseconds(event.start) << "}";
+			eventCount++;
+		}
+		droppedEvents += pThreadEvents->droppedEvents;
+	}
+	file << "\n]}" << std::endl;
+
+	std::cout << "INFO: Wrote " << eventCount << " trace zones to " << filename;
+	if (droppedEvents > 0)
+	{
+		std::cout << " (" << droppedEvents << " dropped)";
+	}
+	std::cout << std::endl;
+
+	return true;
+}
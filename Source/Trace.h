@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// trace.h
+// ============
+// scoped CPU timing zones exported as a chrome://tracing / Perfetto file
+//
+//  TRACE_ZONE("Name") times the rest of the enclosing scope. Zones cost one
+//  flag check while tracing is switched off at runtime, and nothing at all
+//  when the program is built with SCENE_TRACE defined to 0. Names must be
+//  string literals, only the pointer is kept.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#ifndef SCENE_TRACE
+#define SCENE_TRACE 1
+#endif
+
+namespace Trace
+{
+	// switch recording on or off while the program runs
+	void SetEnabled(bool bEnable);
+	// write the recorded zones as Chrome trace event JSON
+	bool WriteChromeTrace(const char* filename);
+
+	// true while zones are being recorded
+	extern std::atomic<bool> g_bEnabled;
+
+	// add a finished zone to the recording of the calling thread
+	void Record(const char* name, std::chrono::steady_clock::time_point start,
+		std::chrono::steady_clock::time_point end);
+
+	/***********************************************************
+	 *  Zone
+	 *
+	 *  Records the time between its construction and the end
+	 *  of the scope it was declared in.
+	 ***********************************************************/
+	class Zone
+	{
+	public:
+		explicit Zone(const char* name)
+		{
+			m_name = g_bEnabled.load(std::memory_order_relaxed) ? name : nullptr;
+			if (m_name != nullptr)
+			{
+				m_start = std::chrono::steady_clock::now();
+			}
+		}
+		~Zone()
+		{
+			if (m_name != nullptr)
+			{
+				Record(m_name, m_start, std::chrono::steady_clock::now());
+			}
+		}
+
+		Zone(const Zone&) = delete;
+		Zone& operator=(const Zone&) = delete;
+
+	private:
+		const char* m_name;
+		std::chrono::steady_clock::time_point m_start;
+	};
+}
+
+#if SCENE_TRACE
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_ZONE(name) Trace::Zone TRACE_CONCAT(traceZone, __LINE__)(name)
+#else
+#define TRACE_ZONE(name) ((void)0)
+#endif
@@ -0,0 +1,191 @@
+///////////////////////////////////////////////////////////////////////////////
+// trackedshadermanager.cpp
+// ============
+// shader manager that reports its uniform uploads to the render statistics
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TrackedShaderManager.h"
+#include "RenderStats.h"
+#include "StateCache.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+
+/***********************************************************
+ *  TrackedShaderManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TrackedShaderManager::TrackedShaderManager()
+{
+	m_locationProgram = 0;
+}
+
+/***********************************************************
+ *  use()
+ *
+ *  This method is used for making the shader program
+ *  current. The locations and values kept so far are dropped
+ *  when the program is not the one they belong to.
+ ***********************************************************/
+void TrackedShaderManager::use()
+{
+	// the ShaderManager switches the program without the state cache
+	ShaderManager::use();
+	StateCache::Reset();
+
+	GLuint currentProgram = StateCache::GetProgram();
+	if (currentProgram != m_locationProgram)
+	{
+		m_locations.clear();
+		m_lastValues.clear();
+		m_locationProgram = currentProgram;
+	}
+}
+
+/***********************************************************
+ *  GetLocation()
+ *
+ *  This method is used for finding the location of a
+ *  uniform. Every name is only looked up in OpenGL once per
+ *  program, after that the location comes from the cache.
+ ***********************************************************/
+GLint TrackedShaderManager::GetLocation(const UNIFORM_NAME& name)
+{
+	std::unordered_map<uint64_t, GLint>::const_iterator found = m_locations.find(name.hash);
+	if (found != m_locations.end())
+	{
+		return found->second;
+	}
+
+	// uploads before use() go to whatever program is current
+	if (m_locationProgram == 0)
+	{
+		m_locationProgram = StateCache::GetProgram();
+	}
+
+	GLint location = glGetUniformLocation(m_locationProgram, name.name);
+	m_locations.emplace(name.hash, location);
+	return location;
+}
+
+void TrackedShaderManager::setBoolValue(const UNIFORM_NAME& name, bool value)
+{
+	float cached = value ? 1.0f : 0.0f;
+	if (CountUpload(name, &cached, 1))
+	{
+		return;
+	}
+	glUniform1i(GetLocation(name), value ? 1 : 0);
+}
+
+void TrackedShaderManager::setIntValue(const UNIFORM_NAME& name, int value)
+{
+	float cached = static_cast<float>(value);
+	if (CountUpload(name, &cached, 1))
+	{
+		return;
+	}
+	glUniform1i(GetLocation(name), value);
+}
+
+void TrackedShaderManager::setFloatValue(const UNIFORM_NAME& name, float value)
+{
+	if (CountUpload(name, &value, 1))
+	{
+		return;
+	}
+	glUniform1f(GetLocation(name), value);
+}
+
+void TrackedShaderManager::setSampler2DValue(const UNIFORM_NAME& name, int value)
+{
+	float cached = static_cast<float>(value);
+	if (CountUpload(name, &cached, 1))
+	{
+		return;
+	}
+	glUniform1i(GetLocation(name), value);
+}
+
+void TrackedShaderManager::setVec2Value(const UNIFORM_NAME& name, const glm::vec2& value)
+{
+	if (CountUpload(name, glm::value_ptr(value), 2))
+	{
+		return;
+	}
+	glUniform2fv(GetLocation(name), 1, glm::value_ptr(value));
+}
+
+void TrackedShaderManager::setVec3Value(const UNIFORM_NAME& name, const glm::vec3& value)
+{
+	if (CountUpload(name, glm::value_ptr(value), 3))
+	{
+		return;
+	}
+	glUniform3fv(GetLocation(name), 1, glm::value_ptr(value));
+}
+
+void TrackedShaderManager::setVec3Value(const UNIFORM_NAME& name, float x, float y, float z)
+{
+	setVec3Value(name, glm::vec3(x, y, z));
+}
+
+void TrackedShaderManager::setVec4Value(const UNIFORM_NAME& name, const glm::vec4& value)
+{
+	if (CountUpload(name, glm::value_ptr(value), 4))
+	{
+		return;
+	}
+	glUniform4fv(GetLocation(name), 1, glm::value_ptr(value));
+}
+
+void TrackedShaderManager::setMat4Value(const UNIFORM_NAME& name, const glm::mat4& value)
+{
+	if (CountUpload(name, glm::value_ptr(value), 16))
+	{
+		return;
+	}
+	glUniformMatrix4fv(GetLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+}
+
+/***********************************************************
+ *  CountUpload()
+ *
+ *  This method is used for counting an upload as redundant
+ *  when the uniform already holds the same values, and for
+ *  remembering the values for the next upload. A redundant
+ *  upload is not sent to OpenGL.
+ ***********************************************************/
+bool TrackedShaderManager::CountUpload(const UNIFORM_NAME& name, const float* values, int count)
+{
+	UNIFORM_VALUE& lastValue = m_lastValues[name.hash];
+
+	bool bRedundant = (lastValue.count == count) &&
+		std::equal(values, values + count, lastValue.values);
+	RenderStats::CountUniformUpload(bRedundant);
+
+	std::copy(values, values + count, lastValue.values);
+	lastValue.count = count;
+	return bRedundant;
+}
+
+/***********************************************************
+ *  GetUniformValue()
+ *
+ *  This method is used for reading back what the scene set
+ *  into a uniform, so other renderers can follow the same
+ *  shader settings.
+ ***********************************************************/
+bool TrackedShaderManager::GetUniformValue(const UNIFORM_NAME& name, float* values, int count) const
+{
+	std::unordered_map<uint64_t, UNIFORM_VALUE>::const_iterator found = m_lastValues.find(name.hash);
+	if ((found == m_lastValues.end()) || (found->second.count != count))
+	{
+		return false;
+	}
+
+	std::copy(found->second.values, found->second.values + count, values);
+	return true;
+}
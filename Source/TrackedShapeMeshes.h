@@ -0,0 +1,167 @@
+///////////////////////////////////////////////////////////////////////////////
+// trackedshapemeshes.h
+// ============
+// shape meshes that report their draws to the render statistics
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShapeMeshes.h"
+#include "MeshCapture.h"
+#include "RenderStats.h"
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+class SoftwareRasterizer;
+
+/***********************************************************
+ *  TrackedShapeMeshes
+ *
+ *  The scene draws every basic shape through this class, so
+ *  each Draw*Mesh call can be counted before it is passed on
+ *  to ShapeMeshes. With a software rasterizer attached the
+ *  draws are handed to it instead of OpenGL, and with a
+ *  recorder set they are only reported to the recorder.
+ *
+ *  For instanced and indirect drawing each mesh variant is
+ *  captured once into an indexed copy. All copies share one
+ *  vertex buffer, one index buffer and one VAO, which also
+ *  reads the object index of every instance from the
+ *  instance buffer.
+ *
+ *  For baked drawing the copies of many objects are moved
+ *  into world space and merged into one mesh, which draws
+ *  them all with one call and no per-object uniforms.
+ ***********************************************************/
+class TrackedShapeMeshes : public ShapeMeshes
+{
+public:
+	// one draw of a multi-draw, laid out as OpenGL reads it from the indirect buffer
+	struct DRAW_COMMAND
+	{
+		GLuint indexCount;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// one object of a baked mesh, a mesh variant with its placement
+	struct BAKE_OBJECT
+	{
+		RenderStats::MESH_TYPE meshType;
+		int variant;
+		glm::mat4 model;
+		glm::vec2 uvScale;
+	};
+
+	// most vertices all baked meshes may hold together, 128 MB
+	static const size_t BAKED_VERTEX_LIMIT = 1 << 22;
+
+	// constructor
+	TrackedShapeMeshes();
+	// destructor
+	~TrackedShapeMeshes();
+
+	void DrawBoxMesh();
+	void DrawConeMesh(bool bDrawBottom = true);
+	void DrawCylinderMesh(bool bDrawTop = true, bool bDrawBottom = true, bool bDrawSides = true);
+	void DrawPlaneMesh();
+	void DrawPrismMesh();
+	void DrawPyramid4Mesh();
+	void DrawSphereMesh();
+	void DrawTaperedCylinderMesh(bool bDrawTop = true, bool bDrawBottom = true, bool bDrawSides = true);
+	void DrawTorusMesh();
+	// draw a mesh by type, variant holds the top, bottom and sides flags as bits 0..2
+	void DrawMesh(RenderStats::MESH_TYPE meshType, int variant);
+
+	// send the following draws to the software rasterizer, NULL for OpenGL
+	void SetSoftwareRasterizer(SoftwareRasterizer* pRasterizer) { m_pSoftwareRasterizer = pRasterizer; }
+	// report the following draws to the recorder without drawing, empty to draw again
+	void SetDrawRecorder(const std::function<void(RenderStats::MESH_TYPE, int)>& recorder) { m_recorder = recorder; }
+
+	// capture a mesh variant into the indexed copy the instanced draws use
+	bool PrepareInstancedMesh(RenderStats::MESH_TYPE meshType, int variant);
+	// replace the object index of every instance the instanced draws read
+	void SetInstances(const std::vector<GLuint>& objectIndices);
+	// draw instanceCount instances of a prepared mesh, from firstInstance on
+	void DrawMeshInstanced(RenderStats::MESH_TYPE meshType, int variant, int firstInstance, int instanceCount);
+	// fill in the multi-draw command for instances of a prepared mesh
+	bool GetDrawCommand(RenderStats::MESH_TYPE meshType, int variant, int firstInstance, int instanceCount, DRAW_COMMAND& command) const;
+	// replace the commands the indirect draws read from
+	void SetDrawCommands(const std::vector<DRAW_COMMAND>& commands);
+	// draw commandCount commands with one glMultiDrawElementsIndirect, from firstCommand on
+	void DrawMeshesIndirect(int firstCommand, int commandCount);
+	// free the instanced copies, the instance buffer and the indirect buffer
+	void DestroyInstancedMeshes();
+
+	// merge the objects into one world-space mesh, returns its index or -1
+	// when it does not fit under BAKED_VERTEX_LIMIT
+	int BakeMesh(const std::vector<BAKE_OBJECT>& objects);
+	// draw a baked mesh with the model uniform set to identity
+	void DrawBakedMesh(int bakedMesh);
+	// free the baked meshes
+	void DestroyBakedMeshes();
+
+private:
+	// true when the OpenGL draw has to run, either to render or
+	// so the software rasterizer can capture the mesh the first time
+	bool BeginDraw(RenderStats::MESH_TYPE meshType, int variant);
+	// finish a draw that BeginDraw let through
+	void EndDraw();
+	// run the OpenGL draw of ShapeMeshes for a mesh variant, without counting it
+	void DrawShapeMesh(RenderStats::MESH_TYPE meshType, int variant);
+	// upload the packed meshes again after new ones were added, and bind their VAO
+	void BindPackedMeshes();
+	// upload the baked meshes again after new ones were added, and bind their VAO
+	void BindBakedMeshes();
+
+	// range of a mesh variant in the packed vertex and index buffers
+	struct INSTANCED_MESH
+	{
+		GLsizei vertexCount;
+		GLsizei indexCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+	};
+
+	SoftwareRasterizer* m_pSoftwareRasterizer;
+	std::function<void(RenderStats::MESH_TYPE, int)> m_recorder;
+
+	// instanced copies by mesh type and variant, and the capture that makes them
+	std::unordered_map<int, INSTANCED_MESH> m_instancedMeshes;
+	MeshCapture m_capture;
+	// vertices and indices of every copy, kept to upload them again when one is added
+	std::vector<MeshCapture::MESH_VERTEX> m_packedVertices;
+	std::vector<GLuint> m_packedIndices;
+	// shared buffers of the copies, uploaded when m_bPackedDirty is set
+	GLuint m_packedVertexArray;
+	GLuint m_packedVertexBuffer;
+	GLuint m_packedIndexBuffer;
+	bool m_bPackedDirty;
+	// object index of every instance of the instanced draws
+	GLuint m_instanceBuffer;
+	// DRAW_COMMAND values of the indirect draws, with a copy for counting them
+	GLuint m_indirectBuffer;
+	std::vector<DRAW_COMMAND> m_drawCommands;
+
+	// range of a baked mesh in the baked index buffer, and the objects it holds
+	struct BAKED_MESH
+	{
+		GLsizei indexCount;
+		GLuint firstIndex;
+		int objectCount;
+	};
+
+	// baked meshes in world space, their vertices and indices kept like the
+	// packed ones, and the buffers they are drawn from
+	std::vector<BAKED_MESH> m_bakedMeshes;
+	std::vector<MeshCapture::MESH_VERTEX> m_bakedVertices;
+	std::vector<GLuint> m_bakedIndices;
+	GLuint m_bakedVertexArray;
+	GLuint m_bakedVertexBuffer;
+	GLuint m_bakedIndexBuffer;
+	bool m_bBakedDirty;
+};
@@ -0,0 +1,216 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformblocks.cpp
+// ============
+// std140 uniform buffers of the camera and the lights, shared by the programs
+///////////////////////////////////////////////////////////////////////////////
+
+#include "UniformBlocks.h"
+#include "RenderStats.h"
+
+// declaration of global variables
+namespace
+{
+	// room for the camera blocks of one frame, a frame normally writes
+	// one, aligned to at most 256 bytes
+	const GLsizeiptr CAMERA_RING_FRAME_BYTES = 4 << 10;
+
+	// block declarations matching CAMERA_BLOCK and LIGHT_BLOCK
+	const char* g_BlockSource =
+		"struct LightSource\n"
+		"{\n"
+		"	vec3 position;\n"
+		"	float focalStrength;\n"
+		"	vec3 ambientColor;\n"
+		"	float specularIntensity;\n"
+		"	vec3 diffuseColor;\n"
+		"	vec3 specularColor;\n"
+		"};\n"
+		"layout (std140) uniform CameraBlock\n"
+		"{\n"
+		"	mat4 view;\n"
+		"	mat4 projection;\n"
+		"	vec4 viewPosition;\n"
+		"};\n"
+		"layout (std140) uniform LightBlock\n"
+		"{\n"
+		"	LightSource lightSources[5];\n"
+		"	bool bUseLighting;\n"
+		"};\n";
+}
+
+/***********************************************************
+ *  UniformBlocks()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+UniformBlocks::UniformBlocks()
+{
+	m_cameraBuffer = 0;
+	m_lightBuffer = 0;
+	m_uniformAlignment = 0;
+}
+
+/***********************************************************
+ *  ~UniformBlocks()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+UniformBlocks::~UniformBlocks()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the block buffers.
+ ***********************************************************/
+void UniformBlocks::Destroy()
+{
+	if (m_cameraBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_cameraBuffer);
+		m_cameraBuffer = 0;
+	}
+	if (m_lightBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_lightBuffer);
+		m_lightBuffer = 0;
+	}
+	m_cameraRing.Destroy();
+	m_uniformAlignment = 0;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting a frame of camera
+ *  writes. The ring region of the last frame is fenced and
+ *  the next region is waited for if the GPU still reads it.
+ ***********************************************************/
+void UniformBlocks::BeginFrame()
+{
+	m_cameraRing.BeginFrame();
+}
+
+/***********************************************************
+ *  CreateBlockBuffer()
+ *
+ *  This method is used for creating the buffer of a block
+ *  and binding it to its binding point. The binding stays
+ *  for the life of the buffer, so it is only made once.
+ ***********************************************************/
+GLuint UniformBlocks::CreateBlockBuffer(GLuint binding, GLsizeiptr size)
+{
+	GLuint buffer = 0;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+	return buffer;
+}
+
+/***********************************************************
+ *  SetCamera()
+ *
+ *  This method is used for writing the view, projection
+ *  and camera position into the camera block.
+ ***********************************************************/
+void UniformBlocks::SetCamera(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPosition)
+{
+	static_assert(sizeof(CAMERA_BLOCK) == 144, "CAMERA_BLOCK must match the std140 layout");
+	if ((m_uniformAlignment == 0) && (RingBuffer::IsSupported() == true))
+	{
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_uniformAlignment);
+		m_cameraRing.Create(CAMERA_RING_FRAME_BYTES);
+	}
+
+	CAMERA_BLOCK block;
+	block.view = view;
+	block.projection = projection;
+	block.viewPosition = glm::vec4(viewPosition, 1.0f);
+
+	RenderStats::CountUniformBlockWrite();
+
+	// write the block straight into the mapped ring and point the binding at it
+	GLintptr offset = 0;
+	void* pBlock = m_cameraRing.Allocate(sizeof(block), m_uniformAlignment, offset);
+	if (pBlock != NULL)
+	{
+		*static_cast<CAMERA_BLOCK*>(pBlock) = block;
+		glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_BINDING, m_cameraRing.GetBuffer(), offset, sizeof(block));
+		return;
+	}
+
+	// without a ring, or when its region is full, the block is a plain buffer
+	if (m_cameraBuffer == 0)
+	{
+		m_cameraBuffer = CreateBlockBuffer(CAMERA_BINDING, sizeof(CAMERA_BLOCK));
+	}
+	glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BINDING, m_cameraBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_cameraBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/***********************************************************
+ *  SetLights()
+ *
+ *  This method is used for writing the lights and the
+ *  lighting switch into the light block. Lights past the
+ *  passed in count are written as black.
+ ***********************************************************/
+void UniformBlocks::SetLights(const LIGHT_SOURCE* pLights, int lightCount, bool bUseLighting)
+{
+	static_assert(sizeof(LIGHT_SOURCE) == 64, "LIGHT_SOURCE must match the std140 layout");
+	static_assert(sizeof(LIGHT_BLOCK) == TOTAL_LIGHTS * 64 + 16, "LIGHT_BLOCK must match the std140 layout");
+	if (m_lightBuffer == 0)
+	{
+		m_lightBuffer = CreateBlockBuffer(LIGHT_BINDING, sizeof(LIGHT_BLOCK));
+	}
+
+	LIGHT_BLOCK block = {};
+	for (int light = 0; (light < lightCount) && (light < TOTAL_LIGHTS); light++)
+	{
+		block.lightSources[light] = pLights[light];
+	}
+	block.bUseLighting = bUseLighting ? 1 : 0;
+
+	RenderStats::CountUniformBlockWrite();
+	glBindBuffer(GL_UNIFORM_BUFFER, m_lightBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/***********************************************************
+ *  BindProgramBlocks()
+ *
+ *  This method is used for pointing the blocks of a linked
+ *  program at the shared binding points.
+ ***********************************************************/
+void UniformBlocks::BindProgramBlocks(GLuint programID)
+{
+	GLuint cameraIndex = glGetUniformBlockIndex(programID, "CameraBlock");
+	if (cameraIndex != GL_INVALID_INDEX)
+	{
+		glUniformBlockBinding(programID, cameraIndex, CAMERA_BINDING);
+	}
+	GLuint lightIndex = glGetUniformBlockIndex(programID, "LightBlock");
+	if (lightIndex != GL_INVALID_INDEX)
+	{
+		glUniformBlockBinding(programID, lightIndex, LIGHT_BINDING);
+	}
+}
+
+/***********************************************************
+ *  GetBlockSource()
+ *
+ *  This method is used for getting the GLSL declarations
+ *  of the blocks, which go between the version line and
+ *  the body of a shader.
+ ***********************************************************/
+const char* UniformBlocks::GetBlockSource()
+{
+	return g_BlockSource;
+}
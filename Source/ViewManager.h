@@ -9,7 +9,8 @@
 
 #pragma once
 
-#include "ShaderManager.h"
+#include "TrackedShaderManager.h"
+#include "OffscreenTarget.h"
 #include "camera.h"
 
 // GLFW library
@@ -20,7 +21,7 @@ class ViewManager
 public:
 	// constructor
 	ViewManager(
-		ShaderManager* pShaderManager);
+		TrackedShaderManager* pShaderManager);
 	// destructor
 	~ViewManager();
 
@@ -31,6 +32,11 @@ public:
 	// mouse scroll callback for mouse scroll interaction with the 3D scene - makes movements fast/slow
 	static void Mouse_Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset);
 
+	// key, resize and refresh callbacks that mark the scene for redrawing
+	static void Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+	static void Framebuffer_Size_Callback(GLFWwindow* window, int width, int height);
+	static void Window_Refresh_Callback(GLFWwindow* window);
+
 	// Methods for setting projection types
 	void SetPerspective(); // Default Perspective
 	void SetOrthographic(); // Set Orthographic Projection
@@ -39,9 +45,11 @@ public:
 //*******************************************************************************************************************************************************************************
 private:
 	// pointer to shader manager object
-	ShaderManager* m_pShaderManager;
+	TrackedShaderManager* m_pShaderManager;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// framebuffer rendered into when there is no display
+	OffscreenTarget* m_pOffscreenTarget;
 
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
@@ -54,9 +62,28 @@ private:
 public:
 	// create the initial OpenGL display window
 	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+
+	// create a framebuffer the size of the display window and render into it
+	bool CreateOffscreenTarget();
+	// get the framebuffer rendered into, NULL when rendering to the window
+	OffscreenTarget* GetOffscreenTarget() const { return m_pOffscreenTarget; }
 	
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+
+	// place the camera directly, used by scripted camera playback
+	void SetCameraPose(const glm::vec3& position, const glm::vec3& front, float zoom);
+	// true while the orthographic projection is active
+	bool IsOrthographic() const;
+	// advance the frame time by a fixed step in seconds, 0 uses the real clock
+	void SetFixedTimeStep(float timeStep);
+	// turn the keyboard and mouse camera controls on or off
+	void EnableUserInput(bool bEnable);
+
+	// true when the camera, projection or window changed since the last frame
+	bool IsSceneChanged() const;
+	// restart the frame timing after the loop was idle
+	void ResetFrameTime();
 };
 //*******************************************************************************************************************************************************************************
 //*******************************************************************************************************************************************************************************
\ No newline at end of file